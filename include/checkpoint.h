@@ -0,0 +1,26 @@
+/**
+ * @file checkpoint.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Checkpoint interface
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+/// Name of the checkpoint files, without the extension
+#define CHECKPOINT_NAME "checkpoint"
+
+/// Extension of the checkpoint journal
+#define CHECKPOINT_EXT "golj"
+
+extern int checkpoint_gens;
+extern int checkpoint_secs;
+
+void checkpoint_start(void);
+void checkpoint_tick(void);
+void checkpoint_stop(void);
+int  checkpoint_exists(void);
+void checkpoint_resume(char *pass, int index);
+
+#endif
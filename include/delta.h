@@ -0,0 +1,38 @@
+/**
+ * @file delta.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Cell change encoding interface
+ */
+
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "logic.h"
+
+/**
+ * @brief Buffer of encoded cell changes
+ */
+typedef struct delta_T {
+  uint8_t *data;     ///< encoded changes
+  size_t   size;     ///< number of bytes used
+  size_t   capacity; ///< number of bytes allocated
+  int64_t  row;      ///< row of the last encoded change
+  int64_t  col;      ///< column of the last encoded change
+} delta_T;
+
+typedef void (*delta_change_f)(int64_t row, int64_t col, int val);
+
+int  delta_cmp(const void *a, const void *b);
+void delta_sort(coord_val *cells, size_t size);
+void delta_begin(delta_T *delta);
+void delta_push(delta_T *delta, const coord_val *cell);
+void delta_shrink(delta_T *delta);
+void delta_free(delta_T *delta);
+int  delta_apply(const uint8_t *data, size_t size);
+int  delta_decode(const uint8_t *data, size_t size, delta_change_f change);
+
+#endif
@@ -8,6 +8,7 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
+#include "logic.h"
 #include "window.h"
 
 #ifdef _WIN32
@@ -22,6 +23,15 @@
   { handle_winch(10); }
 #endif
 
+/// Colour pair of the dead cells, followed by a pair for each cell state
+#define PAIR_CELL 2
+
+/// Colour pairs of the cell states under the cursor
+#define PAIR_CURSOR (PAIR_CELL + STATES_MAX)
+
+/// Colour pairs of the cell states in the visual selection
+#define PAIR_SELECT (PAIR_CURSOR + STATES_MAX)
+
 /// Character representing dead cell
 #define CHAR_BLANK "  "
 
@@ -53,6 +63,9 @@ extern mmask_t  mbitmask;
 
 typedef int (*input_f)(int);
 
+/// Function that draws a preview of data in the h x w area at (y, x)
+typedef void (*preview_f)(WINDOW *win, int y, int x, int h, int w, void *data);
+
 /**
  * @brief A item in a menu
  *
@@ -60,7 +73,9 @@ typedef int (*input_f)(int);
  */
 struct menu_T {
   void (*callback)(char *, int); ///< function called when item is selected
-  char *name;                    ///< name of the menu item
+  char     *name;                ///< name of the menu item
+  preview_f preview;             ///< function that previews the item or NULL
+  void     *data;                ///< data passed to the preview function
 };
 
 /**
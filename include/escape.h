@@ -0,0 +1,15 @@
+/**
+ * @file escape.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Removal of escaping spaceships
+ */
+
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include "gol.h"
+
+void escape_remove(gol_universe *u);
+
+#endif
@@ -0,0 +1,13 @@
+/**
+ * @file export.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Frame export interface
+ */
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+int export_main(int argc, char *argv[]);
+
+#endif
@@ -9,15 +9,21 @@
 #define FILE_H
 
 #include "display.h"
+#include "format.h"
+#include "library.h"
 
-void  file_setup(void);
+void file_setup(void);
 void load_files(void);
 void free_files(void);
-int  file_select_extension(char *ext, char ***buffer);
+int  file_select_extension(char *ext, library_T ***buffer);
+int  file_read(char *name, cells_T *cells);
 
 void file_load_pattern(char *name, int index);
 void file_save_pattern(char *name, int index);
 void file_load(char *name, int index);
 void file_save(char *name, int index);
+void file_save_wait(void);
+int  file_save_progress(void);
+int  file_save_refused(void);
 
 #endif
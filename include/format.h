@@ -0,0 +1,61 @@
+/**
+ * @file format.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Pattern file formats interface
+ */
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "logic.h"
+
+/**
+ * @brief Supported pattern file formats, in the order of format_ext
+ */
+enum format_T {
+  FORMAT_RLE,   ///< Run Length Encoded, .rle
+  FORMAT_CELLS, ///< Plaintext, .cells
+  FORMAT_LIF,   ///< Life 1.06, .lif
+  FORMAT_LIFE,  ///< Life 1.06, .life
+  FORMAT_MC,    ///< Macrocell, .mc
+  FORMAT_NONE,  ///< Not a supported format
+};
+
+/// Number of cells written between the calls of format_progress_f
+#define FORMAT_PROGRESS_STEP 4096
+
+/// Maximum number of characters of a Plaintext bounding box that is written
+#define FORMAT_CELLS_MAX (1 << 26)
+
+/**
+ * @brief Called with the number of cells written so far while a large file is
+ * being written, to report its progress
+ */
+typedef void (*format_progress_f)(size_t done);
+
+/**
+ * @brief A growing buffer of packed cells read from a pattern file
+ */
+typedef struct cells_T {
+  coord_val *cells;    ///< packed cells
+  int        size;     ///< number of cells in the buffer
+  int        capacity; ///< number of cells that fit in the buffer
+  int        rule;     ///< index of the game mode, -1 if not specified
+} cells_T;
+
+extern char *format_ext[];
+
+int  format_from_name(char *name);
+int  format_rule(char *rule);
+void cells_push(cells_T *self, int64_t row, int64_t col, int val);
+void cells_free(cells_T *self);
+void format_read(FILE *f, int format, cells_T *cells);
+int  format_supports(int format, coord_val *cells, int size);
+int  format_write(FILE *f, int format, coord_val *cells, int size, int rule,
+                  format_progress_f progress);
+
+#endif
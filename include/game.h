@@ -10,8 +10,10 @@
 
 #include "window.h"
 
-extern int width, height;
+extern int      width, height;
+extern unsigned gen;
+extern int      page_budget;
 
-void game(int s_h, int s_w, int mode_index);
+void game(int s_h, int s_w, int mode_index, unsigned start_gen);
 
 #endif
@@ -0,0 +1,139 @@
+/**
+ * @file gol.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Game of Life library interface
+ *
+ * libgol is the game engine without the terminal interface. Each universe is
+ * independent of the others, with its own cells, size, game mode and random
+ * number generator, so any number of them can be used in one process, and
+ * different universes can be used from different threads at the same time.
+ * Coordinates are 64-bit, so patterns of an unlimited universe can travel for
+ * a very long time before they run out of room.
+ * Many universes can be evolved at once on a work stealing thread pool, and
+ * the objects of a universe can be split apart and classified. Spaceships
+ * flying away from an unlimited universe can be counted and removed.
+ * Universes larger than the memory can page their cold still lifes out to a
+ * file, and the memory each universe uses can be accounted for.
+ */
+
+#ifndef GOL_H
+#define GOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Marks the functions exported by the shared libgol, that hides the rest
+#ifdef _WIN32
+#define GOL_API
+#else
+#define GOL_API __attribute__((visibility("default")))
+#endif
+
+/**
+ * @brief Opaque handle of a universe
+ */
+typedef struct gol_universe gol_universe;
+
+/**
+ * @brief Kind of an object found by gol_classify()
+ */
+enum gol_kind { GOL_STILL_LIFE, GOL_OSCILLATOR, GOL_SPACESHIP, GOL_UNKNOWN };
+
+/**
+ * @brief Task run by gol_parallel() for each index
+ */
+typedef void (*gol_task_f)(size_t index, void *arg);
+
+/**
+ * @brief Cell value with its coordinates
+ */
+typedef struct gol_cell {
+  int64_t       row;
+  int64_t       col;
+  unsigned char val;
+} gol_cell;
+
+/**
+ * @brief Spaceships of one kind and direction removed by gol_escape()
+ */
+typedef struct gol_escaped {
+  const char *name;  ///< name of the spaceship
+  int         drow;  ///< direction of rows it flew in, -1, 0 or 1
+  int         dcol;  ///< direction of columns it flew in, -1, 0 or 1
+  uint64_t    count; ///< number of spaceships removed
+} gol_escaped;
+
+/**
+ * @brief Object found by gol_classify()
+ */
+typedef struct gol_object {
+  char       *code;   ///< canonical code, the same in every phase and
+                      ///< orientation
+  uint64_t    hash;   ///< hash of the canonical code
+  const char *name;   ///< name of a known object, NULL if it's not known
+  int         kind;   ///< one of enum gol_kind
+  int         cells;  ///< living cells in the phase of the canonical code
+  int         period; ///< generations until it repeats, 0 if not found
+  int         drow;   ///< rows moved in one period
+  int         dcol;   ///< columns moved in one period
+  int64_t     row;    ///< first row of the object
+  int64_t     col;    ///< first column of the object
+  int64_t     height; ///< height of the object
+  int64_t     width;  ///< width of the object
+} gol_object;
+
+/**
+ * @brief Memory used by a universe in bytes, found by gol_memory_usage()
+ */
+typedef struct gol_memory {
+  size_t cells;   ///< cells allocated by the pool, used or not, without the
+                  ///< hash handles of the stored ones
+  size_t index;   ///< hash of the stored cells, their handles and buckets
+  size_t history; ///< changes recorded by the evolution for the history
+  size_t cache;   ///< paged out tiles and the tiles tracked for paging
+  size_t total;   ///< all of the above
+} gol_memory;
+
+GOL_API int         gol_mode_count(void);
+GOL_API const char *gol_mode_name(int mode);
+GOL_API int         gol_mode_states(int mode);
+
+GOL_API gol_universe *gol_create(int height, int width, int mode);
+GOL_API gol_universe *gol_load(const char *name);
+GOL_API int           gol_save(gol_universe *u, const char *name);
+GOL_API void          gol_destroy(gol_universe *u);
+
+GOL_API void     gol_seed(gol_universe *u, unsigned seed);
+GOL_API void     gol_evolve(gol_universe *u, int steps);
+GOL_API uint64_t gol_generation(const gol_universe *u);
+GOL_API size_t   gol_population(const gol_universe *u);
+GOL_API int      gol_bounds(const gol_universe *u, int64_t *row, int64_t *col,
+                            int64_t *height, int64_t *width);
+GOL_API size_t   gol_memory_usage(const gol_universe *u, gol_memory *memory);
+
+GOL_API int    gol_get(gol_universe *u, int64_t row, int64_t col);
+GOL_API void   gol_set(gol_universe *u, int64_t row, int64_t col, int val);
+GOL_API void   gol_insert(gol_universe *u, const gol_cell *cells, size_t size);
+GOL_API size_t gol_query(gol_universe *u, int64_t row, int64_t col,
+                         int64_t height, int64_t width, gol_cell **cells);
+GOL_API void   gol_clear(gol_universe *u);
+
+GOL_API size_t gol_classify(gol_universe *u, int period, gol_object **objects);
+GOL_API void   gol_objects_free(gol_object *objects, size_t size);
+
+GOL_API int      gol_escape(gol_universe *u, int interval);
+GOL_API size_t   gol_escaped_list(const gol_universe *u,
+                                  const gol_escaped **escaped);
+GOL_API uint64_t gol_escaped_total(const gol_universe *u);
+
+GOL_API int gol_page(gol_universe *u, size_t budget, const char *file);
+GOL_API int gol_tiles(const gol_universe *u, size_t *resident, size_t *paged);
+
+GOL_API int  gol_threads(void);
+GOL_API void gol_parallel(size_t count, int threads, gol_task_f task,
+                          void *arg);
+GOL_API void gol_evolve_many(gol_universe **universes, size_t count, int steps,
+                             int threads);
+
+#endif
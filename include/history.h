@@ -0,0 +1,23 @@
+/**
+ * @file history.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Game history interface
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+
+extern int history_budget;
+
+void   history_start(void);
+void   history_stop(void);
+void   history_edit(void);
+void   history_evolve(int steps);
+int    history_range(unsigned *first, unsigned *last);
+int    history_seek(unsigned generation);
+size_t history_memory(void);
+
+#endif
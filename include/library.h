@@ -0,0 +1,46 @@
+/**
+ * @file library.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Pattern library interface
+ */
+
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include <curses.h>
+
+#include "uthash.h"
+
+/// Height of the pattern thumbnail
+#define LIBRARY_THUMB_H 16
+
+/// Width of the pattern thumbnail
+#define LIBRARY_THUMB_W 32
+
+/**
+ * @brief Information about a file in the pattern library
+ */
+typedef struct library_T {
+  char         *name;       ///< name of the file
+  char         *stem;       ///< name of the file without the extension
+  char         *ext;        ///< extension of the file, points into name
+  long long     mtime;      ///< modification time of the file
+  long long     size;       ///< size of the file in bytes
+  long long     height;     ///< height of the bounding box of the pattern
+  long long     width;      ///< width of the bounding box of the pattern
+  long          population; ///< number of living cells
+  int           rule;       ///< index of the game mode, -1 if unknown
+  int           seen;       ///< file was found in the last scan
+  unsigned char thumb[LIBRARY_THUMB_H * LIBRARY_THUMB_W / 4]; ///< 2 bit cells
+  UT_hash_handle hh;
+} library_T;
+
+extern library_T **library_entries;
+extern int         library_entries_s;
+
+void library_update(void);
+void library_free(void);
+void library_preview(WINDOW *win, int y, int x, int h, int w, void *data);
+
+#endif
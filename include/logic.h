@@ -8,15 +8,22 @@
 #ifndef LOGIC_H
 #define LOGIC_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gol.h"
 #include "uthash.h"
 
+/// Largest number of cell states of a game mode
+#define STATES_MAX 16
+
 /**
  * @brief structure that stores cells coordinates to use as a key in a hash
  * map-uh;
  */
 typedef struct Cell_cord {
-  int row;
-  int col;
+  int64_t row;
+  int64_t col;
 } Cell_cord;
 
 /**
@@ -25,29 +32,86 @@ typedef struct Cell_cord {
 typedef struct Cell {
   Cell_cord      cord;
   unsigned char  val;
+  unsigned char  prev; ///< value before the current evolution
   UT_hash_handle hh;
 } Cell;
 
-extern Cell *hash;
+/**
+ * @brief structure that stores a cell value with its coordinates, used for
+ * moving many cells at once in a compact buffer;
+ */
+typedef gol_cell coord_val;
 
-extern char *evolution_names[];
-extern int   evolution_cells[];
-extern int   evolution_size, evolve_index;
+/**
+ * @brief structure that stores the state of a universe, all functions in
+ * logic.c work on the universe of the calling thread;
+ */
+struct gol_universe {
+  Cell      *hash;           ///< stored cells
+  Cell      *pool_free;      ///< unused cells, linked through hh.next
+  size_t     pool_free_s;    ///< number of unused cells
+  Cell     **pool_chunks;    ///< all blocks of cells allocated by the pool
+  int        pool_chunks_s;  ///< number of blocks in pool_chunks
+  size_t     pool_cells;     ///< number of cells in all blocks
+  coord_val *change_cells;   ///< cells changed by the tracked evolution
+  int        change_cells_s; ///< number of cells in change_cells
+  int        change_cells_c; ///< capacity of change_cells
+  int        isTracking;     ///< evolution records its changes
+  int        height;         ///< height of the universe, 0 if unlimited
+  int        width;          ///< width of the universe, 0 if unlimited
+  int        isWrapping;     ///< universe is limited and wraps around
+  int        evolve_index;   ///< index of the game mode
+  int        toggle_mod;     ///< number of cell states of the game mode
+  uint16_t   birth;          ///< numbers of living neighbours a cell is born
+                             ///< with as bits, in the Generations family
+  uint16_t   survive;        ///< numbers of living neighbours a cell stays
+                             ///< alive with as bits, in the Generations family
+  unsigned   seed;           ///< seed of the random number generator
+  uint32_t   rng;            ///< state of the random number generator
+  uint64_t   generation;     ///< number of generations evolved
+
+  int          escape;    ///< generations between removing escaping
+                          ///< spaceships, 0 if they are not removed
+  gol_escaped *escaped;   ///< spaceships removed, by name and direction
+  size_t       escaped_s; ///< number of entries in escaped
+
+  struct page_T *page;  ///< paging of cold tiles, NULL if it's disabled
+  size_t         paged; ///< number of living cells that are paged out
 
-extern int pos_y, pos_x;
+  void (*evolve)(gol_universe *u);                           ///< game mode
+  void (*addToCells)(gol_universe *u, int64_t i, int64_t j,
+                     int mod); ///< neighbours
+};
 
-extern Cell **save_cells;
-extern int    save_cells_s;
+extern _Thread_local gol_universe *universe;
+
+extern char *evolution_names[];
+extern char *evolution_rules[];
+extern int   evolution_cells[];
+extern int   evolution_random[];
+extern int   evolution_size;
 
-int  logic_init(int isWrapping, int index);
-int  evolution_init(int index);
+int  logic_init(int height, int width, int index);
 void do_evolution(int steps);
+int  logic_evolve_changes(coord_val **buffer);
 int  logic_free(void);
-int  toggleAt(int i, int j);
-int  getAt(int i, int j);
-void deleteAt(int i, int j);
-void saveCell(int i, int j);
-void setPosition(int i, int j);
-void setAt(int i, int j, int val);
+void logic_clear(void);
+int  toggleAt(int64_t i, int64_t j);
+int  getAt(int64_t i, int64_t j);
+void deleteAt(int64_t i, int64_t j);
+int  logic_extract(int64_t i, int64_t j, int64_t h, int64_t w,
+                   coord_val **buffer);
+void deleteRegion(int64_t i, int64_t j, int64_t h, int64_t w);
+void toggleRegion(int64_t i, int64_t j, int64_t h, int64_t w);
+void setRegion(int64_t i, int64_t j, const coord_val *cells, int size);
+void logic_reserve(size_t n);
+void logic_insert_bulk(const coord_val *buf, size_t n);
+void logic_evict(const coord_val *cells, size_t n);
+void logic_restore(const coord_val *cells, size_t n);
+size_t logic_collect(coord_val **buffer);
+int  logic_rule(const char *rule, uint16_t *birth, uint16_t *survive,
+                int *states);
+void setSeed(unsigned s);
+void setAt(int64_t i, int64_t j, int val);
 
 #endif
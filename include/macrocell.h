@@ -0,0 +1,20 @@
+/**
+ * @file macrocell.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Macrocell format interface
+ */
+
+#ifndef MACROCELL_H
+#define MACROCELL_H
+
+#include <stdio.h>
+
+#include "format.h"
+#include "logic.h"
+
+void macrocell_read(FILE *f, cells_T *cells);
+void macrocell_write(FILE *f, coord_val *cells, int size, char *rule,
+                     format_progress_f progress);
+
+#endif
@@ -0,0 +1,29 @@
+/**
+ * @file page.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Paging of cold tiles out of memory
+ */
+
+#ifndef PAGE_H
+#define PAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gol.h"
+#include "logic.h"
+
+void   page_step(gol_universe *u);
+void   page_touch(gol_universe *u, int64_t i, int64_t j, int64_t h, int64_t w);
+int    page_get(gol_universe *u, int64_t row, int64_t col);
+size_t page_cells(gol_universe *u, int64_t i, int64_t j, int64_t h, int64_t w,
+                  coord_val **buffer);
+size_t page_all(gol_universe *u, coord_val *buffer);
+int    page_bounds(const gol_universe *u, int64_t *min_row, int64_t *min_col,
+                   int64_t *max_row, int64_t *max_col);
+size_t page_memory(const gol_universe *u);
+void   page_clear(gol_universe *u);
+void   page_close(gol_universe *u);
+
+#endif
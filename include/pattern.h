@@ -48,6 +48,8 @@ struct pattern_T games[] = {
     {     "+", "increase generation step", 0, 0},
     {     "[",         "decrease dt step", 0, 0},
     {     "]",         "increase dt step", 0, 0},
+    {     "z",                 "zoom out", 0, 0},
+    {     "x",                  "zoom in", 0, 0},
     {      "",                         "", 0, 0},
     {      "",            "Visual select", 0, 0},
     { "enter",                     "save", 0, 0},
@@ -0,0 +1,33 @@
+/**
+ * @file record.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Game recording and replay interface
+ */
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "format.h"
+#include "logic.h"
+
+/// Extension of the recording files
+#define RECORD_EXT "golr"
+
+void record_start(void);
+void record_stop(void);
+int  record_active(void);
+void record_keyframe(void);
+void record_changes(const coord_val *cells, int size);
+void record_frame(void);
+int  record_read(char *name, cells_T *cells);
+
+int  replay_open(char *name);
+void replay_close(void);
+int  replay_active(void);
+int  replay_step(int steps, unsigned *generation);
+int  replay_seek(unsigned generation, unsigned *found);
+int  replay_range(unsigned *first, unsigned *last);
+void replay_load(char *name, int index);
+
+#endif
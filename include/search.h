@@ -0,0 +1,13 @@
+/**
+ * @file search.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Soup search interface
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+int search_main(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,13 @@
+/**
+ * @file shard.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Sharded simulation interface
+ */
+
+#ifndef SHARD_H
+#define SHARD_H
+
+int shard_main(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * @file snapshot.h
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief Binary snapshot interface
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "format.h"
+#include "logic.h"
+
+/// Extension of the binary snapshot files
+#define SNAPSHOT_EXT "golb"
+
+/**
+ * @brief Information about the game stored in a snapshot
+ */
+typedef struct snapshot_T {
+  int      height;     ///< height of the game, 0 if unlimited
+  int      width;      ///< width of the game, 0 if unlimited
+  int      mode;       ///< index of the game mode
+  unsigned seed;       ///< seed of the random number generator
+  uint64_t generation; ///< generation at which the snapshot was taken
+} snapshot_T;
+
+void snapshot_write(FILE *f, snapshot_T *info, coord_val *cells, size_t size,
+                    format_progress_f progress);
+int  snapshot_read(char *name, snapshot_T *info, cells_T *cells);
+
+#endif
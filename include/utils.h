@@ -11,7 +11,6 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <curses.h>
 
 /// maximum of the two numbers
 #define MAX(a, b) ((a > b) ? a : b)
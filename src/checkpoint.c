@@ -0,0 +1,351 @@
+/**
+ * @file checkpoint.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains periodic checkpoints of the running game
+ *
+ * While the game is played, its state is saved every checkpoint_gens
+ * generations or every checkpoint_secs seconds, whichever comes first. A
+ * checkpoint is either a full binary snapshot, or a record appended to the
+ * journal next to it holding only the cells that changed since the previous
+ * checkpoint. A new snapshot is taken and the journal is started over when
+ * the journal gets long, or when most of the cells changed.
+ *
+ * Living cells are copied on the game thread, while sorting, comparing and
+ * writing them is done on a separate thread, so that the game is slowed down
+ * only by the copy. If a checkpoint is due while the previous one is still
+ * being written, it is taken as soon as the writing is done.
+ *
+ * Journal starts with a header holding the generation of its snapshot, and
+ * each record holds the generation, its size in bytes and the changed cells
+ * encoded as described in delta.c. The header and the records also hold the
+ * state of the random number generator at their generation, so the game
+ * continues with the same random numbers as if it was never stopped.
+ * Incomplete record at the end of the journal, left by a crash, is ignored.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "checkpoint.h"
+#include "delta.h"
+#include "file.h"
+#include "game.h"
+#include "logic.h"
+#include "snapshot.h"
+#include "utils.h"
+
+/// Magic bytes at the start of every journal
+#define JOURNAL_MAGIC "GOLJ"
+
+/// Version of the journal format
+#define JOURNAL_VERSION 2
+
+/// Maximum number of records in the journal before a new snapshot is taken
+#define JOURNAL_RECORDS 64
+
+/// File name of the checkpoint snapshot
+#define SNAPSHOT_FILE CHECKPOINT_NAME "." SNAPSHOT_EXT
+
+/// File name of the checkpoint journal
+#define JOURNAL_FILE CHECKPOINT_NAME "." CHECKPOINT_EXT
+
+int checkpoint_gens = 0;  ///< generations between checkpoints, 0 to disable
+int checkpoint_secs = 60; ///< seconds between checkpoints, 0 to disable
+
+/**
+ * @brief Header at the start of the journal
+ */
+typedef struct journal_T {
+  char     magic[4]; ///< JOURNAL_MAGIC
+  uint32_t version;  ///< JOURNAL_VERSION
+  uint64_t base;     ///< generation of the snapshot the journal applies to
+  uint32_t rng;      ///< state of the random number generator at base
+  uint32_t reserved; ///< always 0
+} journal_T;
+
+/**
+ * @brief Header of a record in the journal
+ */
+typedef struct record_T {
+  uint64_t generation; ///< generation at which the checkpoint was taken
+  uint64_t size;       ///< size of the encoded cells in bytes
+  uint32_t rng;        ///< state of the random number generator
+  uint32_t reserved;   ///< always 0
+} record_T;
+
+/**
+ * @brief State of the checkpoints of the current game
+ */
+typedef struct checkpoint_T {
+  snapshot_T info;     ///< information about the game being saved
+  uint32_t   rng;      ///< state of the random number generator being saved
+  coord_val *cells;    ///< living cells being saved
+  size_t     size;     ///< number of cells being saved
+  coord_val *prev;     ///< sorted living cells of the last checkpoint
+  size_t     prev_s;   ///< number of cells of the last checkpoint
+  FILE      *journal;  ///< open journal, NULL before the first snapshot
+  int        records;  ///< number of records in the journal
+  delta_T    delta;    ///< buffer for encoding a record
+  atomic_int finished; ///< the checkpoint has been written
+} checkpoint_T;
+
+static checkpoint_T state;
+static pthread_t    thread;
+static int          running;  ///< thread has not been joined yet
+static unsigned     last_gen; ///< generation of the last checkpoint
+static time_t       last_time; ///< time of the last checkpoint
+
+/**
+ * @brief Encode the cells that changed between prev and cells into the record
+ * buffer. Return the number of changed cells
+ */
+static size_t encode_diff(checkpoint_T *s) {
+  size_t i = 0, j = 0, changes = 0;
+
+  s->delta.size = 0;
+  delta_begin(&s->delta);
+
+  while (i < s->prev_s || j < s->size) {
+    int cmp = i == s->prev_s ? 1
+              : j == s->size ? -1
+                             : delta_cmp(&s->prev[i], &s->cells[j]);
+
+    if (cmp < 0) {
+      coord_val dead = s->prev[i++];
+      dead.val = 0;
+      delta_push(&s->delta, &dead);
+      changes++;
+    } else if (cmp > 0) {
+      delta_push(&s->delta, &s->cells[j++]);
+      changes++;
+    } else {
+      if (s->prev[i].val != s->cells[j].val) {
+        delta_push(&s->delta, &s->cells[j]);
+        changes++;
+      }
+      i++, j++;
+    }
+  }
+
+  return changes;
+}
+
+/**
+ * @brief Write a full snapshot and start a new journal
+ */
+static void write_snapshot(checkpoint_T *s) {
+  journal_T h = {JOURNAL_MAGIC, JOURNAL_VERSION, s->info.generation, s->rng};
+  FILE     *f;
+
+  if ((f = fopen(SNAPSHOT_FILE ".tmp", "wb")) == NULL)
+    return;
+
+  snapshot_write(f, &s->info, s->cells, s->size, NULL);
+  if (fclose(f) != 0 || rename(SNAPSHOT_FILE ".tmp", SNAPSHOT_FILE) != 0)
+    return;
+
+  if (s->journal)
+    fclose(s->journal);
+  if ((s->journal = fopen(JOURNAL_FILE, "wb")) == NULL)
+    return;
+
+  fwrite(&h, sizeof(h), 1, s->journal);
+  fflush(s->journal);
+  s->records = 0;
+}
+
+/**
+ * @brief Write the checkpoint, run on the checkpoint thread
+ */
+static void *checkpoint_worker(void *arg) {
+  checkpoint_T *s = arg;
+  size_t        changes;
+
+  delta_sort(s->cells, s->size);
+
+  if (s->journal == NULL || s->records >= JOURNAL_RECORDS) {
+    write_snapshot(s);
+  } else {
+    changes = encode_diff(s);
+    if (changes * 2 > s->size) {
+      write_snapshot(s);
+    } else {
+      record_T r = {s->info.generation, s->delta.size, s->rng};
+      fwrite(&r, sizeof(r), 1, s->journal);
+      fwrite(s->delta.data, 1, s->delta.size, s->journal);
+      fflush(s->journal);
+      s->records++;
+    }
+  }
+
+  free(s->prev);
+  s->prev = s->cells;
+  s->prev_s = s->size;
+  s->cells = NULL;
+  s->size = 0;
+
+  atomic_store(&s->finished, 1);
+  return NULL;
+}
+
+/**
+ * @brief Wait for the checkpoint that is being written, if any
+ */
+static void checkpoint_wait(void) {
+  if (!running)
+    return;
+
+  pthread_join(thread, NULL);
+  running = 0;
+}
+
+/**
+ * @brief Start taking checkpoints of the current game, the first one is
+ * always a full snapshot
+ */
+void checkpoint_start(void) {
+  checkpoint_stop();
+  last_gen = gen;
+  last_time = time(NULL);
+}
+
+/**
+ * @brief Take a checkpoint if one is due, called after each step of the game
+ */
+void checkpoint_tick(void) {
+  if (running && atomic_load(&state.finished))
+    checkpoint_wait();
+
+  // the game was stepped back, count the generations from there
+  if (gen < last_gen)
+    last_gen = gen;
+
+  int due = (checkpoint_gens && gen - last_gen >= (unsigned)checkpoint_gens) ||
+            (checkpoint_secs && time(NULL) - last_time >= checkpoint_secs);
+
+  if (running || !due)
+    return;
+
+  state.info = (snapshot_T){height, width, universe->evolve_index,
+                            universe->seed, gen};
+  state.rng = universe->rng;
+  state.size = logic_collect(&state.cells);
+
+  last_gen = gen;
+  last_time = time(NULL);
+
+  atomic_store(&state.finished, 0);
+  if (pthread_create(&thread, NULL, checkpoint_worker, &state) != 0) {
+    checkpoint_worker(&state);
+    return;
+  }
+  running = 1;
+}
+
+/**
+ * @brief Stop taking checkpoints, waiting for the one being written
+ */
+void checkpoint_stop(void) {
+  checkpoint_wait();
+
+  if (state.journal)
+    fclose(state.journal);
+  free(state.prev);
+  free(state.cells);
+  delta_free(&state.delta);
+  memset(&state, 0, sizeof(state));
+}
+
+/**
+ * @brief Check if there is a checkpoint that can be resumed
+ */
+int checkpoint_exists(void) {
+  FILE *f = fopen(SNAPSHOT_FILE, "rb");
+
+  if (f == NULL)
+    return 0;
+
+  fclose(f);
+  return 1;
+}
+
+/**
+ * @brief Ignore a cell of a record that is only being validated
+ */
+static void journal_check(int64_t row, int64_t col, int val) {}
+
+/**
+ * @brief Apply the records of the journal that belong to the snapshot at
+ * generation base. Return the generation of the last record applied, and set
+ * rng to the state of the random number generator at it, if the journal is
+ * valid
+ *
+ * Each record is decoded once before it's applied, so that a malformed one is
+ * not applied in part.
+ */
+static uint64_t apply_journal(uint64_t base, uint32_t *rng) {
+  journal_T h;
+  record_T  r;
+  uint8_t  *data = NULL;
+  uint64_t  generation = base;
+  FILE     *f = fopen(JOURNAL_FILE, "rb");
+
+  if (f == NULL)
+    return base;
+
+  if (fread(&h, sizeof(h), 1, f) != 1 ||
+      memcmp(h.magic, JOURNAL_MAGIC, 4) || h.version != JOURNAL_VERSION ||
+      h.base != base) {
+    fclose(f);
+    return base;
+  }
+  *rng = h.rng;
+
+  while (fread(&r, sizeof(r), 1, f) == 1) {
+    uint8_t *t;
+
+    if (r.size > ((uint64_t)1 << 40) || !(t = realloc(data, r.size + 1)))
+      break;
+    data = t;
+    if (fread(data, 1, r.size, f) != r.size ||
+        !delta_decode(data, r.size, journal_check))
+      break;
+
+    delta_apply(data, r.size);
+
+    generation = r.generation;
+    *rng = r.rng;
+  }
+
+  free(data);
+  fclose(f);
+  return generation;
+}
+
+/**
+ * @brief Restore the game from the latest checkpoint and continue it
+ */
+void checkpoint_resume(char *pass, int index) {
+  snapshot_T info;
+  cells_T    cells = {0};
+  uint64_t   generation;
+  uint32_t   rng = 0;
+
+  if (!snapshot_read(SNAPSHOT_FILE, &info, &cells))
+    err("Invalid checkpoint %s", SNAPSHOT_FILE);
+
+  logic_insert_bulk(cells.cells, cells.size);
+  cells_free(&cells);
+
+  generation = apply_journal(info.generation, &rng);
+
+  setSeed(info.seed);
+  if (rng)
+    universe->rng = rng;
+  game(info.height, info.width, info.mode, generation);
+}
@@ -0,0 +1,617 @@
+/**
+ * @file classify.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the classification of objects of the library
+ *
+ * A copy of the universe is evolved for a number of generations, and the
+ * living cells of every generation, its phases, are collected. They are split
+ * into objects using union-find over the cells of all phases, joining the
+ * cells that touch, that interact, or that one came from the other, so the
+ * parts of an oscillator that never touch in one phase, like the two halves
+ * of a toad, end up in the same object, while two gliders flying side by side
+ * don't.
+ *
+ * Each object is then checked for a period, the first generation in which it
+ * repeats its cells, and for the displacement it moves by in that time. The
+ * canonical code of an object is the smallest code of all of its phases in
+ * all eight orientations, so it is the same no matter the phase, orientation
+ * or position the object was found in. Codes are written as in the census of
+ * the soup search, rows of digits of the cell values separated by '$', and
+ * their hash is used to look up the names of known objects of the Normal
+ * mode.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gol.h"
+#include "logic.h"
+#include "utils.h"
+
+/**
+ * @brief Known object of the Normal mode
+ */
+typedef struct known_T {
+  uint64_t       hash; ///< hash of the canonical code
+  char          *code; ///< canonical code
+  const char    *name; ///< name of the object
+  UT_hash_handle hh;
+} known_T;
+
+/**
+ * @brief Name and cells of a known object in any phase and orientation
+ */
+static const char *known_objects[][2] = {
+    {"block", "11$11"},
+    {"blinker", "111"},
+    {"beehive", "0110$1001$0110"},
+    {"loaf", "0110$1001$0101$0010"},
+    {"boat", "110$101$010"},
+    {"ship", "110$101$011"},
+    {"tub", "010$101$010"},
+    {"pond", "0110$1001$1001$0110"},
+    {"long boat", "0100$1010$0101$0011"},
+    {"barge", "0100$1010$0101$0010"},
+    {"mango", "01100$10010$01001$00110"},
+    {"eater 1", "1100$1010$0010$0011"},
+    {"snake", "1011$1101"},
+    {"aircraft carrier", "1100$1001$0011"},
+    {"toad", "0111$1110"},
+    {"beacon", "1100$1100$0011$0011"},
+    {"pulsar", "0011100011100$0000000000000$1000010100001$"
+               "1000010100001$1000010100001$0011100011100$"
+               "0000000000000$0011100011100$1000010100001$"
+               "1000010100001$1000010100001$0000000000000$"
+               "0011100011100"},
+    {"pentadecathlon", "0010000100$1101111011$0010000100"},
+    {"glider", "010$001$111"},
+    {"lightweight spaceship", "01001$10000$10001$11110"},
+    {"middleweight spaceship", "000100$010001$100000$100001$111110"},
+    {"heavyweight spaceship", "0001100$0100001$1000000$1000001$1111110"},
+};
+
+/// Longest period of the known objects
+#define KNOWN_PERIOD 15
+
+static known_T       *known;
+static pthread_once_t known_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Living cells of one generation, sorted by row and then by column
+ */
+typedef struct phase_T {
+  gol_cell *cells; ///< cells of the generation
+  size_t    size;  ///< number of cells
+  size_t   *start; ///< first cell of each object, cells are grouped by object
+} phase_T;
+
+/**
+ * @brief Compare the cells by row, and then by column
+ */
+static int cell_cmp(const void *a, const void *b) {
+  const gol_cell *x = a, *y = b;
+
+  if (x->row != y->row)
+    return x->row < y->row ? -1 : 1;
+  if (x->col != y->col)
+    return x->col < y->col ? -1 : 1;
+  return 0;
+}
+
+/**
+ * @brief Return the root of the set of i, halving the path to it
+ */
+static size_t uf_find(size_t *parent, size_t i) {
+  while (parent[i] != i)
+    i = parent[i] = parent[parent[i]];
+  return i;
+}
+
+/**
+ * @brief Join the sets of i and j
+ */
+static void uf_union(size_t *parent, size_t i, size_t j) {
+  i = uf_find(parent, i);
+  j = uf_find(parent, j);
+  if (i != j)
+    parent[MAX(i, j)] = MIN(i, j);
+}
+
+/**
+ * @brief Return 64-bit FNV-1a hash of the code
+ */
+static uint64_t code_hash(const char *code) {
+  uint64_t hash = 0xCBF29CE484222325;
+
+  while (*code)
+    hash = (hash ^ (unsigned char)*code++) * 0x100000001B3;
+  return hash;
+}
+
+/**
+ * @brief Write the code of n cells in orientation sym into a new string.
+ * Bit 0 of sym flips the rows, bit 1 flips the columns and bit 2 swaps the
+ * rows with the columns
+ */
+static char *shape_code(const gol_cell *cells, size_t n, int sym) {
+  int64_t min_row = 0, min_col = 0, max_row = 0, max_col = 0;
+  int     w;
+  char   *code;
+
+  for (size_t k = 0; k < n; k++) {
+    int64_t r = sym & 4 ? cells[k].col : cells[k].row;
+    int64_t c = sym & 4 ? cells[k].row : cells[k].col;
+
+    r = sym & 1 ? -r : r;
+    c = sym & 2 ? -c : c;
+    if (!k || r < min_row)
+      min_row = r;
+    if (!k || c < min_col)
+      min_col = c;
+    if (!k || r > max_row)
+      max_row = r;
+    if (!k || c > max_col)
+      max_col = c;
+  }
+
+  // each row ends with '$', and the last one with '\0' instead
+  w = max_col - min_col + 2;
+  MEM_CHECK(code = malloc((size_t)(max_row - min_row + 1) * w));
+  for (int i = 0; i <= max_row - min_row; i++) {
+    memset(code + (size_t)i * w, '0', w - 1);
+    code[(size_t)i * w + w - 1] = '$';
+  }
+  code[(size_t)(max_row - min_row + 1) * w - 1] = '\0';
+
+  for (size_t k = 0; k < n; k++) {
+    int64_t r = sym & 4 ? cells[k].col : cells[k].row;
+    int64_t c = sym & 4 ? cells[k].row : cells[k].col;
+
+    r = sym & 1 ? -r : r;
+    c = sym & 2 ? -c : c;
+    code[(size_t)(r - min_row) * w + c - min_col] = '0' + cells[k].val;
+  }
+
+  return code;
+}
+
+/**
+ * @brief Check if the cells a and b are the same, moved by (drow, dcol)
+ */
+static int shape_moved(const gol_cell *a, const gol_cell *b, size_t n,
+                       int *drow, int *dcol) {
+  *drow = b[0].row - a[0].row;
+  *dcol = b[0].col - a[0].col;
+
+  // both are sorted, and moving the cells doesn't change their order
+  for (size_t k = 0; k < n; k++)
+    if (b[k].row - a[k].row != *drow || b[k].col - a[k].col != *dcol ||
+        b[k].val != a[k].val)
+      return 0;
+  return 1;
+}
+
+/**
+ * @brief Collect the living cells of the universe, sorted
+ */
+static void phase_collect(gol_universe *u, phase_T *phase) {
+  int64_t row, col, h, w;
+
+  phase->cells = NULL;
+  phase->size = 0;
+  phase->start = NULL;
+
+  if (!gol_bounds(u, &row, &col, &h, &w))
+    return;
+
+  phase->size = gol_query(u, row, col, h, w, &phase->cells);
+  for (size_t k = 0; k < phase->size; k++) {
+    phase->cells[k].row += row;
+    phase->cells[k].col += col;
+  }
+  qsort(phase->cells, phase->size, sizeof(gol_cell), cell_cmp);
+}
+
+/**
+ * @brief Group the cells of the phase by object, given the object of each of
+ * them
+ */
+static void phase_group(phase_T *phase, const size_t *of, size_t objects) {
+  gol_cell *grouped;
+  size_t   *next;
+
+  MEM_CHECK(phase->start = calloc(objects + 1, sizeof(size_t)));
+  MEM_CHECK(grouped = malloc((phase->size + 1) * sizeof(gol_cell)));
+  MEM_CHECK(next = malloc((objects + 1) * sizeof(size_t)));
+
+  for (size_t k = 0; k < phase->size; k++)
+    phase->start[of[k] + 1]++;
+
+  for (size_t i = 0; i < objects; i++) {
+    next[i] = phase->start[i];
+    phase->start[i + 1] += phase->start[i];
+  }
+
+  // stable, so the cells of each object stay sorted
+  for (size_t k = 0; k < phase->size; k++)
+    grouped[next[of[k]]++] = phase->cells[k];
+
+  free(phase->cells);
+  phase->cells = grouped;
+  free(next);
+}
+
+/**
+ * @brief Return the index of the cell at (row, col) in the sorted cells, -1
+ * if there is no such cell
+ */
+static long cell_find(const gol_cell *cells, size_t size, int64_t row,
+                      int64_t col) {
+  gol_cell  key = {row, col, 0};
+  gol_cell *c = bsearch(&key, cells, size, sizeof(gol_cell), cell_cmp);
+  return c != NULL ? c - cells : -1;
+}
+
+/**
+ * @brief Living neighbour of a cell, and the set it belongs to
+ */
+typedef struct near_T {
+  int64_t row; ///< row of the cell
+  int64_t col; ///< column of the cell
+  size_t  set; ///< set of the living neighbour
+} near_T;
+
+/**
+ * @brief Compare the neighbours by cell, and then by set
+ */
+static int near_cmp(const void *a, const void *b) {
+  const near_T *x = a, *y = b;
+
+  if (x->row != y->row)
+    return x->row < y->row ? -1 : 1;
+  if (x->col != y->col)
+    return x->col < y->col ? -1 : 1;
+  if (x->set != y->set)
+    return x->set < y->set ? -1 : 1;
+  return 0;
+}
+
+/**
+ * @brief Join the sets of cells that interact through a dead cell of the
+ * phase, whose cells start at node first
+ *
+ * Cells of two sets two cells apart don't touch, but they can still change
+ * each other through a dead cell between them. A dead cell is born with three
+ * living neighbours, so the sets around it interact if there are three of
+ * them together, which none of the sets would give on its own, or if one of
+ * the sets has three of them, which the others prevent.
+ */
+static void objects_join(const phase_T *phase, size_t first, size_t *parent) {
+  near_T *near;
+  size_t  n = 0;
+
+  MEM_CHECK(near = malloc((8 * phase->size + 1) * sizeof(near_T)));
+  for (size_t k = 0; k < phase->size; k++) {
+    size_t set = uf_find(parent, first + k);
+
+    for (int dr = -1; dr <= 1; dr++)
+      for (int dc = -1; dc <= 1; dc++)
+        if (dr || dc)
+          near[n++] = (near_T){phase->cells[k].row + dr,
+                               phase->cells[k].col + dc, set};
+  }
+  qsort(near, n, sizeof(near_T), near_cmp);
+
+  for (size_t i = 0, j; i < n; i = j) {
+    int sets = 1, three = 0, run = 1;
+
+    for (j = i + 1; j < n && near[j].row == near[i].row &&
+                    near[j].col == near[i].col;
+         j++) {
+      if (near[j].set != near[j - 1].set) {
+        three |= run == 3;
+        run = 0;
+        sets++;
+      }
+      run++;
+    }
+    three |= run == 3;
+
+    if (sets < 2 || (j - i != 3 && !three) ||
+        cell_find(phase->cells, phase->size, near[i].row, near[i].col) >= 0)
+      continue;
+
+    for (size_t k = i + 1; k < j; k++)
+      uf_union(parent, near[i].set, near[k].set);
+  }
+
+  free(near);
+}
+
+/**
+ * @brief Split the cells of all phases into objects. Return the number of
+ * objects and group the cells of each phase by them
+ *
+ * Each cell of each phase is a node, joined with the cells it touches in the
+ * same phase and with the cells around it in the phase before, which it came
+ * from. Sets that die out before the last phase, the sparks of oscillators
+ * and spaceships, are then joined to the sets within two cells of them.
+ */
+static size_t objects_split(phase_T *phases, int count) {
+  static const int offsets[][2] = {{0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
+  size_t *first, *parent, *object, size = 0, objects = 0;
+  char   *lasts;
+
+  MEM_CHECK(first = malloc((count + 1) * sizeof(size_t)));
+  for (int t = 0; t < count; t++) {
+    first[t] = size;
+    size += phases[t].size;
+  }
+  first[count] = size;
+
+  MEM_CHECK(parent = malloc((size + 1) * sizeof(size_t)));
+  MEM_CHECK(object = malloc((size + 1) * sizeof(size_t)));
+  MEM_CHECK(lasts = calloc(size + 1, sizeof(char)));
+  for (size_t k = 0; k < size; k++)
+    parent[k] = k;
+
+  for (int t = 0; t < count; t++) {
+    const phase_T *p = &phases[t];
+
+    for (size_t k = 0; k < p->size; k++) {
+      // neighbours before the cell were already joined with it
+      for (int d = 0; d < 4; d++) {
+        long c = cell_find(p->cells, p->size, p->cells[k].row + offsets[d][0],
+                           p->cells[k].col + offsets[d][1]);
+        if (c >= 0)
+          uf_union(parent, first[t] + k, first[t] + c);
+      }
+
+      for (int dr = -1; t && dr <= 1; dr++)
+        for (int dc = -1; dc <= 1; dc++) {
+          long c = cell_find(phases[t - 1].cells, phases[t - 1].size,
+                             p->cells[k].row + dr, p->cells[k].col + dc);
+          if (c >= 0)
+            uf_union(parent, first[t] + k, first[t - 1] + c);
+        }
+    }
+
+    objects_join(p, first[t], parent);
+  }
+
+  for (size_t k = first[count - 1]; k < size; k++)
+    lasts[uf_find(parent, k)] = 1;
+
+  for (int t = 0; t < count - 1; t++) {
+    const phase_T *p = &phases[t];
+
+    for (size_t k = 0; k < p->size; k++) {
+      if (lasts[uf_find(parent, first[t] + k)])
+        continue;
+
+      for (int dr = -2; dr <= 2; dr++)
+        for (int dc = -2; dc <= 2; dc++) {
+          long c = cell_find(p->cells, p->size, p->cells[k].row + dr,
+                             p->cells[k].col + dc);
+          if (c >= 0 && lasts[uf_find(parent, first[t] + c)]) {
+            uf_union(parent, first[t] + k, first[t] + c);
+            lasts[uf_find(parent, first[t] + k)] = 1;
+          }
+        }
+    }
+  }
+
+  // roots are the first node of their object, so they are numbered in order
+  for (size_t k = 0; k < size; k++)
+    object[k] = parent[k] == k ? objects++ : object[uf_find(parent, k)];
+
+  for (int t = 0; t < count; t++)
+    phase_group(&phases[t], object + first[t], objects);
+
+  free(lasts);
+  free(object);
+  free(parent);
+  free(first);
+  return objects;
+}
+
+/**
+ * @brief Return the number of cells of object i in the phase
+ */
+static size_t object_size(const phase_T *phase, size_t i) {
+  return phase->start[i + 1] - phase->start[i];
+}
+
+/**
+ * @brief Check if the code a comes before b, the shorter one first
+ */
+static int code_before(const char *a, const char *b) {
+  size_t la = strlen(a), lb = strlen(b);
+  return la != lb ? la < lb : strcmp(a, b) < 0;
+}
+
+/**
+ * @brief Find the period, displacement and canonical code of object i from
+ * count phases
+ */
+static void object_describe(gol_object *o, const phase_T *phases, int count,
+                            size_t i) {
+  const gol_cell *cells;
+  int64_t         max_col;
+  int             base = 0, phase_count;
+  size_t          n;
+
+  // an object always has cells in the first phase, unless the game mode
+  // brings cells to life out of nothing
+  while (base < count - 1 && !object_size(&phases[base], i))
+    base++;
+
+  cells = phases[base].cells + phases[base].start[i];
+  n = object_size(&phases[base], i);
+
+  *o = (gol_object){0};
+  for (int t = base + 1; t < count && !o->period; t++)
+    if (object_size(&phases[t], i) == n &&
+        shape_moved(cells, phases[t].cells + phases[t].start[i], n, &o->drow,
+                    &o->dcol))
+      o->period = t - base;
+
+  if (!o->period) {
+    o->drow = o->dcol = 0;
+    o->kind = GOL_UNKNOWN;
+  } else if (o->drow || o->dcol)
+    o->kind = GOL_SPACESHIP;
+  else
+    o->kind = o->period == 1 ? GOL_STILL_LIFE : GOL_OSCILLATOR;
+
+  // cells are sorted, so only the columns have to be searched
+  o->row = cells[0].row;
+  o->col = max_col = cells[0].col;
+  for (size_t k = 1; k < n; k++) {
+    o->col = MIN(o->col, cells[k].col);
+    max_col = MAX(max_col, cells[k].col);
+  }
+  o->height = cells[n - 1].row - o->row + 1;
+  o->width = max_col - o->col + 1;
+
+  phase_count = o->period ? o->period : 1;
+  for (int t = base; t < base + phase_count; t++) {
+    const gol_cell *pc = phases[t].cells + phases[t].start[i];
+    size_t          pn = object_size(&phases[t], i);
+
+    for (int sym = 0; sym < 8; sym++) {
+      char *code = shape_code(pc, pn, sym);
+
+      if (o->code == NULL || code_before(code, o->code)) {
+        free(o->code);
+        o->code = code;
+        o->cells = pn;
+      } else {
+        free(code);
+      }
+    }
+  }
+
+  o->hash = code_hash(o->code);
+}
+
+/**
+ * @brief Split the universe into objects and describe them, without looking
+ * up their names
+ */
+static size_t classify(gol_universe *u, int period, gol_object **objects) {
+  gol_universe *copy;
+  phase_T      *phases;
+  int           count = MAX(period, 0) + 1;
+  size_t        size = 0;
+
+  MEM_CHECK(phases = malloc(count * sizeof(phase_T)));
+  phase_collect(u, &phases[0]);
+
+  if (!phases[0].size) {
+    free(phases);
+    *objects = NULL;
+    return 0;
+  }
+
+  // evolve a copy, so the universe and its random numbers are left as they are
+  copy = gol_create(u->height, u->width, u->evolve_index);
+  copy->seed = u->seed;
+  copy->rng = u->rng;
+  gol_insert(copy, phases[0].cells, phases[0].size);
+  for (int t = 1; t < count; t++) {
+    gol_evolve(copy, 1);
+    phase_collect(copy, &phases[t]);
+  }
+  gol_destroy(copy);
+
+  size = objects_split(phases, count);
+
+  MEM_CHECK(*objects = malloc(size * sizeof(gol_object)));
+  for (size_t i = 0; i < size; i++)
+    object_describe(&(*objects)[i], phases, count, i);
+
+  for (int t = 0; t < count; t++) {
+    free(phases[t].cells);
+    free(phases[t].start);
+  }
+  free(phases);
+  return size;
+}
+
+/**
+ * @brief Fill the table of known objects with their canonical codes
+ */
+static void known_init(void) {
+  for (size_t i = 0; i < sizeof(known_objects) / sizeof(*known_objects); i++) {
+    const char   *s = known_objects[i][1];
+    gol_universe *u = gol_create(0, 0, 0);
+    gol_object   *objects;
+    known_T      *k;
+    int           row = 0, col = 0;
+    size_t        size;
+
+    for (; *s; s++) {
+      if (*s == '$') {
+        row++;
+        col = 0;
+      } else {
+        gol_set(u, row, col++, *s - '0');
+      }
+    }
+
+    size = classify(u, KNOWN_PERIOD, &objects);
+    if (size == 1) {
+      MEM_CHECK(k = malloc(sizeof(known_T)));
+      k->hash = objects[0].hash;
+      k->code = objects[0].code;
+      k->name = known_objects[i][0];
+      HASH_ADD(hh, known, hash, sizeof(uint64_t), k);
+      objects[0].code = NULL;
+    }
+
+    gol_objects_free(objects, size);
+    gol_destroy(u);
+  }
+}
+
+/**
+ * @brief Split the living cells into objects and classify them by evolving
+ * a copy of the universe for period generations, the longest period that is
+ * detected. Return the number of objects
+ *
+ * Objects of the Normal mode that are known get their name. Period has to be
+ * at least the period of an object for its code to be the canonical one, and
+ * objects of a limited universe are split where they cross its edges. Buffer
+ * is allocated automatically and should be freed with gol_objects_free().
+ */
+size_t gol_classify(gol_universe *u, int period, gol_object **objects) {
+  size_t size = classify(u, period, objects);
+
+  if (u->evolve_index != 0)
+    return size;
+
+  pthread_once(&known_once, known_init);
+  for (size_t i = 0; i < size; i++) {
+    gol_object *o = &(*objects)[i];
+    known_T    *k;
+
+    HASH_FIND(hh, known, &o->hash, sizeof(uint64_t), k);
+    if (k != NULL && !strcmp(k->code, o->code))
+      o->name = k->name;
+  }
+
+  return size;
+}
+
+/**
+ * @brief Free the objects returned by gol_classify()
+ */
+void gol_objects_free(gol_object *objects, size_t size) {
+  for (size_t i = 0; i < size; i++)
+    free(objects[i].code);
+  free(objects);
+}
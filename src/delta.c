@@ -0,0 +1,179 @@
+/**
+ * @file delta.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the encoding of cell changes
+ *
+ * A run of changes is a sequence of cells in the row-major order, each stored
+ * as the distance from the previous one encoded as variable length integers,
+ * followed by its new value, where 0 means that the cell died. The row
+ * distance is signed, the column is relative to the previous cell in the same
+ * row and absolute otherwise. Runs start at (0, 0), so the whole game is
+ * stored as a run of changes from an empty one.
+ */
+
+#include <stdlib.h>
+
+#include "delta.h"
+#include "utils.h"
+
+/// Maximum size of a variable length integer of 64 bits, 7 bits per byte
+#define VARINT_SIZE ((64 + 6) / 7)
+
+/// Maximum size of an encoded change of a cell, two coordinates and the value
+#define CHANGE_SIZE (2 * VARINT_SIZE + 1)
+
+/**
+ * @brief Compare cells in the row-major order, the order of a run of changes
+ */
+int delta_cmp(const void *a, const void *b) {
+  const coord_val *x = a, *y = b;
+
+  if (x->row != y->row)
+    return x->row < y->row ? -1 : 1;
+  return (x->col > y->col) - (x->col < y->col);
+}
+
+/**
+ * @brief Append the variable length integer to p, return its size
+ */
+static size_t put_varint(uint8_t *p, uint64_t val) {
+  size_t n = 0;
+
+  while (val >= 0x80) {
+    p[n++] = val | 0x80;
+    val >>= 7;
+  }
+  p[n++] = val;
+  return n;
+}
+
+/**
+ * @brief Read the variable length integer at p, return 0 on failure
+ */
+static int get_varint(const uint8_t **p, const uint8_t *end, uint64_t *val) {
+  *val = 0;
+  for (int shift = 0; *p < end && shift < 64; shift += 7) {
+    uint8_t b = *(*p)++;
+    *val |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80))
+      return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Map a signed integer to an unsigned one so that small magnitudes
+ * stay small
+ */
+static uint64_t zigzag(int64_t val) {
+  return ((uint64_t)val << 1) ^ (uint64_t)(val >> 63);
+}
+
+/**
+ * @brief Inverse of zigzag()
+ */
+static int64_t unzigzag(uint64_t val) {
+  return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+/**
+ * @brief Sort the cells in the row-major order, required by delta_push()
+ */
+void delta_sort(coord_val *cells, size_t size) {
+  qsort(cells, size, sizeof(coord_val), delta_cmp);
+}
+
+/**
+ * @brief Start a new run of changes at the end of the buffer
+ */
+void delta_begin(delta_T *delta) {
+  delta->row = 0;
+  delta->col = 0;
+}
+
+/**
+ * @brief Append the change of a cell to the current run, growing the buffer
+ * as needed
+ */
+void delta_push(delta_T *delta, const coord_val *cell) {
+  uint8_t *p;
+
+  if (delta->size + CHANGE_SIZE > delta->capacity) {
+    delta->capacity = MAX(delta->capacity * 2, 4096);
+    MEM_CHECK(p = realloc(delta->data, delta->capacity));
+    delta->data = p;
+  }
+
+  p = delta->data + delta->size;
+  p += put_varint(p, zigzag(cell->row - delta->row));
+
+  if (cell->row == delta->row)
+    p += put_varint(p, (uint64_t)(cell->col - delta->col));
+  else
+    p += put_varint(p, zigzag(cell->col));
+  *p++ = cell->val;
+
+  delta->size = p - delta->data;
+  delta->row = cell->row;
+  delta->col = cell->col;
+}
+
+/**
+ * @brief Release the unused memory of the buffer
+ */
+void delta_shrink(delta_T *delta) {
+  uint8_t *p;
+
+  if (delta->size && (p = realloc(delta->data, delta->size))) {
+    delta->data = p;
+    delta->capacity = delta->size;
+  }
+}
+
+/**
+ * @brief Free the buffer
+ */
+void delta_free(delta_T *delta) {
+  free(delta->data);
+  delta->data = NULL;
+  delta->size = 0;
+  delta->capacity = 0;
+}
+
+/**
+ * @brief Apply the change of a cell to the game
+ */
+static void delta_set(int64_t row, int64_t col, int val) {
+  if (val)
+    setAt(row, col, val);
+  else
+    deleteAt(row, col);
+}
+
+/**
+ * @brief Apply a run of changes to the game, return 0 if it is malformed
+ */
+int delta_apply(const uint8_t *data, size_t size) {
+  return delta_decode(data, size, delta_set);
+}
+
+/**
+ * @brief Pass each change of a run to the function change, return 0 if the
+ * run is malformed
+ */
+int delta_decode(const uint8_t *data, size_t size, delta_change_f change) {
+  const uint8_t *p = data, *end = data + size;
+  int64_t        row = 0, col = 0;
+  uint64_t       a, b;
+
+  while (p < end) {
+    if (!get_varint(&p, end, &a) || !get_varint(&p, end, &b) || p >= end)
+      return 0;
+
+    col = a ? unzigzag(b) : col + (int64_t)b;
+    row += unzigzag(a);
+    change(row, col, *p++);
+  }
+  return 1;
+}
@@ -53,7 +53,7 @@ void print_pattern(WINDOW *win, pattern_T pattern, int *y, int x) {
       continue;
     }
     int val = *c - '0';
-    wattrset(win, COLOR_PAIR(val + 2));
+    wattrset(win, COLOR_PAIR(val + PAIR_CELL));
     print_cell(win, "  ");
   }
 }
@@ -118,7 +118,7 @@ int display_imenu(window_T wind, struct imenu_T *items, int size) {
 
   for (int i = 0; i < size; i++)
     if (!items[i].buffer)
-      items[i].buffer = calloc(5, sizeof(char));
+      items[i].buffer = calloc(items[i].size + 1, sizeof(char));
 
   int maxi = 0, len = 0;
   for (int i = 0; i < size; i++)
@@ -264,6 +264,12 @@ redraw:;
       wprintw(win, "%s", sep);
     }
 
+    struct menu_T *item = &items[d_start + current];
+    int preview_x = (window_width(wind) + maxi) / 2 + 4;
+    if (item->preview && preview_x < window_width(wind))
+      item->preview(win, y_offset - 1, preview_x, window_height(wind) - y_offset,
+                    window_width(wind) - preview_x - 1, item->data);
+
     wrefresh(win);
 
     while (TRUE) {
@@ -291,6 +297,10 @@ redraw:;
   }
 }
 
+/// Colours of the cell states, the first one is of the dead cells
+static const short state_colors[] = {COLOR_WHITE,   COLOR_WHITE, COLOR_RED,
+                                     COLOR_MAGENTA, COLOR_CYAN,  COLOR_GREEN};
+
 /**
  * @brief Initialize ncurses library and set colors based on display mode
  * selected while compiling
@@ -313,31 +323,24 @@ void curses_start(void) {
   init_pair(0, COLOR_WHITE, -1);
   init_pair(1, COLOR_RED, -1);
 
-#ifndef NO_UNICODE
-  init_pair(2, COLOR_WHITE, -1);
-  init_pair(3, COLOR_WHITE, -1);
-  init_pair(4, COLOR_RED, -1);
-
-  init_pair(5, COLOR_WHITE, COLOR_BLUE);
-  init_pair(6, COLOR_WHITE, COLOR_BLUE);
-  init_pair(7, COLOR_RED, COLOR_BLUE);
+  // a pair for each cell state, the decay states of the Generations family
+  // cycle through the colours after the first three
+  for (int i = 0; i < STATES_MAX; i++) {
+    short color = i < 3 ? state_colors[i] : state_colors[3 + (i - 3) % 3];
 
-  init_pair(8, COLOR_WHITE, COLOR_YELLOW);
-  init_pair(9, COLOR_WHITE, COLOR_YELLOW);
-  init_pair(10, COLOR_RED, COLOR_YELLOW);
+#ifndef NO_UNICODE
+    init_pair(PAIR_CELL + i, color, -1);
+    init_pair(PAIR_CURSOR + i, color, COLOR_BLUE);
+    init_pair(PAIR_SELECT + i, color, COLOR_YELLOW);
 #else
-  init_pair(2, COLOR_WHITE, -1);
-  init_pair(3, COLOR_WHITE, COLOR_WHITE);
-  init_pair(4, COLOR_RED, COLOR_RED);
-
-  init_pair(5, COLOR_BLUE, -1);
-  init_pair(6, COLOR_BLUE, COLOR_WHITE);
-  init_pair(7, COLOR_BLUE, COLOR_RED);
-
-  init_pair(8, COLOR_WHITE, COLOR_YELLOW);
-  init_pair(9, COLOR_WHITE, COLOR_BLUE);
-  init_pair(10, COLOR_RED, COLOR_BLACK);
+    init_pair(PAIR_CELL + i, color, i ? color : -1);
+    init_pair(PAIR_CURSOR + i, COLOR_BLUE, i ? color : -1);
+    init_pair(PAIR_SELECT + i, color,
+              i == 0   ? COLOR_YELLOW
+              : i == 1 ? COLOR_BLUE
+                       : COLOR_BLACK);
 #endif
+  }
 
 #if defined NCURSES_MOUSE_VERSION && !defined NO_MOUSE
   mbitmask = mousemask(BUTTON1_CLICKED, NULL);
@@ -0,0 +1,176 @@
+/**
+ * @file escape.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the removal of escaping spaceships of the library
+ *
+ * Spaceships shot off by guns and soups of an unlimited universe fly away
+ * forever, growing the number of cells, and with it the memory and the time
+ * each generation takes. When enabled, every few generations the universe is
+ * classified, and the known spaceships that are more than ESCAPE_MARGIN cells
+ * away from the rest of the universe, its active region, and are flying away
+ * from it are counted by name and direction and removed.
+ *
+ * The active region is made of all objects that are not known spaceships, so
+ * a stream of gliders leaving a gun is removed one glider at a time, while a
+ * universe of spaceships alone is left as it is, because they might still
+ * collide.
+ */
+
+#include <stdlib.h>
+
+#include "escape.h"
+#include "gol.h"
+#include "logic.h"
+#include "page.h"
+#include "utils.h"
+
+/// Longest period of the known spaceships
+#define ESCAPE_PERIOD 4
+
+/// Least distance between a removed spaceship and the active region
+#define ESCAPE_MARGIN 16
+
+/**
+ * @brief Sign of the value, -1, 0 or 1
+ */
+static int sign(int val) { return (val > 0) - (val < 0); }
+
+/**
+ * @brief Check if the object is a known spaceship
+ */
+static int is_spaceship(const gol_object *o) {
+  return o->kind == GOL_SPACESHIP && o->name != NULL;
+}
+
+/**
+ * @brief Check if the spaceship is past the margin of the active region from
+ * row to end_row and from col to end_col, and flying away from it
+ */
+static int is_escaping(const gol_object *o, int64_t row, int64_t col,
+                       int64_t end_row, int64_t end_col) {
+  return (o->drow < 0 && o->row + o->height + ESCAPE_MARGIN <= row) ||
+         (o->drow > 0 && o->row >= end_row + ESCAPE_MARGIN) ||
+         (o->dcol < 0 && o->col + o->width + ESCAPE_MARGIN <= col) ||
+         (o->dcol > 0 && o->col >= end_col + ESCAPE_MARGIN);
+}
+
+/**
+ * @brief Count the removed spaceship by its name and direction
+ */
+static void escaped_add(gol_universe *u, const gol_object *o) {
+  gol_escaped *e = NULL;
+
+  for (size_t i = 0; i < u->escaped_s; i++)
+    if (u->escaped[i].name == o->name &&
+        u->escaped[i].drow == sign(o->drow) &&
+        u->escaped[i].dcol == sign(o->dcol)) {
+      e = &u->escaped[i];
+      break;
+    }
+
+  if (e == NULL) {
+    gol_escaped *t;
+
+    MEM_CHECK(t = realloc(u->escaped, (u->escaped_s + 1) * sizeof(gol_escaped)));
+    u->escaped = t;
+    e = &u->escaped[u->escaped_s++];
+    *e = (gol_escaped){o->name, sign(o->drow), sign(o->dcol), 0};
+  }
+
+  e->count++;
+}
+
+/**
+ * @brief Remove the spaceships escaping from the universe, which has to be the
+ * universe of the calling thread
+ */
+void escape_remove(gol_universe *u) {
+  gol_object *objects;
+  size_t      size = gol_classify(u, ESCAPE_PERIOD, &objects);
+  int64_t     row = 0, col = 0, end_row = 0, end_col = 0;
+  int         found = 0;
+
+  for (size_t i = 0; i < size; i++) {
+    const gol_object *o = &objects[i];
+
+    if (is_spaceship(o))
+      continue;
+
+    if (!found++) {
+      row = o->row;
+      col = o->col;
+      end_row = o->row + o->height;
+      end_col = o->col + o->width;
+    }
+    row = MIN(row, o->row);
+    col = MIN(col, o->col);
+    end_row = MAX(end_row, o->row + o->height);
+    end_col = MAX(end_col, o->col + o->width);
+  }
+
+  // paged still lifes are not classified, but belong to the active region
+  if (u->paged) {
+    int64_t min_row = INT64_MAX, min_col = INT64_MAX;
+    int64_t max_row = INT64_MIN, max_col = INT64_MIN;
+
+    page_bounds(u, &min_row, &min_col, &max_row, &max_col);
+    if (!found++) {
+      row = min_row;
+      col = min_col;
+      end_row = max_row + 1;
+      end_col = max_col + 1;
+    }
+    row = MIN(row, min_row);
+    col = MIN(col, min_col);
+    end_row = MAX(end_row, max_row + 1);
+    end_col = MAX(end_col, max_col + 1);
+  }
+
+  for (size_t i = 0; found && i < size; i++) {
+    const gol_object *o = &objects[i];
+
+    if (!is_spaceship(o) || !is_escaping(o, row, col, end_row, end_col))
+      continue;
+
+    deleteRegion(o->row, o->col, o->height, o->width);
+    escaped_add(u, o);
+  }
+
+  gol_objects_free(objects, size);
+}
+
+/**
+ * @brief Remove the spaceships escaping from the unlimited universe every
+ * interval generations, or stop removing them if it is 0. Return 0 if the
+ * universe is limited
+ */
+int gol_escape(gol_universe *u, int interval) {
+  if (u->isWrapping && interval > 0)
+    return 0;
+
+  u->escape = MAX(interval, 0);
+  return 1;
+}
+
+/**
+ * @brief Get the counts of the removed spaceships, by name and direction.
+ * Return the number of them
+ *
+ * Counts are valid until the next generation of the universe.
+ */
+size_t gol_escaped_list(const gol_universe *u, const gol_escaped **escaped) {
+  *escaped = u->escaped;
+  return u->escaped_s;
+}
+
+/**
+ * @brief Return the number of removed spaceships
+ */
+uint64_t gol_escaped_total(const gol_universe *u) {
+  uint64_t total = 0;
+
+  for (size_t i = 0; i < u->escaped_s; i++)
+    total += u->escaped[i].count;
+  return total;
+}
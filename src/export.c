@@ -0,0 +1,844 @@
+/**
+ * @file export.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the headless export of the game to images
+ *
+ * Export loads a pattern, evolves it without the user interface and
+ * rasterizes a region of the game every few generations into a sequence of
+ * PPM or PNG images, or into a single animated GIF. Each cell is drawn as a
+ * square of zoom x zoom pixels, in the colour of its state.
+ *
+ * All encoders are implemented here. PNG images use a four colour palette
+ * with two bits per pixel, compressed with deflate using the fixed Huffman
+ * codes and run-length matches, which suits the large uniform areas of the
+ * game. GIF frames are compressed with LZW.
+ *
+ * The game thread only copies the living cells of the region into a queue and
+ * moves on to the next generation, while a pool of worker threads rasterizes
+ * and encodes the frames. Image sequences are written by the workers in any
+ * order, while GIF frames are appended to the file in order as soon as all of
+ * the frames before them are done.
+ */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "export.h"
+#include "file.h"
+#include "format.h"
+#include "gol.h"
+#include "utils.h"
+
+/// Number of frames waiting to be encoded per worker
+#define EXPORT_QUEUE 2
+
+/// Maximum number of pixels in a frame
+#define EXPORT_PIXELS (1L << 30)
+
+/// Maximum width and height of a GIF in pixels, stored in 16 bits
+#define EXPORT_GIF_SIZE 65535
+
+/**
+ * @brief Supported image formats
+ */
+typedef enum export_format {
+  EXPORT_PPM,
+  EXPORT_PNG,
+  EXPORT_GIF,
+  EXPORT_NONE
+} export_format;
+
+static const char *export_ext[] = {"ppm", "png", "gif"};
+
+/// Colours of the cell states, the first one is the background
+static const uint8_t palette[4][3] = {
+    {  0,   0,   0},
+    {255, 255, 255},
+    {255,  64,  64},
+    { 64, 128, 255},
+};
+
+/**
+ * @brief Growing buffer of bytes
+ */
+typedef struct buffer_T {
+  uint8_t *data;     ///< bytes of the buffer
+  size_t   size;     ///< number of bytes used
+  size_t   capacity; ///< number of bytes allocated
+} buffer_T;
+
+/**
+ * @brief Frame waiting to be encoded
+ */
+typedef struct job_T {
+  struct job_T *next;  ///< next frame in the queue
+  int           index; ///< index of the frame
+  gol_cell     *cells; ///< living cells relative to the region
+  size_t        size;  ///< number of cells
+} job_T;
+
+/**
+ * @brief State of the export
+ */
+typedef struct export_T {
+  char           *prefix;   ///< output file name without index and extension
+  export_format   format;   ///< format of the images
+  int             frames;   ///< number of frames
+  int             step;     ///< generations between frames
+  int             zoom;     ///< pixels per cell
+  int             jobs;     ///< number of worker threads
+  int             delay;    ///< GIF frame delay in hundredths of a second
+  int64_t         row;      ///< first row of the region
+  int64_t         col;      ///< first column of the region
+  int             height;   ///< height of the region in cells
+  int             width;    ///< width of the region in cells
+  gol_universe   *universe; ///< game being exported
+
+  pthread_mutex_t lock;    ///< guards the queue and the GIF frames
+  pthread_cond_t  cond;    ///< signals changes of the queue
+  job_T          *head;    ///< oldest frame in the queue
+  job_T          *tail;    ///< newest frame in the queue
+  int             queued;  ///< number of frames in the queue
+  int             done;    ///< no more frames will be queued
+  FILE           *gif;     ///< animated GIF being written
+  buffer_T       *encoded; ///< encoded GIF frames that are not written yet
+  int             next;    ///< index of the next GIF frame to be written
+} export_T;
+
+static export_T export;
+
+static uint32_t crc_table[256];    ///< CRC-32 of each byte
+static uint16_t huffman_code[288]; ///< fixed Huffman codes, bits reversed
+static uint8_t  huffman_bits[288]; ///< lengths of the fixed Huffman codes
+
+/// Base lengths of the deflate length codes 257 to 285
+static const uint16_t length_base[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+
+/// Number of extra bits of the deflate length codes 257 to 285
+static const uint8_t length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                         1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                         4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+/**
+ * @brief Make sure the buffer can hold size more bytes
+ */
+static void buffer_reserve(buffer_T *b, size_t size) {
+  uint8_t *t;
+
+  if (b->size + size <= b->capacity)
+    return;
+
+  b->capacity = MAX(b->capacity * 2, b->size + size);
+  MEM_CHECK(t = realloc(b->data, b->capacity));
+  b->data = t;
+}
+
+/**
+ * @brief Append size bytes to the buffer
+ */
+static void buffer_put(buffer_T *b, const void *data, size_t size) {
+  buffer_reserve(b, size);
+  memcpy(b->data + b->size, data, size);
+  b->size += size;
+}
+
+/**
+ * @brief Append a byte to the buffer
+ */
+static void buffer_byte(buffer_T *b, uint8_t byte) {
+  buffer_reserve(b, 1);
+  b->data[b->size++] = byte;
+}
+
+/**
+ * @brief Append a 32 bit integer to the buffer in the big-endian order
+ */
+static void buffer_be32(buffer_T *b, uint32_t val) {
+  uint8_t bytes[4] = {val >> 24, val >> 16, val >> 8, val};
+  buffer_put(b, bytes, 4);
+}
+
+/**
+ * @brief Append a 16 bit integer to the buffer in the little-endian order
+ */
+static void buffer_le16(buffer_T *b, uint16_t val) {
+  uint8_t bytes[2] = {val, val >> 8};
+  buffer_put(b, bytes, 2);
+}
+
+/**
+ * @brief Writer of bit streams, least significant bit first
+ */
+typedef struct bits_T {
+  buffer_T *out; ///< buffer that the bytes are appended to
+  uint64_t  acc; ///< bits that do not make a byte yet
+  int       n;   ///< number of bits in acc
+} bits_T;
+
+/**
+ * @brief Append the n least significant bits of val to the stream
+ */
+static void bits_put(bits_T *b, uint32_t val, int n) {
+  b->acc |= (uint64_t)val << b->n;
+  b->n += n;
+  while (b->n >= 8) {
+    buffer_byte(b->out, b->acc);
+    b->acc >>= 8;
+    b->n -= 8;
+  }
+}
+
+/**
+ * @brief Pad the stream to a whole byte
+ */
+static void bits_flush(bits_T *b) {
+  if (b->n)
+    buffer_byte(b->out, b->acc);
+  b->acc = 0;
+  b->n = 0;
+}
+
+/**
+ * @brief Reverse the order of the n least significant bits of code
+ */
+static uint16_t reverse_bits(uint16_t code, int n) {
+  uint16_t r = 0;
+
+  while (n--) {
+    r = (r << 1) | (code & 1);
+    code >>= 1;
+  }
+  return r;
+}
+
+/**
+ * @brief Fill in the tables used by the encoders
+ */
+static void export_tables(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++)
+      c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+    crc_table[i] = c;
+  }
+
+  for (int i = 0; i < 288; i++) {
+    if (i < 144)
+      huffman_bits[i] = 8, huffman_code[i] = 0x30 + i;
+    else if (i < 256)
+      huffman_bits[i] = 9, huffman_code[i] = 0x190 + i - 144;
+    else if (i < 280)
+      huffman_bits[i] = 7, huffman_code[i] = i - 256;
+    else
+      huffman_bits[i] = 8, huffman_code[i] = 0xC0 + i - 280;
+    huffman_code[i] = reverse_bits(huffman_code[i], huffman_bits[i]);
+  }
+}
+
+/**
+ * @brief Compute the CRC-32 of the data, continuing from crc
+ */
+static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size) {
+  crc = ~crc;
+  while (size--)
+    crc = crc_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+/**
+ * @brief Compute the Adler-32 checksum of the data
+ */
+static uint32_t adler32(const uint8_t *data, size_t size) {
+  uint32_t a = 1, b = 0;
+
+  while (size) {
+    // largest number of bytes that can't overflow b
+    size_t n = MIN(size, 5552);
+    size -= n;
+    while (n--) {
+      a += *data++;
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+/**
+ * @brief Append a deflate symbol using the fixed Huffman codes
+ */
+static void deflate_symbol(bits_T *b, int symbol) {
+  bits_put(b, huffman_code[symbol], huffman_bits[symbol]);
+}
+
+/**
+ * @brief Append a match of length bytes at distance 1
+ */
+static void deflate_match(bits_T *b, int length) {
+  int i = 28;
+
+  while (length_base[i] > length)
+    i--;
+
+  deflate_symbol(b, 257 + i);
+  bits_put(b, length - length_base[i], length_extra[i]);
+  bits_put(b, 0, 5); // distance code 0, distance 1
+}
+
+/**
+ * @brief Compress the data into a zlib stream with a single deflate block
+ * using the fixed Huffman codes, where runs of the same byte are matches
+ */
+static void deflate(buffer_T *out, const uint8_t *data, size_t size) {
+  bits_T b = {out, 0, 0};
+  size_t i = 0;
+
+  buffer_byte(out, 0x78); // deflate with 32K window
+  buffer_byte(out, 0x01); // no dictionary, fastest compression
+
+  bits_put(&b, 1, 1); // final block
+  bits_put(&b, 1, 2); // fixed Huffman codes
+
+  while (i < size) {
+    size_t run = 0;
+
+    if (i > 0)
+      while (i + run < size && run < 258 && data[i + run] == data[i - 1])
+        run++;
+
+    if (run >= 3) {
+      deflate_match(&b, run);
+      i += run;
+    } else {
+      deflate_symbol(&b, data[i++]);
+    }
+  }
+
+  deflate_symbol(&b, 256); // end of block
+  bits_flush(&b);
+  buffer_be32(out, adler32(data, size));
+}
+
+/**
+ * @brief Append a PNG chunk
+ */
+static void png_chunk(buffer_T *out, const char *type, const uint8_t *data,
+                      size_t size) {
+  uint32_t crc = crc32(0, (const uint8_t *)type, 4);
+
+  buffer_be32(out, size);
+  buffer_put(out, type, 4);
+  if (size)
+    buffer_put(out, data, size);
+  buffer_be32(out, crc32(crc, data, size));
+}
+
+/**
+ * @brief Encode the pixels as a PNG image with a palette of four colours,
+ * using tmp as the scratch buffer
+ */
+static void png_encode(buffer_T *out, buffer_T *tmp, const uint8_t *pixels,
+                       int w, int h) {
+  static const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+  size_t               line = (w + 3) / 4;
+  buffer_T             header = {0};
+
+  buffer_put(out, signature, sizeof(signature));
+
+  buffer_be32(&header, w);
+  buffer_be32(&header, h);
+  buffer_put(&header, (uint8_t[]){2, 3, 0, 0, 0}, 5); // 2 bit palette
+  png_chunk(out, "IHDR", header.data, header.size);
+  free(header.data);
+
+  png_chunk(out, "PLTE", &palette[0][0], sizeof(palette));
+
+  // scanlines, each one starting with filter type 0
+  tmp->size = 0;
+  buffer_reserve(tmp, (line + 1) * h);
+  memset(tmp->data, 0, (line + 1) * h);
+  for (int y = 0; y < h; y++) {
+    uint8_t       *p = tmp->data + (line + 1) * y + 1;
+    const uint8_t *row = pixels + (size_t)w * y;
+    for (int x = 0; x < w; x++)
+      p[x >> 2] |= row[x] << (6 - 2 * (x & 3));
+  }
+  tmp->size = (line + 1) * h;
+
+  header = (buffer_T){0};
+  deflate(&header, tmp->data, tmp->size);
+  png_chunk(out, "IDAT", header.data, header.size);
+  free(header.data);
+
+  png_chunk(out, "IEND", NULL, 0);
+}
+
+/**
+ * @brief Encode the pixels as a PPM image
+ */
+static void ppm_encode(buffer_T *out, const uint8_t *pixels, int w, int h) {
+  char   header[64];
+  size_t size = (size_t)w * h;
+
+  buffer_put(out, header, sprintf(header, "P6\n%d %d\n255\n", w, h));
+  buffer_reserve(out, size * 3);
+  for (size_t i = 0; i < size; i++)
+    buffer_put(out, palette[pixels[i]], 3);
+}
+
+/**
+ * @brief Append the n bit LZW code to the GIF stream, packing full bytes
+ * into sub-blocks of at most 255 bytes
+ */
+static void gif_code(bits_T *b, buffer_T *block, uint32_t code, int n) {
+  bits_T bytes = {block, b->acc, b->n};
+
+  bits_put(&bytes, code, n);
+  b->acc = bytes.acc;
+  b->n = bytes.n;
+
+  if (block->size >= 255) {
+    buffer_byte(b->out, 255);
+    buffer_put(b->out, block->data, 255);
+    memmove(block->data, block->data + 255, block->size - 255);
+    block->size -= 255;
+  }
+}
+
+/**
+ * @brief Encode the pixels as a GIF frame compressed with LZW, with the
+ * graphic control extension holding the delay
+ */
+static void gif_encode(buffer_T *out, const uint8_t *pixels, int w, int h) {
+  static const int clear = 4, end = 5;
+  uint16_t(*child)[4];
+  buffer_T block = {0};
+  bits_T   b = {out, 0, 0};
+  size_t   size = (size_t)w * h;
+  int      next = end + 1, n = 3, prefix;
+
+  MEM_CHECK(child = calloc(4096, sizeof(*child)));
+
+  buffer_put(out, (uint8_t[]){0x21, 0xF9, 4, 0}, 4);
+  buffer_le16(out, export.delay);
+  buffer_put(out, (uint8_t[]){0, 0}, 2);
+
+  buffer_byte(out, 0x2C); // image descriptor
+  buffer_le16(out, 0);
+  buffer_le16(out, 0);
+  buffer_le16(out, w);
+  buffer_le16(out, h);
+  buffer_byte(out, 0);
+  buffer_byte(out, 2); // minimum code size
+
+  gif_code(&b, &block, clear, n);
+  prefix = pixels[0];
+  for (size_t i = 1; i < size; i++) {
+    int k = pixels[i];
+
+    if (child[prefix][k]) {
+      prefix = child[prefix][k];
+      continue;
+    }
+
+    gif_code(&b, &block, prefix, n);
+    if (next < 4096) {
+      if (next == 1 << n)
+        n++;
+      child[prefix][k] = next++;
+    } else {
+      gif_code(&b, &block, clear, n);
+      memset(child, 0, 4096 * sizeof(*child));
+      next = end + 1;
+      n = 3;
+    }
+    prefix = k;
+  }
+  gif_code(&b, &block, prefix, n);
+  gif_code(&b, &block, end, n);
+
+  // remaining bits and bytes
+  {
+    bits_T bytes = {&block, b.acc, b.n};
+    bits_flush(&bytes);
+  }
+  for (size_t i = 0; i < block.size; i += 255) {
+    size_t len = MIN(block.size - i, 255);
+    buffer_byte(out, len);
+    buffer_put(out, block.data + i, len);
+  }
+  buffer_byte(out, 0);
+
+  free(block.data);
+  free(child);
+}
+
+/**
+ * @brief Write the start of the animated GIF
+ */
+static void gif_start(FILE *f, int w, int h) {
+  buffer_T out = {0};
+
+  buffer_put(&out, "GIF89a", 6);
+  buffer_le16(&out, w);
+  buffer_le16(&out, h);
+  buffer_byte(&out, 0x91); // global palette of four colours
+  buffer_byte(&out, 0);
+  buffer_byte(&out, 0);
+  buffer_put(&out, &palette[0][0], sizeof(palette));
+
+  // loop forever
+  buffer_put(&out, (uint8_t[]){0x21, 0xFF, 11}, 3);
+  buffer_put(&out, "NETSCAPE2.0", 11);
+  buffer_put(&out, (uint8_t[]){3, 1, 0, 0, 0}, 5);
+
+  fwrite(out.data, 1, out.size, f);
+  free(out.data);
+}
+
+/**
+ * @brief Draw the cells of the frame into pixels
+ */
+static void export_raster(const job_T *job, uint8_t *pixels) {
+  int    zoom = export.zoom;
+  size_t w = (size_t)export.width * zoom;
+
+  memset(pixels, 0, w * export.height * zoom);
+  for (size_t i = 0; i < job->size; i++) {
+    const gol_cell *c = &job->cells[i];
+    uint8_t        *p = pixels + c->row * zoom * w + (size_t)c->col * zoom;
+    for (int y = 0; y < zoom; y++, p += w)
+      memset(p, MIN(c->val, 3), zoom);
+  }
+}
+
+/**
+ * @brief Take the next frame from the queue, NULL when there are no more
+ */
+static job_T *export_pop(void) {
+  job_T *job;
+
+  pthread_mutex_lock(&export.lock);
+  while (!export.head && !export.done)
+    pthread_cond_wait(&export.cond, &export.lock);
+
+  if ((job = export.head)) {
+    if (!(export.head = job->next))
+      export.tail = NULL;
+    export.queued--;
+    pthread_cond_broadcast(&export.cond);
+  }
+  pthread_mutex_unlock(&export.lock);
+  return job;
+}
+
+/**
+ * @brief Store the encoded GIF frame and write all of the frames that are
+ * next in order
+ */
+static void export_gif_frame(int index, buffer_T *out) {
+  pthread_mutex_lock(&export.lock);
+  export.encoded[index] = *out;
+  *out = (buffer_T){0};
+
+  while (export.next < export.frames && export.encoded[export.next].data) {
+    buffer_T *frame = &export.encoded[export.next++];
+    fwrite(frame->data, 1, frame->size, export.gif);
+    free(frame->data);
+    frame->data = NULL;
+  }
+  pthread_mutex_unlock(&export.lock);
+}
+
+/**
+ * @brief Rasterize, encode and write the queued frames
+ */
+static void *export_worker(void *arg) {
+  int      w = export.width * export.zoom, h = export.height * export.zoom;
+  buffer_T out = {0}, tmp = {0};
+  uint8_t *pixels;
+  job_T   *job;
+
+  MEM_CHECK(pixels = malloc((size_t)w * h));
+
+  while ((job = export_pop())) {
+    export_raster(job, pixels);
+
+    out.size = 0;
+    switch (export.format) {
+    case EXPORT_PPM:
+      ppm_encode(&out, pixels, w, h);
+      break;
+    case EXPORT_PNG:
+      png_encode(&out, &tmp, pixels, w, h);
+      break;
+    default:
+      gif_encode(&out, pixels, w, h);
+      break;
+    }
+
+    if (export.format == EXPORT_GIF) {
+      export_gif_frame(job->index, &out);
+    } else {
+      char  name[FILENAME_MAX];
+      FILE *f;
+
+      snprintf(name, sizeof(name), "%s%06d.%s", export.prefix, job->index,
+               export_ext[export.format]);
+      if ((f = fopen(name, "wb")) == NULL)
+        err("Can't write %s\n", name);
+      fwrite(out.data, 1, out.size, f);
+      fclose(f);
+    }
+
+    free(job->cells);
+    free(job);
+  }
+
+  free(out.data);
+  free(tmp.data);
+  free(pixels);
+  return NULL;
+}
+
+/**
+ * @brief Copy the living cells of the region into a new frame and queue it,
+ * waiting while the queue is full
+ */
+static void export_push(int index) {
+  job_T *job;
+
+  MEM_CHECK(job = calloc(1, sizeof(job_T)));
+  job->index = index;
+  job->size = gol_query(export.universe, export.row, export.col,
+                        export.height, export.width, &job->cells);
+
+  pthread_mutex_lock(&export.lock);
+  while (export.queued >= export.jobs * EXPORT_QUEUE)
+    pthread_cond_wait(&export.cond, &export.lock);
+
+  if (export.tail)
+    export.tail->next = job;
+  else
+    export.head = job;
+  export.tail = job;
+  export.queued++;
+
+  pthread_cond_broadcast(&export.cond);
+  pthread_mutex_unlock(&export.lock);
+}
+
+/**
+ * @brief Print the usage of the export
+ */
+static void export_usage(char *name) {
+  fprintf(stderr,
+          "Usage: %s [options] pattern\n"
+          "Export the evolution of the pattern to images\n\n"
+          "  -o prefix      output file name prefix (default: frame)\n"
+          "  -f format      ppm, png or gif (default: png)\n"
+          "  -n frames      number of frames (default: 1)\n"
+          "  -g gens        generations between frames (default: 1)\n"
+          "  -z zoom        pixels per cell (default: 1)\n"
+          "  -s HxW         size of the game, unlimited if not set\n"
+          "  -r Y,X,HxW     region to export (default: whole game, or the\n"
+          "                 bounding box of the pattern if unlimited)\n"
+          "  -m mode        index of the game mode (default: from pattern)\n"
+          "  -j jobs        number of worker threads (default: processors)\n"
+          "  -d delay       GIF frame delay in 1/100 s (default: 10)\n"
+          "  -e gens        remove spaceships escaping the unlimited game every\n"
+          "                 gens generations (default: 0, never)\n",
+          name);
+  exit(1);
+}
+
+/**
+ * @brief Create the game from the pattern, the game mode is taken from the
+ * pattern unless mode is set
+ */
+static void export_load(char *name, int height, int width, int mode) {
+  cells_T cells = {0};
+  int     file_mode = file_read(name, &cells);
+
+  if (file_mode < 0 && !cells.size)
+    err("Can't read pattern %s\n", name);
+
+  if (mode < 0)
+    mode = file_mode < 0 ? 0 : file_mode;
+
+  if ((export.universe = gol_create(height, width, mode)) == NULL)
+    err("Invalid game mode %d\n", mode);
+
+  gol_seed(export.universe, time(NULL));
+  gol_insert(export.universe, cells.cells, cells.size);
+  cells_free(&cells);
+}
+
+/**
+ * @brief Run the export from the command line
+ */
+int export_main(int argc, char *argv[]) {
+  gol_memory memory;
+  pthread_t *workers;
+  size_t     population;
+  int        mode = -1, region = 0, height = 0, width = 0, escape = 0, opt;
+  clock_t    start = clock();
+  time_t     wall = time(NULL);
+
+  export.prefix = "frame";
+  export.format = EXPORT_PNG;
+  export.frames = 1;
+  export.step = 1;
+  export.zoom = 1;
+  export.delay = 10;
+  export.jobs = gol_threads();
+
+  while ((opt = getopt(argc, argv, "o:f:n:g:z:s:r:m:j:d:e:h")) != -1) {
+    switch (opt) {
+    case 'o':
+      export.prefix = optarg;
+      break;
+    case 'f':
+      for (export.format = 0; export.format < EXPORT_NONE; export.format++)
+        if (!strcmp(optarg, export_ext[export.format]))
+          break;
+      if (export.format == EXPORT_NONE)
+        export_usage(argv[0]);
+      break;
+    case 'n':
+      export.frames = atoi(optarg);
+      break;
+    case 'g':
+      export.step = atoi(optarg);
+      break;
+    case 'z':
+      export.zoom = atoi(optarg);
+      break;
+    case 's':
+      if (sscanf(optarg, "%dx%d", &height, &width) != 2)
+        export_usage(argv[0]);
+      break;
+    case 'r':
+      if (sscanf(optarg, "%" SCNd64 ",%" SCNd64 ",%dx%d", &export.row,
+                 &export.col, &export.height, &export.width) != 4)
+        export_usage(argv[0]);
+      region = 1;
+      break;
+    case 'm':
+      mode = atoi(optarg);
+      break;
+    case 'j':
+      export.jobs = atoi(optarg);
+      break;
+    case 'd':
+      export.delay = atoi(optarg);
+      break;
+    case 'e':
+      escape = atoi(optarg);
+      break;
+    default:
+      export_usage(argv[0]);
+    }
+  }
+
+  if (optind != argc - 1 || export.frames < 1 || export.step < 0 ||
+      export.zoom < 1 || export.jobs < 1 || height < 0 || width < 0 ||
+      !height != !width || escape < 0 || (escape && height))
+    export_usage(argv[0]);
+
+  export_load(argv[optind], height, width, mode);
+  gol_escape(export.universe, escape);
+
+  if (!region) {
+    if (height && width) {
+      export.height = height;
+      export.width = width;
+    } else {
+      int64_t h, w;
+
+      if (!gol_bounds(export.universe, &export.row, &export.col, &h, &w))
+        err("Pattern is empty, set the region with -r\n");
+      export.height = MIN(h, INT_MAX);
+      export.width = MIN(w, INT_MAX);
+    }
+  }
+
+  if (export.height < 1 || export.width < 1 ||
+      (double)export.height * export.width * export.zoom * export.zoom >
+          EXPORT_PIXELS)
+    err("Invalid region size %dx%d\n", export.height, export.width);
+
+  if (export.format == EXPORT_GIF &&
+      ((long)export.height * export.zoom > EXPORT_GIF_SIZE ||
+       (long)export.width * export.zoom > EXPORT_GIF_SIZE))
+    err("GIF of %ldx%ld pixels is larger than %dx%d\n",
+        (long)export.height * export.zoom, (long)export.width * export.zoom,
+        EXPORT_GIF_SIZE, EXPORT_GIF_SIZE);
+
+  export_tables();
+  pthread_mutex_init(&export.lock, NULL);
+  pthread_cond_init(&export.cond, NULL);
+
+  if (export.format == EXPORT_GIF) {
+    char name[FILENAME_MAX];
+
+    snprintf(name, sizeof(name), "%s.gif", export.prefix);
+    if ((export.gif = fopen(name, "wb")) == NULL)
+      err("Can't write %s\n", name);
+    MEM_CHECK(export.encoded = calloc(export.frames, sizeof(buffer_T)));
+    gif_start(export.gif, export.width * export.zoom,
+              export.height * export.zoom);
+  }
+
+  MEM_CHECK(workers = malloc(export.jobs * sizeof(pthread_t)));
+  for (int i = 0; i < export.jobs; i++)
+    if (pthread_create(&workers[i], NULL, export_worker, NULL) != 0)
+      err("Can't start the export workers\n");
+
+  for (int i = 0; i < export.frames; i++) {
+    export_push(i);
+    if (i + 1 < export.frames)
+      gol_evolve(export.universe, export.step);
+  }
+
+  pthread_mutex_lock(&export.lock);
+  export.done = 1;
+  pthread_cond_broadcast(&export.cond);
+  pthread_mutex_unlock(&export.lock);
+
+  for (int i = 0; i < export.jobs; i++)
+    pthread_join(workers[i], NULL);
+  free(workers);
+
+  if (export.gif) {
+    fputc(0x3B, export.gif); // trailer
+    fclose(export.gif);
+    free(export.encoded);
+  }
+
+  population = gol_population(export.universe);
+  gol_memory_usage(export.universe, &memory);
+  gol_destroy(export.universe);
+  printf("Exported %d frames of %dx%d pixels in %lds (%.1fs of CPU)\n",
+         export.frames, export.width * export.zoom,
+         export.height * export.zoom, (long)(time(NULL) - wall),
+         (double)(clock() - start) / CLOCKS_PER_SEC);
+  printf("Memory: %lu bytes, %.1f per living cell (cells %lu, index %lu, "
+         "history %lu, cache %lu)\n",
+         (unsigned long)memory.total,
+         population ? (double)memory.total / population : 0.0,
+         (unsigned long)memory.cells, (unsigned long)memory.index,
+         (unsigned long)memory.history, (unsigned long)memory.cache);
+  return 0;
+}
@@ -11,8 +11,10 @@
  * just a pattern.
  */
 
-#include <dirent.h>
+#include <inttypes.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -20,8 +22,12 @@
 #include <unistd.h>
 
 #include "display.h"
+#include "format.h"
 #include "game.h"
+#include "library.h"
 #include "logic.h"
+#include "record.h"
+#include "snapshot.h"
 #include "utils.h"
 
 #ifdef _WIN32
@@ -72,270 +78,415 @@ void file_setup(void) {
   free(dir);
 }
 
-typedef struct file_T *file_T;
-
-/**
- * @brief A node in a linked list of file names
- */
-struct file_T {
-  file_T next; ///< pointer to the next node
-  char  *name; ///< name of a file
-};
-
-static file_T loaded_files;
-
 /**
- * @brief create new file_T
+ * @brief Return array of the library entries that have the specific extension,
+ * sorted by name
  *
- * Allocate the memory for a new file_T. The name field will be set to NULL if
- * NULL is provided as name, otherwise it will be set to a DUPLICATE of a
- * string provided.
+ * Memory for the buffer is allocated automatically and should be freed with
+ * free() after it's no longer needed.
  */
-file_T file_new(char *name) {
-  file_T f;
-  MEM_CHECK(f = calloc(1, sizeof(*f)));
+int file_select_extension(char *ext, library_T ***buffer) {
+  int size = 0;
 
-  if (name != NULL) {
-    MEM_CHECK(f->name = malloc((strlen(name) + 1) * sizeof(char)));
-    strcpy(f->name, name);
-  }
+  MEM_CHECK(*buffer = malloc((library_entries_s + 1) * sizeof(library_T *)));
+  for (int i = 0; i < library_entries_s; i++)
+    if (!strcmp(library_entries[i]->ext, ext))
+      (*buffer)[size++] = library_entries[i];
 
-  return f;
+  return size;
 }
 
 /**
- * @brief Free the linked list of file_T
+ * @brief Bring the pattern library up to date with the current directory
  */
-void file_free(file_T self) {
-  if (self == NULL)
-    return;
-
-  file_free(self->next);
-  free(self->name);
-  free(self);
-}
+void load_files(void) { library_update(); }
 
 /**
- * @brief Add file of a specific name to the begin of a linked list
- *
- * First item of the list will be skipped and unchanged.
+ * @brief Free the pattern library
  */
-file_T file_add(file_T self, char *name) {
-  file_T new = file_new(name);
-  new->next = self->next;
-  self->next = new;
-  return new;
-}
+void free_files(void) { library_free(); }
 
-/**
- * @brief Sort linked list in a lexicographical order
- */
-void file_sort(file_T self) {
-  for (file_T p = self->next; p; p = p->next)
-    for (file_T t = p->next; t; t = t->next)
-      if (strcmp(p->name, t->name) > 0) {
-        char *tmp = p->name;
-        p->name = t->name;
-        t->name = tmp;
-      }
-}
+// from game.c
+extern coord_val *save_cells;   ///< Packed cells to be saved in a pattern
+extern int        save_cells_s; ///< Size of save_cells
+extern int64_t    pos_y;        ///< Real cursor y coordinate
+extern int64_t    pos_x;        ///< Real cursor x coordinate
+extern int        height;       ///< height of the current game
+extern int        width;        ///< width of the current game
 
 /**
- * @brief Return a new linked list of files contained in the current directory
+ * @brief Check if the file with name is a binary snapshot
  */
-file_T file_fromDirectory(void) {
-  file_T base = file_new(NULL);
-
-  struct dirent *de;
-  DIR           *dr = opendir(".");
-  if (dr == NULL)
-    return NULL;
-
-  while ((de = readdir(dr)) != NULL)
-    file_add(base, de->d_name);
-
-  file_sort(base);
-  file_T n = base->next;
-
-  free(base);
-  free(dr);
-
-  return n;
+int file_is_snapshot(char *name) {
+  char *dot = strrchr(name, '.');
+  return dot != NULL && !strcmp(dot + 1, SNAPSHOT_EXT);
 }
 
 /**
- * @brief Check if file is in the linked list, return NULL if it's not
+ * @brief Check if the file with name is a recording
  */
-file_T file_find(file_T self, char *name) {
-  for (; self != NULL; self = self->next) {
-    if (!strcmp(self->name, name))
-      return self;
-  }
-  return NULL;
+int file_is_recording(char *name) {
+  char *dot = strrchr(name, '.');
+  return dot != NULL && !strcmp(dot + 1, RECORD_EXT);
 }
 
 /**
- * @brief Return array of the filenames that have the specific extension
- *
- * Memory for the buffer is allocated automatically and should be freed with
- * free() after it's no longer needed.
+ * @brief Read the lines of "row col value" triples until the end of the file
  */
-int file_select_extension(char *ext, char ***buffer) {
-  int    maxsize = 4;
-  int    size = 0;
-  char **tmp = NULL;
-  file_T current = loaded_files;
-
-  MEM_CHECK(*buffer = malloc(maxsize * sizeof(char *)));
-  for (; current != NULL; current = current->next) {
-    char *dot = strrchr(current->name, '.');
-    if (dot == NULL)
-      continue;
-    if (!strcmp(dot + 1, ext)) {
-      *dot = '\0';
-      (*buffer)[size++] = current->name;
-      if (size == maxsize) {
-        maxsize *= 2;
-        MEM_CHECK(tmp = realloc(*buffer, maxsize * sizeof(char *)));
-        *buffer = tmp;
-      }
-    }
-  }
-  if (size) {
-    MEM_CHECK(tmp = realloc(*buffer, size * sizeof(char *)));
-    *buffer = tmp;
-  }
+static void file_read_cells(FILE *f, cells_T *cells) {
+  int64_t row, col;
+  int     val;
 
-  return size;
+  while (fscanf(f, "%" SCNd64 " %" SCNd64 " %d", &row, &col, &val) == 3)
+    cells_push(cells, row, col, val);
 }
 
 /**
- * @brief Fill loaded_files linked list with files in the current directory,
- * freeing any previous lists
+ * @brief Read a pattern in one of the standard formats from the file with name
+ * into cells
  */
-void load_files(void) {
-  if (loaded_files)
-    file_free(loaded_files);
-  loaded_files = file_fromDirectory();
+void file_import(char *name, cells_T *cells) {
+  FILE *f;
+
+  FILE_CHECK(f = fopen(name, "r"));
+  format_read(f, format_from_name(name), cells);
+  fclose(f);
 }
 
 /**
- * @brief Free loaded_files linked list
+ * @brief Read a pattern from the file with name and extension .part into cells
+ * in a single pass
  */
-void free_files(void) { file_free(loaded_files); }
+void file_import_part(char *name, cells_T *cells) {
+  FILE *f;
+  char *fname;
 
-// from logic.c
-extern Cell **save_cells;   ///< List of Cells to be saved in a pattern
-extern int    save_cells_s; ///< Size of save_cells
-extern int    pos_y;        ///< Real cursor y coordinate
-extern int    pos_x;        ///< Real cursor x coordinate
-extern int    evolve_index; ///< index of the current game mode
+  MEM_CHECK(fname = malloc((strlen(name) + 6) * sizeof(char)));
+  sprintf(fname, "%s.part", name);
 
-// form game.c
-extern int height; ///< height of the current game
-extern int width;  ///< width of the current game
+  FILE_CHECK(f = fopen(fname, "r"));
+  file_read_cells(f, cells);
+
+  fclose(f);
+  free(fname);
+}
 
 /**
- * @brief Load a pattern to the current cursor position from a file with name
- * and extension .part
+ * @brief Read the cells of any supported file with name, including its
+ * extension, into cells. Return the index of the game mode, or -1 if unknown
+ *
+ * Unlike the loaders, a file that can't be read is not an error and leaves
+ * cells empty.
  */
-void file_load_pattern(char *name, int index) {
+int file_read(char *name, cells_T *cells) {
   FILE *f;
-  char *fname;
-  int   min_y = INT_MAX, min_x = INT_MAX, max_y = -1, max_x = -1;
-  int   row, col, val;
+  char *dot = strrchr(name, '.');
+  int   h, w, mode = -1;
 
-  MEM_CHECK(fname = malloc((strlen(name) + 5) * sizeof(char)));
-  sprintf(fname, "%s.part", name);
+  if (dot == NULL)
+    return -1;
 
-  FILE_CHECK(f = fopen(fname, "r"));
+  if (file_is_snapshot(name)) {
+    snapshot_T info;
 
-  while (fscanf(f, "%d %d %d", &row, &col, &val) != EOF) {
-    min_y = MIN(min_y, row);
-    min_x = MIN(min_x, col);
-    max_y = MAX(max_y, row);
-    max_x = MAX(max_x, col);
+    mode = snapshot_read(name, &info, cells) ? info.mode : -1;
+    return mode;
   }
 
-  for (int i = min_y; i <= max_y; i++)
-    for (int j = min_x; j <= max_x; j++)
-      setAt(i + pos_y, j + pos_x, 0);
+  if (file_is_recording(name))
+    return record_read(name, cells);
+
+  if ((f = fopen(name, "r")) == NULL)
+    return -1;
 
-  rewind(f);
-  while (fscanf(f, "%d %d %d", &row, &col, &val) != EOF)
-    if (height != 0 && width != 0)
-      setAt(WCLAMP(pos_y + row, height), WCLAMP(pos_x + col, width), val);
-    else
-      setAt(pos_y + row, pos_x + col, val);
+  if (format_from_name(name) != FORMAT_NONE) {
+    format_read(f, format_from_name(name), cells);
+    mode = cells->rule;
+  } else {
+    if (!strcmp(dot + 1, "all") && fscanf(f, "%d %d %d", &h, &w, &mode) != 3)
+      mode = -1;
+    file_read_cells(f, cells);
+  }
+
+  fclose(f);
+  return mode;
+}
+
+/**
+ * @brief Load a pattern to the current cursor position from a file with name
+ * and extension .part, or from a file in one of the standard formats if name
+ * has its extension
+ *
+ * The pattern replaces all cells in its bounding box.
+ */
+void file_load_pattern(char *name, int index) {
+  cells_T cells = {0};
+
+  if (format_from_name(name) != FORMAT_NONE)
+    file_import(name, &cells);
+  else
+    file_import_part(name, &cells);
+
+  setRegion(pos_y, pos_x, cells.cells, cells.size);
+  cells_free(&cells);
 }
 
+/// Last save was refused because its format can't hold the cells
+static int save_refused;
+
 /**
- * @brief Save a pattern of cells referenced in save_cells array to a file with
- * name and extension .part
+ * @brief Save a pattern of cells packed in save_cells array to a file with
+ * name and extension .part, or in one of the standard formats if name has its
+ * extension
  */
 void file_save_pattern(char *name, int index) {
   FILE *f;
   char *fname;
+  int   format = format_from_name(name);
+
+  save_refused = format != FORMAT_NONE &&
+                 !format_supports(format, save_cells, save_cells_s);
+  if (save_refused)
+    return;
+
+  if (format != FORMAT_NONE) {
+    FILE_CHECK(f = fopen(name, "w"));
+    format_write(f, format, save_cells, save_cells_s, universe->evolve_index,
+                 NULL);
+    fclose(f);
+    return;
+  }
 
   MEM_CHECK(fname = malloc((strlen(name) + 6) * sizeof(char)));
   sprintf(fname, "%s.part", name);
 
   FILE_CHECK(f = fopen(fname, "w"));
 
-  int min_y = save_cells[0]->cord.row;
-  int min_x = save_cells[0]->cord.col;
+  int64_t min_y = INT64_MAX, min_x = INT64_MAX;
   for (int i = 0; i < save_cells_s; i++) {
-    Cell *c = save_cells[i];
-    min_y = MIN(min_y, c->cord.row);
-    min_x = MIN(min_x, c->cord.col);
+    min_y = MIN(min_y, save_cells[i].row);
+    min_x = MIN(min_x, save_cells[i].col);
   }
 
   for (int i = 0; i < save_cells_s; i++) {
-    Cell *c = save_cells[i];
-    fprintf(f, "%d %d %d\n", c->cord.row - min_y, c->cord.col - min_x, c->val);
+    coord_val *c = &save_cells[i];
+    fprintf(f, "%" PRId64 " %" PRId64 " %d\n", c->row - min_y, c->col - min_x,
+            c->val);
   }
 
   fclose(f);
 }
 
 /**
- * @brief Load the game from the file with name and extension .all
+ * @brief Collect all living cells of the current game into a packed buffer
+ */
+void file_collect(cells_T *cells) {
+  coord_val *all, *t;
+  size_t     size = logic_collect(&all);
+
+  MEM_CHECK(t = realloc(cells->cells,
+                        (cells->size + size + 1) * sizeof(coord_val)));
+  cells->cells = t;
+  cells->capacity = cells->size + size + 1;
+
+  memcpy(cells->cells + cells->size, all, size * sizeof(coord_val));
+  cells->size += size;
+  free(all);
+}
+
+/**
+ * @brief Load the game from the file with name and extension .all, or from the
+ * binary snapshot, or start an unlimited game with a pattern in one of the
+ * standard formats if name has its extension
  */
 void file_load(char *name, int index) {
-  FILE *f;
-  char *fname;
-  int   w, h;
+  cells_T cells = {0};
+  FILE   *f;
+  char   *fname;
+  int     w, h, mode;
+
+  if (file_is_snapshot(name)) {
+    snapshot_T info;
+
+    if (!snapshot_read(name, &info, &cells))
+      err("Invalid snapshot %s", name);
+
+    logic_insert_bulk(cells.cells, cells.size);
+    cells_free(&cells);
+
+    setSeed(info.seed);
+    game(info.height, info.width, info.mode, info.generation);
+    return;
+  }
+
+  if (file_is_recording(name)) {
+    replay_load(name, index);
+    return;
+  }
+
+  if (format_from_name(name) != FORMAT_NONE) {
+    file_import(name, &cells);
+    logic_insert_bulk(cells.cells, cells.size);
+    cells_free(&cells);
+
+    game(0, 0, cells.rule < 0 ? 0 : cells.rule, 0);
+    return;
+  }
 
   MEM_CHECK(fname = malloc((strlen(name) + 5) * sizeof(char)));
   sprintf(fname, "%s.all", name);
 
   FILE_CHECK(f = fopen(fname, "r"));
 
-  fscanf(f, "%d %d %d", &h, &w, &evolve_index);
-  int row, col, val;
-  while (fscanf(f, "%d %d %d", &row, &col, &val) != EOF) {
-    setAt(row, col, val);
+  fscanf(f, "%d %d %d", &h, &w, &mode);
+  file_read_cells(f, &cells);
+
+  fclose(f);
+  free(fname);
+
+  logic_insert_bulk(cells.cells, cells.size);
+  cells_free(&cells);
+
+  game(h, w, mode, 0);
+}
+
+/**
+ * @brief A save of the game that is written in the background
+ */
+typedef struct save_T {
+  FILE         *f;        ///< file that is being written
+  int           format;   ///< format of the file, FORMAT_NONE for .all
+  int           snapshot; ///< write the file as a binary snapshot
+  snapshot_T    info;     ///< information about the game
+  cells_T       cells;    ///< copy of the living cells
+  atomic_size_t done;     ///< number of cells written so far
+  atomic_int    finished; ///< the file has been written and closed
+} save_T;
+
+static save_T    save_job;     ///< save that is currently being written
+static pthread_t save_thread;  ///< thread writing save_job
+static int       save_running; ///< save_thread has not been joined yet
+
+/// Number of cells written between the updates of the progress
+#define SAVE_STEP 4096
+
+/**
+ * @brief Report the number of cells of save_job written so far
+ */
+static void file_save_done(size_t done) { atomic_store(&save_job.done, done); }
+
+/**
+ * @brief Write the save job passed as arg, run on the save thread
+ */
+static void *file_save_worker(void *arg) {
+  save_T    *job = arg;
+  coord_val *c = job->cells.cells;
+  size_t     size = job->cells.size;
+
+  setvbuf(job->f, NULL, _IOFBF, 1 << 20);
+
+  if (job->snapshot) {
+    snapshot_write(job->f, &job->info, c, size, file_save_done);
+  } else if (job->format != FORMAT_NONE) {
+    format_write(job->f, job->format, c, size, job->info.mode, file_save_done);
+  } else {
+    fprintf(job->f, "%d %d %d\n", job->info.height, job->info.width,
+            job->info.mode);
+    for (size_t i = 0; i < size; i++) {
+      fprintf(job->f, "%" PRId64 " %" PRId64 " %d\n", c[i].row, c[i].col,
+              c[i].val);
+      if (i % SAVE_STEP == 0)
+        atomic_store(&job->done, i);
+    }
+  }
+
+  fclose(job->f);
+  atomic_store(&job->done, size);
+  atomic_store(&job->finished, 1);
+  return NULL;
+}
+
+/**
+ * @brief Wait for the save that is being written, if any, and release it
+ */
+void file_save_wait(void) {
+  if (!save_running)
+    return;
+
+  pthread_join(save_thread, NULL);
+  cells_free(&save_job.cells);
+  save_running = 0;
+}
+
+/**
+ * @brief Return the percentage of the save that has been written, or -1 if
+ * no save is being written
+ */
+int file_save_progress(void) {
+  if (!save_running)
+    return -1;
+
+  if (atomic_load(&save_job.finished)) {
+    file_save_wait();
+    return -1;
   }
 
-  game(h, w, evolve_index);
+  size_t size = save_job.cells.size;
+  return size ? atomic_load(&save_job.done) * 100 / size : 0;
 }
 
 /**
- * @brief Save the current game to the file with name and extension .all
+ * @brief Return 1 if the last save was refused because its format can't hold
+ * the cells, see format_supports()
+ */
+int file_save_refused(void) { return save_refused; }
+
+/**
+ * @brief Save the current game to the file with name and extension .all, or
+ * as a binary snapshot, or export its cells in one of the standard formats if
+ * name has its extension
+ *
+ * Living cells are copied into a packed buffer, which is then written on a
+ * separate thread so that the game can continue in the meantime. Progress is
+ * reported by file_save_progress().
  */
 void file_save(char *name, int index) {
-  FILE *f;
   char *fname;
 
-  MEM_CHECK(fname = malloc((strlen(name) + 5) * sizeof(char)));
-  sprintf(fname, "%s.all", name);
+  file_save_wait();
 
-  FILE_CHECK(f = fopen(fname, "w"));
+  save_job.snapshot = file_is_snapshot(name);
+  save_job.format = format_from_name(name);
+  save_job.info = (snapshot_T){height, width, universe->evolve_index,
+                               universe->seed, gen};
 
-  fprintf(f, "%d %d %d\n", height, width, evolve_index);
-  for (Cell *c = hash; c != NULL; c = c->hh.next) {
-    fprintf(f, "%d %d %d\n", c->cord.row, c->cord.col, c->val);
+  memset(&save_job.cells, 0, sizeof(cells_T));
+  file_collect(&save_job.cells);
+
+  save_refused = !save_job.snapshot &&
+                 !format_supports(save_job.format, save_job.cells.cells,
+                                  save_job.cells.size);
+  if (save_refused) {
+    cells_free(&save_job.cells);
+    return;
   }
 
-  fclose(f);
+  if (save_job.snapshot || save_job.format != FORMAT_NONE) {
+    FILE_CHECK(save_job.f = fopen(name, "wb"));
+  } else {
+    MEM_CHECK(fname = malloc((strlen(name) + 5) * sizeof(char)));
+    sprintf(fname, "%s.all", name);
+    FILE_CHECK(save_job.f = fopen(fname, "w"));
+    free(fname);
+  }
+
+  atomic_store(&save_job.done, 0);
+  atomic_store(&save_job.finished, 0);
+
+  if (pthread_create(&save_thread, NULL, file_save_worker, &save_job) != 0) {
+    file_save_worker(&save_job);
+    cells_free(&save_job.cells);
+    return;
+  }
+  save_running = 1;
 }
@@ -0,0 +1,575 @@
+/**
+ * @file format.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains readers and writers for standard pattern formats
+ *
+ * This file implements the formats used by most pattern collections: Run
+ * Length Encoded (.rle), Plaintext (.cells) and Life 1.06 (.lif, .life), and
+ * dispatches Macrocell (.mc) to macrocell.c. Each file is parsed in a single
+ * pass from a buffered reader into a packed buffer of cells, that can be
+ * inserted into the game at once. Patterns are always moved so that their
+ * bounding box starts at (0, 0).
+ */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "format.h"
+#include "logic.h"
+#include "macrocell.h"
+#include "utils.h"
+
+/// Size of the buffer used for reading pattern files
+#define READER_SIZE (1 << 16)
+
+/// Maximum length of a header line that is going to be parsed
+#define LINE_SIZE 1024
+
+/// Maximum length of a line in the Run Length Encoded file
+#define RLE_LINE 70
+
+/// Extension of each format in enum format_T
+char *format_ext[] = {"rle", "cells", "lif", "life", "mc"};
+
+/**
+ * @brief Buffered reader for parsing a file one character at a time
+ */
+typedef struct reader_T {
+  FILE *f;                ///< file that is being read
+  int   pos;              ///< position of the next character in the buffer
+  int   size;             ///< number of characters in the buffer
+  char  buf[READER_SIZE]; ///< buffer of characters read from the file
+} reader_T;
+
+/**
+ * @brief Return the next character from the reader or EOF
+ */
+static int reader_getc(reader_T *self) {
+  if (self->pos == self->size) {
+    self->pos = 0;
+    if (!(self->size = fread(self->buf, 1, READER_SIZE, self->f)))
+      return EOF;
+  }
+  return (unsigned char)self->buf[self->pos++];
+}
+
+/**
+ * @brief Read a line into the buffer of size max, dropping the rest of the line
+ * if it doesn't fit. Return the number of characters read or EOF
+ */
+static int reader_line(reader_T *self, char *line, int max) {
+  int c, size = 0;
+
+  while ((c = reader_getc(self)) != EOF && c != '\n')
+    if (c != '\r' && size < max - 1)
+      line[size++] = c;
+  line[size] = '\0';
+
+  return (c == EOF && !size) ? EOF : size;
+}
+
+/**
+ * @brief Return the format of the file based on the extension of its name
+ */
+int format_from_name(char *name) {
+  char *dot = strrchr(name, '.');
+
+  if (dot != NULL)
+    for (int i = 0; i < FORMAT_NONE; i++)
+      if (!strcmp(dot + 1, format_ext[i]))
+        return i;
+
+  return FORMAT_NONE;
+}
+
+/**
+ * @brief Compare two strings ignoring the case
+ */
+static int strcmp_nocase(char *a, char *b) {
+  for (; *a && tolower(*a) == tolower(*b); a++, b++)
+    ;
+  return tolower(*a) - tolower(*b);
+}
+
+/**
+ * @brief Return the index of the game mode matching the rule string, or -1 if
+ * the rule is not supported
+ *
+ * Conway's Life in any of its usual notations maps to Normal, and rules of the
+ * Generations family to the mode with the same rule, while other modes are
+ * written and recognized by their name.
+ */
+int format_rule(char *rule) {
+  char    *life[] = {"B3/S23", "23/3", "Life", "Conway"};
+  uint16_t birth, survive, mode_birth, mode_survive;
+  int      states, mode_states;
+
+  for (int i = 0; i < sizeof(life) / sizeof(char *); i++)
+    if (!strcmp_nocase(rule, life[i]))
+      return 0;
+
+  for (int i = 0; i < evolution_size; i++)
+    if (!strcmp_nocase(rule, evolution_names[i]))
+      return i;
+
+  if (!logic_rule(rule, &birth, &survive, &states))
+    return -1;
+
+  for (int i = 0; i < evolution_size; i++)
+    if (evolution_rules[i] &&
+        logic_rule(evolution_rules[i], &mode_birth, &mode_survive,
+                   &mode_states) &&
+        birth == mode_birth && survive == mode_survive && states == mode_states)
+      return i;
+
+  return -1;
+}
+
+/**
+ * @brief Return the rule string to be written for a game mode
+ */
+static char *format_rule_name(int rule) {
+  if (rule <= 0 || rule >= evolution_size)
+    return "B3/S23";
+  return evolution_rules[rule] ? evolution_rules[rule] : evolution_names[rule];
+}
+
+/**
+ * @brief Add a cell to the end of the buffer, growing it if needed
+ */
+void cells_push(cells_T *self, int64_t row, int64_t col, int val) {
+  if (self->size == self->capacity) {
+    coord_val *t;
+    self->capacity = self->capacity ? self->capacity * 2 : 64;
+    MEM_CHECK(t = realloc(self->cells, self->capacity * sizeof(coord_val)));
+    self->cells = t;
+  }
+
+  coord_val *c = &self->cells[self->size++];
+  c->row = row;
+  c->col = col;
+  c->val = val;
+}
+
+/**
+ * @brief Free the memory used by the buffer and make it empty
+ */
+void cells_free(cells_T *self) {
+  free(self->cells);
+  self->cells = NULL;
+  self->size = self->capacity = 0;
+}
+
+/**
+ * @brief Move the cells so that their bounding box starts at (0, 0)
+ */
+static void cells_normalize(coord_val *cells, int size) {
+  int64_t min_y = INT64_MAX, min_x = INT64_MAX;
+
+  for (int i = 0; i < size; i++) {
+    min_y = MIN(min_y, cells[i].row);
+    min_x = MIN(min_x, cells[i].col);
+  }
+
+  for (int i = 0; i < size; i++) {
+    cells[i].row -= min_y;
+    cells[i].col -= min_x;
+  }
+}
+
+/**
+ * @brief Parse the rule from the Run Length Encoded header line
+ */
+static int rle_header_rule(char *line) {
+  char *p = strstr(line, "rule");
+
+  if (p == NULL || (p = strchr(p, '=')) == NULL)
+    return -1;
+
+  while (isspace(*++p))
+    ;
+
+  char *end = p;
+  while (*end && *end != ',' && !isspace(*end))
+    end++;
+  *end = '\0';
+
+  return format_rule(p);
+}
+
+/**
+ * @brief State of the Run Length Encoded parser
+ */
+typedef struct rle_T {
+  int64_t row;    ///< current row
+  int64_t col;    ///< current column
+  int64_t count;  ///< run count read so far, 0 if none
+  int     prefix; ///< multi-state prefix read so far, 0 if none
+} rle_T;
+
+/**
+ * @brief Feed one character of the Run Length Encoded pattern to the parser.
+ * Return 0 when the end of the pattern has been reached
+ */
+static int rle_char(rle_T *self, int c, cells_T *cells) {
+  int64_t n = self->count ? self->count : 1;
+  int     val;
+
+  if (isdigit(c)) {
+    self->count = self->count * 10 + c - '0';
+    return 1;
+  }
+
+  if (isspace(c))
+    return 1;
+
+  if (c >= 'p' && c <= 'y') {
+    self->prefix = c - 'p' + 1;
+    return 1;
+  }
+
+  switch (c) {
+  case '!':
+    return 0;
+  case '$':
+    self->row += n;
+    self->col = 0;
+    break;
+  case 'b':
+  case '.':
+    self->col += n;
+    break;
+  default:
+    if (c >= 'A' && c <= 'X')
+      val = MIN(self->prefix * 24 + c - 'A' + 1, UCHAR_MAX);
+    else if (isalpha(c))
+      val = 1;
+    else
+      break;
+
+    while (n--)
+      cells_push(cells, self->row, self->col++, val);
+  }
+
+  self->count = 0;
+  self->prefix = 0;
+  return 1;
+}
+
+/**
+ * @brief Read the pattern in the Run Length Encoded format
+ */
+static void read_rle(reader_T *r, cells_T *cells) {
+  char  line[LINE_SIZE];
+  rle_T state = {0};
+  int   c;
+
+  while (reader_line(r, line, LINE_SIZE) != EOF) {
+    if (line[0] == '#' || line[0] == '\0')
+      continue;
+
+    if (line[0] == 'x') {
+      cells->rule = rle_header_rule(line);
+      break;
+    }
+
+    // pattern without a header
+    for (char *p = line; *p; p++)
+      if (!rle_char(&state, *p, cells))
+        return;
+    break;
+  }
+
+  while ((c = reader_getc(r)) != EOF)
+    if (!rle_char(&state, c, cells))
+      return;
+}
+
+/**
+ * @brief Read the pattern in the Plaintext format
+ */
+static void read_cells(reader_T *r, cells_T *cells) {
+  int64_t row = 0, col = 0;
+  int     c, comment = 0;
+
+  while ((c = reader_getc(r)) != EOF) {
+    if (c == '\n') {
+      if (!comment)
+        row++;
+      col = comment = 0;
+      continue;
+    }
+
+    if (comment || c == '\r')
+      continue;
+
+    if (col == 0 && c == '!') {
+      comment = 1;
+      continue;
+    }
+
+    if (c == 'O' || c == '*')
+      cells_push(cells, row, col, 1);
+    col++;
+  }
+}
+
+/**
+ * @brief Read the pattern in the Life 1.06 format
+ */
+static void read_life(reader_T *r, cells_T *cells) {
+  char line[LINE_SIZE];
+  int64_t row, col;
+
+  while (reader_line(r, line, LINE_SIZE) != EOF) {
+    if (line[0] == '#')
+      continue;
+
+    if (sscanf(line, "%" SCNd64 " %" SCNd64, &col, &row) == 2)
+      cells_push(cells, row, col, 1);
+  }
+}
+
+/**
+ * @brief Read the pattern of a given format from the file into cells
+ *
+ * Cells are appended to the buffer and moved so that the bounding box of the
+ * pattern starts at (0, 0). The rule is set to -1 if the file doesn't specify
+ * a supported one.
+ */
+void format_read(FILE *f, int format, cells_T *cells) {
+  reader_T *r;
+
+  MEM_CHECK(r = malloc(sizeof(reader_T)));
+  r->f = f;
+  r->pos = r->size = 0;
+  cells->rule = -1;
+
+  switch (format) {
+  case FORMAT_RLE:
+    read_rle(r, cells);
+    break;
+  case FORMAT_CELLS:
+    read_cells(r, cells);
+    break;
+  case FORMAT_LIF:
+  case FORMAT_LIFE:
+    read_life(r, cells);
+    break;
+  case FORMAT_MC:
+    macrocell_read(f, cells);
+    break;
+  }
+
+  cells_normalize(cells->cells, cells->size);
+  free(r);
+}
+
+/**
+ * @brief Compare two cells by row and then by column, used for sorting
+ */
+static int coord_val_cmp(const void *a, const void *b) {
+  const coord_val *x = a, *y = b;
+
+  if (x->row != y->row)
+    return (x->row > y->row) - (x->row < y->row);
+  return (x->col > y->col) - (x->col < y->col);
+}
+
+/**
+ * @brief Write one run of the Run Length Encoded pattern, breaking the line
+ * if it would be too long
+ */
+static void rle_token(FILE *f, int *len, int64_t count, char *tag) {
+  char buf[32];
+  int  n = (count > 1) ? sprintf(buf, "%" PRId64 "%s", count, tag)
+                       : sprintf(buf, "%s", tag);
+
+  if (*len + n > RLE_LINE) {
+    fputc('\n', f);
+    *len = 0;
+  }
+
+  fputs(buf, f);
+  *len += n;
+}
+
+/**
+ * @brief Return the tag of a cell state in the Run Length Encoded format
+ */
+static char *rle_tag(int val, int multi, char *buf) {
+  char *p = buf;
+
+  if (!multi)
+    return val ? "o" : "b";
+
+  if (!val)
+    return ".";
+
+  if (val > 24)
+    *p++ = 'p' + (val - 25) / 24;
+  *p++ = 'A' + (val - 1) % 24;
+  *p = '\0';
+
+  return buf;
+}
+
+/**
+ * @brief Write the sorted cells in the Run Length Encoded format
+ */
+static void write_rle(FILE *f, coord_val *cells, int size, int rule,
+                      format_progress_f progress) {
+  int64_t height = size ? cells[size - 1].row + 1 : 0, width = 0;
+  int64_t row = 0, col = 0;
+  int     multi = 0, len = 0;
+  char    tag[3];
+
+  for (int i = 0; i < size; i++) {
+    width = MAX(width, cells[i].col + 1);
+    multi |= cells[i].val > 1;
+  }
+
+  fprintf(f, "x = %" PRId64 ", y = %" PRId64 ", rule = %s\n", width, height,
+          format_rule_name(rule));
+
+  for (int i = 0, j; i < size; i = j) {
+    coord_val *c = &cells[i];
+
+    if (progress && i / FORMAT_PROGRESS_STEP != (i - 1) / FORMAT_PROGRESS_STEP)
+      progress(i);
+
+    if (c->row > row) {
+      rle_token(f, &len, c->row - row, "$");
+      row = c->row;
+      col = 0;
+    }
+
+    if (c->col > col)
+      rle_token(f, &len, c->col - col, rle_tag(0, multi, tag));
+
+    for (j = i + 1; j < size; j++)
+      if (cells[j].row != row || cells[j].col != c->col + j - i ||
+          cells[j].val != c->val)
+        break;
+
+    rle_token(f, &len, j - i, rle_tag(c->val, multi, tag));
+    col = c->col + j - i;
+  }
+
+  rle_token(f, &len, 1, "!");
+  fputc('\n', f);
+}
+
+/**
+ * @brief Write the sorted cells in the Plaintext format
+ */
+static void write_cells(FILE *f, coord_val *cells, int size,
+                        format_progress_f progress) {
+  int64_t row = 0, col = 0;
+
+  fprintf(f, "!Name: pattern\n");
+  for (int i = 0; i < size; i++) {
+    coord_val *c = &cells[i];
+
+    if (progress && i % FORMAT_PROGRESS_STEP == 0)
+      progress(i);
+
+    for (; row < c->row; row++, col = 0)
+      fputc('\n', f);
+
+    for (; col < c->col; col++)
+      fputc('.', f);
+
+    fputc('O', f);
+    col++;
+  }
+
+  if (size)
+    fputc('\n', f);
+}
+
+/**
+ * @brief Write the cells in the Life 1.06 format
+ */
+static void write_life(FILE *f, coord_val *cells, int size,
+                       format_progress_f progress) {
+  fprintf(f, "#Life 1.06\n");
+  for (int i = 0; i < size; i++) {
+    if (progress && i % FORMAT_PROGRESS_STEP == 0)
+      progress(i);
+    fprintf(f, "%" PRId64 " %" PRId64 "\n", cells[i].col, cells[i].row);
+  }
+}
+
+/**
+ * @brief Check if the cells can be written in a given format without loss
+ *
+ * Plaintext and Life 1.06 only know living cells, so cells in any other state
+ * are refused. Plaintext also spells out every dead cell of the bounding box,
+ * which is refused if it exceeds FORMAT_CELLS_MAX characters.
+ */
+int format_supports(int format, coord_val *cells, int size) {
+  int64_t min_y = INT64_MAX, min_x = INT64_MAX;
+  int64_t max_y = INT64_MIN, max_x = INT64_MIN;
+
+  if (format != FORMAT_CELLS && format != FORMAT_LIF && format != FORMAT_LIFE)
+    return 1;
+
+  for (int i = 0; i < size; i++) {
+    if (cells[i].val > 1)
+      return 0;
+    min_y = MIN(min_y, cells[i].row);
+    min_x = MIN(min_x, cells[i].col);
+    max_y = MAX(max_y, cells[i].row);
+    max_x = MAX(max_x, cells[i].col);
+  }
+
+  if (format != FORMAT_CELLS || !size)
+    return 1;
+
+  // rows end with a newline; compare as unsigned, the spans can overflow
+  uint64_t rows = (uint64_t)max_y - min_y + 1;
+  uint64_t cols = (uint64_t)max_x - min_x + 2;
+  return rows <= FORMAT_CELLS_MAX && cols <= FORMAT_CELLS_MAX &&
+         rows * cols <= FORMAT_CELLS_MAX;
+}
+
+/**
+ * @brief Write the cells to the file in a given format
+ *
+ * Cells are sorted and moved in place so that the bounding box of the pattern
+ * starts at (0, 0). Rule is the index of the current game mode. Progress, if
+ * not NULL, is called every FORMAT_PROGRESS_STEP cells written. Nothing is
+ * written and 0 is returned if the format can't hold the cells, see
+ * format_supports().
+ */
+int format_write(FILE *f, int format, coord_val *cells, int size, int rule,
+                 format_progress_f progress) {
+  if (!format_supports(format, cells, size))
+    return 0;
+
+  cells_normalize(cells, size);
+  qsort(cells, size, sizeof(coord_val), coord_val_cmp);
+
+  switch (format) {
+  case FORMAT_RLE:
+    write_rle(f, cells, size, rule, progress);
+    break;
+  case FORMAT_CELLS:
+    write_cells(f, cells, size, progress);
+    break;
+  case FORMAT_LIF:
+  case FORMAT_LIFE:
+    write_life(f, cells, size, progress);
+    break;
+  case FORMAT_MC:
+    macrocell_write(f, cells, size, format_rule_name(rule), progress);
+    break;
+  }
+
+  return 1;
+}
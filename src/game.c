@@ -10,13 +10,22 @@
  * cursor position as well as handle mouse input.
  */
 
+#include <ctype.h>
 #include <curses.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+#include "checkpoint.h"
 #include "display.h"
+#include "file.h"
 #include "game.h"
+#include "history.h"
 #include "logic.h"
 #include "main.h"
+#include "page.h"
+#include "record.h"
 #include "utils.h"
 #include "window.h"
 
@@ -24,6 +33,9 @@
 #define DEF_SCREEN_STEP 1
 #define DEF_TIME_CONST  100
 #define DEF_TIME_STEP   1
+#define DEF_ESCAPE      256
+#define PAGE_FILE       "gol.page"
+#define MAX_ZOOM        16
 
 #ifdef _WIN32
 #define TIME_MOD 1
@@ -37,21 +49,22 @@ extern int   evolution_size;
 
 extern window_T menu_w;
 extern mmask_t  mbitmask;
-extern Cell    *hash;
 
-typedef int (*coordinate_f)(int, int, int);
+typedef int64_t (*coordinate_f)(int64_t, int64_t, int);
 
 /**
  * @brief Given a coordinate relative to the screen, return real game coordinate
  * if not wrapping
  */
-int coordinate_nowrap(int val, int offset, int max) { return val + offset; }
+int64_t coordinate_nowrap(int64_t val, int64_t offset, int max) {
+  return val + offset;
+}
 
 /**
  * Given a coordinate relative to the screen, return real game coordinate
  * wrapping
  */
-int coordinate_wrap(int val, int offset, int max) {
+int64_t coordinate_wrap(int64_t val, int64_t offset, int max) {
   return (val + offset + max) % max;
 }
 
@@ -60,25 +73,24 @@ coordinate_f
 
 int height, width;
 
+coord_val *save_cells;   ///< cells of the selection to be saved in a pattern
+int        save_cells_s; ///< number of cells in save_cells
+int64_t    pos_y;        ///< real cursor y coordinate where a pattern is loaded
+int64_t    pos_x;        ///< real cursor x coordinate where a pattern is loaded
+
 static int win_height, win_width;
-static int screen_offset_x, screen_offset_y;
+static int64_t screen_offset_x, screen_offset_y;
 static int cursor_offset_x, cursor_offset_y;
 static int wrap, gen_step, screen_step;
 static int play, time_const, time_step;
+static int zoom, zoom_h, zoom_w;
 
-static unsigned gen;
+unsigned gen;
+int      page_budget; ///< memory for the living cells in MiB, 0 to keep all
 
 #define y_at(y) y, screen_offset_y, height
 #define x_at(x) x, screen_offset_x, width
 
-/**
- * @brief Convenience macro for looping over all the cells in a given coordinate
- * range
- */
-#define for_each_cell(start_i, end_i, start_j, end_j)                          \
-  for (int i = start_i; i < end_i; i++)                                        \
-    for (int j = start_j; j < end_j; j++)
-
 /**
  * @brief Display cell at given game coordinates  to the ncurses WINDOW.
  * Requires int val to be set to the value of the cell to be displayed
@@ -90,21 +102,6 @@ static unsigned gen;
     print_cell(win, blank);                                                    \
   }
 
-/**
- * @brief Given a coordinate range, display that part of the game to the ncurses
- * WINDOW. Use color scheme defined in color_offset, with dead cells being
- * filled with blank
- */
-#define print_cells(win, start_i, end_i, start_j, end_j, color_offset, blank)  \
-  for (int i = start_i; i < end_i; i++) {                                      \
-    wmove(win, i + 1, 1 + start_j * 2);                                        \
-    for (int j = start_j; j < end_j; j++) {                                    \
-      int val = getAt(cord(y_at(i)), cord(x_at(j)));                           \
-      wattrset(win, COLOR_PAIR(val + color_offset));                           \
-      print_cell(win, blank);                                                  \
-    }                                                                          \
-  }
-
 /**
  * @brief Given a coordinate, screen offset, screen size, and board size
  * calculate the exact position on the screen or return a negative number if
@@ -115,9 +112,9 @@ static unsigned gen;
  * @param screen_size: screen size on the x or y axis
  * @param board_size: game size of x or y axis, needed if wrapping
  */
-int get_screen_position(int value, int screen_offset, int screen_size,
+int get_screen_position(int64_t value, int64_t screen_offset, int screen_size,
                         int board_size) {
-  int overshoot = screen_offset + screen_size - board_size;
+  int64_t overshoot = screen_offset + screen_size - board_size;
 
   if (wrap) {
     if (overshoot > 0) {
@@ -140,6 +137,92 @@ int get_screen_position(int value, int screen_offset, int screen_size,
   }
 }
 
+static unsigned char *screen_cells; ///< values of the cells seen by the screen
+static char          *screen_line;  ///< one run of encoded cells
+static int            screen_cells_s, screen_line_s;
+
+/**
+ * @brief Fill screen_cells with the values of the cells seen by the screen
+ * using a single pass over the hash, and the paged cells in its view
+ */
+void screen_fill(void) {
+  int size = win_height * win_width;
+
+  if (size > screen_cells_s) {
+    screen_cells_s = size;
+    free(screen_cells);
+    MEM_CHECK(screen_cells = malloc(size * sizeof(*screen_cells)));
+  }
+
+  if (win_width > screen_line_s) {
+    screen_line_s = win_width;
+    free(screen_line);
+    MEM_CHECK(screen_line = malloc(win_width * 4 + 1));
+  }
+  memset(screen_cells, 0, size * sizeof(*screen_cells));
+
+  int row, col;
+  for (Cell *c = universe->hash; c != NULL; c = c->hh.next) {
+    row = get_screen_position(c->cord.row, screen_offset_y, win_height, height);
+    col = get_screen_position(c->cord.col, screen_offset_x, win_width, width);
+
+    if (row < 0 || col < 0)
+      continue;
+
+    screen_cells[row * win_width + col] = c->val;
+  }
+
+  if (!universe->paged)
+    return;
+
+  coord_val *paged;
+  size_t     n = page_cells(universe, screen_offset_y, screen_offset_x,
+                            win_height, win_width, &paged);
+  for (size_t k = 0; k < n; k++) {
+    row = get_screen_position(paged[k].row, screen_offset_y, win_height, height);
+    col = get_screen_position(paged[k].col, screen_offset_x, win_width, width);
+
+    if (row >= 0 && col >= 0)
+      screen_cells[row * win_width + col] = paged[k].val;
+  }
+  free(paged);
+}
+
+/**
+ * @brief Given a coordinate range, display that part of screen_cells to the
+ * ncurses WINDOW. Use color scheme defined in color_offset, with dead cells
+ * being filled with blank
+ *
+ * Every row is split into runs of cells with the same value, and each run is
+ * printed with one attribute change and one write.
+ *
+ * @param skip_dead: don't print the runs of dead cells, for a cleared window
+ */
+void print_cells(WINDOW *win, int start_i, int end_i, int start_j, int end_j,
+                 int color_offset, char *blank, int skip_dead) {
+  for (int i = start_i; i < end_i; i++) {
+    unsigned char *row = &screen_cells[i * win_width];
+
+    for (int j = start_j, k; j < end_j; j = k) {
+      int val = row[j];
+      for (k = j + 1; k < end_j && row[k] == val; k++)
+        ;
+
+      if (!val && skip_dead)
+        continue;
+
+      char *glyph = (UNICODE && val) ? CHAR_ACTIVE : blank;
+      int   len = strlen(glyph), n = 0;
+      for (int l = j; l < k; l++, n += len)
+        memcpy(screen_line + n, glyph, len);
+
+      wmove(win, i + 1, j * 2 + 1);
+      wattrset(win, COLOR_PAIR(val + color_offset));
+      waddnstr(win, screen_line, n);
+    }
+  }
+}
+
 /**
  * @brief Display the part of the game seen by screen to the ncurses WINDOW
  * provided
@@ -149,18 +232,137 @@ void display_game(window_T wind) {
 
   window_clear_noRefresh(wind);
 
-  int row, col, val;
-  for (Cell *c = hash; c != NULL; c = c->hh.next) {
-    wattrset(win, COLOR_PAIR(val + 2));
+  screen_fill();
+  print_cells(win, 0, win_height, 0, win_width, PAIR_CELL, CHAR_BLANK, 1);
+}
 
-    row = get_screen_position(c->cord.row, screen_offset_y, win_height, height);
-    col = get_screen_position(c->cord.col, screen_offset_x, win_width, width);
-    val = c->val;
+/// Braille dot of every cell in a 2x4 block, indexed by [row][col]
+static const unsigned char braille_dots[4][2] = {
+    {0x01, 0x08},
+    {0x02, 0x10},
+    {0x04, 0x20},
+    {0x40, 0x80},
+};
+
+/// Glyphs used for the coarse zoom levels, from empty to full block
+#ifndef NO_UNICODE
+static char *density_glyphs[] = {" ", "\u2591", "\u2592", "\u2593", "\u2588"};
+#else
+static char *density_glyphs[] = {" ", ".", ":", "*", "#"};
+#endif
 
-    if (row < 0 || col < 0)
-      continue;
+static unsigned *zoom_grid; ///< per glyph population or braille dots
+static char     *zoom_line; ///< one screen row of encoded glyphs
+static int       zoom_grid_s, zoom_line_s;
+
+/**
+ * @brief Set the zoom level and the number of cells covered by one glyph
+ *
+ * Level 0 displays one cell per glyph, level 1 packs 2x4 cells into a braille
+ * character and every next level doubles the block in both directions.
+ */
+void zoom_set(int level) {
+  zoom = ACLAMP(level, 0, MAX_ZOOM);
+  zoom_h = zoom ? 4 << (zoom - 1) : 1;
+  zoom_w = zoom ? 2 << (zoom - 1) : 1;
+}
+
+/**
+ * @brief Given a game coordinate, return its offset from the screen origin or
+ * a negative number if it's not in the visible range of view_size cells
+ */
+long zoom_position(int64_t value, int64_t screen_offset, long view_size,
+                   int board_size) {
+  int64_t rel = value - screen_offset;
+
+  if (wrap)
+    rel = (rel % board_size + board_size) % board_size;
+
+  return (rel >= 0 && rel < view_size) ? rel : -1;
+}
 
-    mvprint_cell(win, row, col, 2, CHAR_BLANK);
+/**
+ * @brief Add the living cell at given game coordinates to its glyph of
+ * zoom_grid, if it's in the view of view_h x view_w cells
+ */
+static void zoom_bin(int64_t y, int64_t x, long view_h, long view_w,
+                     int braille) {
+  long row = zoom_position(y, screen_offset_y, view_h, height);
+  long col = zoom_position(x, screen_offset_x, view_w, width);
+
+  if (row < 0 || col < 0)
+    return;
+
+  unsigned *g = &zoom_grid[row / zoom_h * win_width + col / zoom_w];
+  if (braille)
+    *g |= braille_dots[row % 4][col % 2];
+  else
+    (*g)++;
+}
+
+/**
+ * @brief Display the part of the game seen by screen at the current zoom level
+ * to the ncurses WINDOW provided
+ *
+ * Living cells are binned into a glyph sized grid in a single pass over the
+ * hash, so the cost does not depend on the area being displayed. Every row of
+ * the grid is then encoded and printed with one call.
+ */
+void display_game_zoomed(window_T wind) {
+  WINDOW *win = window_win(wind);
+  long    view_h = (long)win_height * zoom_h, view_w = (long)win_width * zoom_w;
+  int     size = win_height * win_width;
+  int     braille = UNICODE && zoom == 1;
+
+  window_clear_noRefresh(wind);
+
+  if (size > zoom_grid_s) {
+    zoom_grid_s = size;
+    free(zoom_grid);
+    MEM_CHECK(zoom_grid = malloc(size * sizeof(*zoom_grid)));
+  }
+
+  if (win_width > zoom_line_s) {
+    zoom_line_s = win_width;
+    free(zoom_line);
+    MEM_CHECK(zoom_line = malloc(win_width * 3 + 1));
+  }
+  memset(zoom_grid, 0, size * sizeof(*zoom_grid));
+
+  for (Cell *c = universe->hash; c != NULL; c = c->hh.next)
+    if (c->val)
+      zoom_bin(c->cord.row, c->cord.col, view_h, view_w, braille);
+
+  if (universe->paged) {
+    coord_val *paged;
+    size_t     n = page_cells(universe, screen_offset_y, screen_offset_x,
+                              view_h, view_w, &paged);
+
+    for (size_t k = 0; k < n; k++)
+      zoom_bin(paged[k].row, paged[k].col, view_h, view_w, braille);
+    free(paged);
+  }
+
+  unsigned long area = (unsigned long)zoom_h * zoom_w;
+  wattrset(win, COLOR_PAIR(PAIR_CELL));
+  for (int i = 0; i < win_height; i++) {
+    char     *p = zoom_line;
+    unsigned *g = &zoom_grid[i * win_width];
+
+    for (int j = 0; j < win_width; j++, g++) {
+      if (braille && *g) {
+        *p++ = 0xE2;
+        *p++ = 0xA0 | (*g >> 6);
+        *p++ = 0x80 | (*g & 0x3F);
+      } else {
+        char *glyph = density_glyphs[*g ? 1 + (*g - 1) * 4 / area : 0];
+        while (*glyph)
+          *p++ = *glyph++;
+      }
+    }
+    *p = '\0';
+
+    mvwaddstr(win, i + 1, 1, zoom_line);
   }
 }
 
@@ -173,15 +375,39 @@ void display_cursor(WINDOW *win) {
   int        val;
 
   val = getAt(cord(y_at(prev_y)), cord(x_at(prev_x)));
-  mvprint_cell(win, prev_y, prev_x, 2, CHAR_BLANK);
+  mvprint_cell(win, prev_y, prev_x, PAIR_CELL, CHAR_BLANK);
 
   val = getAt(cord(y_at(cursor_offset_y)), cord(x_at(cursor_offset_x)));
-  mvprint_cell(win, cursor_offset_y, cursor_offset_x, 5, CHAR_CURSOR);
+  mvprint_cell(win, cursor_offset_y, cursor_offset_x, PAIR_CURSOR,
+               CHAR_CURSOR);
 
   prev_y = cursor_offset_y;
   prev_x = cursor_offset_x;
 }
 
+/**
+ * @brief Display the memory used by the game and its history per living cell
+ */
+void display_memory(WINDOW *win) {
+  gol_memory memory;
+  size_t     population = gol_population(universe);
+  double     bytes;
+
+  if (!population) {
+    wprintw(win, "%5s B/cell | ", "-");
+    return;
+  }
+
+  bytes = (double)(gol_memory_usage(universe, &memory) + history_memory()) /
+          population;
+  if (bytes < 1e4)
+    wprintw(win, "%5.0f B/cell | ", bytes);
+  else if (bytes < 1e7)
+    wprintw(win, "%4.0fk B/cell | ", bytes / 1e3);
+  else
+    wprintw(win, "%4.0fM B/cell | ", bytes / 1e6);
+}
+
 /**
  * @brief Display game information to the ncurses WINDOW provided
  */
@@ -190,14 +416,45 @@ void display_status(window_T wind) {
 
   wmove(win, 1, 1);
   wprintw(win, " %5s | ", play ? "play" : "pause");
+  wprintw(win, "%6s | ", replay_active()   ? "replay"
+                         : record_active() ? "rec"
+                                           : "");
   wprintw(win, wrap ? "Size: %9dx%9d | " : "Size: unlimited | ", height, width);
   wprintw(win, "Generation: %10u(+%d) | ", gen, gen_step);
   wprintw(win, "dt: %4dms | ", time_const);
-  wprintw(win, "Cursor: %10dx%10d | ", cord(y_at(cursor_offset_y)),
-          cord(x_at(cursor_offset_x)));
+  wprintw(win, "Zoom: %2d | ", zoom);
+  wprintw(win, "Cursor: %10" PRId64 "x%10" PRId64 " | ",
+          cord(y_at(cursor_offset_y)), cord(x_at(cursor_offset_x)));
+  size_t resident, paged;
+  int    paging = gol_tiles(universe, &resident, &paged);
+
+  if (universe->escape)
+    wprintw(win, "Escaped: %7lu | ",
+            (unsigned long)gol_escaped_total(universe));
+  if (paging)
+    wprintw(win, "Tiles: %4lu/%4lu | ", (unsigned long)resident,
+            (unsigned long)(resident + paged));
+  if (!universe->escape && !paging)
+    wprintw(win, "%19s", "");
+
+  int progress = file_save_progress();
+  if (progress >= 0)
+    wprintw(win, "Saving: %3d%% | ", progress);
+  else if (file_save_refused())
+    wprintw(win, "Save refused | ");
+  else
+    display_memory(win);
   wrefresh(win);
 }
 
+/**
+ * @brief Convenience macro for turning an inclusive range of screen
+ * coordinates into the game coordinates and size of a region
+ */
+#define select_region(start_i, end_i, start_j, end_j)                          \
+  cord(y_at(start_i)), cord(x_at(start_j)), end_i - start_i + 1,               \
+      end_j - start_j + 1
+
 /**
  * @brief Display the visual select mode
  *
@@ -228,6 +485,7 @@ int display_select(window_T wind) {
 
   int ph = window_height(wind), pw = window_width(wind) / 2;
   nodelay(stdscr, 0);
+  screen_fill();
   while (TRUE) {
     int start_i = MIN(cursor_offset_y, current_offset_y);
     int end_i = MAX(cursor_offset_y, current_offset_y);
@@ -237,7 +495,8 @@ int display_select(window_T wind) {
     if (!UNICODE)
       display_game(wind);
 
-    print_cells(new, start_i, end_i + 1, start_j, end_j + 1, 8, CHAR_BLANK);
+    print_cells(new, start_i, end_i + 1, start_j, end_j + 1, PAIR_SELECT,
+                CHAR_BLANK, 0);
     wrefresh(new);
 
     if (is_term_resized(CLINES, CCOLS)) {
@@ -272,21 +531,20 @@ int display_select(window_T wind) {
     // delete selection
     case 'x':
     case 'X':
-      for_each_cell(start_i, end_i + 1, start_j, end_j + 1)
-          deleteAt(cord(y_at(i)), cord(x_at(j)));
+      deleteRegion(select_region(start_i, end_i, start_j, end_j));
       goto end;
 
     // toggle selection
     case 't':
     case 'T':
-      for_each_cell(start_i, end_i + 1, start_j, end_j + 1)
-          toggleAt(cord(y_at(i)), cord(x_at(j)));
+      toggleRegion(select_region(start_i, end_i, start_j, end_j));
       goto end;
 
     // confirm and save selection
     case '\n':
-      for_each_cell(start_i, end_i + 1, start_j, end_j + 1)
-          saveCell(cord(y_at(i)), cord(x_at(j)));
+      free(save_cells);
+      save_cells_s = logic_extract(
+          select_region(start_i, end_i, start_j, end_j), &save_cells);
       ret_value = 100;
       goto end;
 
@@ -315,20 +573,56 @@ end:;
   return ret_value;
 }
 
+/**
+ * @brief Ask for a generation held by the history, or by the recording being
+ * replayed, and restore the game at it
+ */
+static void jump(void) {
+  struct imenu_T jump_items[] = {
+      {NULL, 10, isdigit, NULL},
+  };
+  unsigned first, last;
+  char     message[64];
+  int      replay = replay_active();
+
+  if (!(replay ? replay_range(&first, &last) : history_range(&first, &last)))
+    return;
+
+  snprintf(message, sizeof(message), "Generation (%u - %u)", first, last);
+  jump_items[0].message = message;
+
+  window_set_title(menu_w, "Jump");
+  while (display_imenu(menu_w, jump_items, 1)) {
+    unsigned target = strtoul(jump_items[0].buffer, NULL, 10);
+
+    if (replay) {
+      replay_seek(target, &gen);
+    } else if (history_seek(target)) {
+      record_stop();
+      gen = target;
+    }
+    break;
+  }
+
+  free(jump_items[0].buffer);
+}
+
 /**
  * @brief save the current screen and cursor coordinates
  * before resize to use them after redraw. Must be used before goto redraw
  */
 #define save_state()                                                           \
   {                                                                            \
-    t_y = cord(y_at(win_height / 2));                                          \
-    t_x = cord(x_at(win_width / 2));                                           \
+    t_y = cord(y_at(win_height * zoom_h / 2));                                 \
+    t_x = cord(x_at(win_width * zoom_w / 2));                                  \
     ct_y = cord(y_at(cursor_offset_y));                                        \
     ct_x = cord(x_at(cursor_offset_x));                                        \
   }
 
 /**
  * @brief Main game runner. Connection between logic and display
+ *
+ * The game starts at generation start_gen, which is used by loaded games.
  * This function is responsive:
  * - On every resize:
  *   - window tree is recreated
@@ -342,6 +636,9 @@ end:;
  * - Use -/+ to decrease or increase the numbs of evolutions before displaying
  * change
  * - Use [/] to decrease or increase time wait before update
+ * - Use z/x to zoom out or in
+ * - Use c to start or stop recording the game
+ * - Use e to start or stop removing escaping spaceships of unlimited game
  * - Use q or esc to return to the main menu
  * - If not play:
  *   - Use wasd to move the cursor around
@@ -349,20 +646,25 @@ end:;
  *   - Use v to enter the visual select mode
  *   - Use l to load the pattern
  *   - Use o to save the current game
+ *   - Use b to step back and j to jump to an earlier generation, or to any
+ *   generation of the recording being replayed
  *   - Use h to show help menu
  *   - Use r to redraw the screen
  */
-void game(int s_h, int s_w, int mode_index) {
+void game(int s_h, int s_w, int mode_index, unsigned start_gen) {
   char *mode_name = evolution_names[mode_index];
 
-  int t_y = 0, t_x = 0, ct_x = 0, ct_y = 0;
+  int64_t t_y = 0, t_x = 0, ct_x = 0, ct_y = 0;
   wrap = 1;
 
   window_T status_w, screen_w, game_w;
 
-  gen = 0;
+  gen = start_gen;
   gen_step = DEF_GEN_STEP, time_const = DEF_TIME_CONST;
   time_step = DEF_TIME_STEP, screen_step = DEF_SCREEN_STEP;
+  zoom_set(0);
+  checkpoint_start();
+  history_start();
 
 reset_screen:
   status_w = window_split(menu_w, 1, 3, 0, "Status", "Game");
@@ -380,7 +682,13 @@ reset_screen:
     height = 0;
   }
 
-  logic_init(wrap, mode_index);
+  free(save_cells);
+  save_cells = NULL;
+  save_cells_s = 0;
+
+  logic_init(height, width, mode_index);
+  if (page_budget)
+    gol_page(universe, (size_t)page_budget << 20, PAGE_FILE);
 
   cord = wrap ? coordinate_wrap : coordinate_nowrap;
   game_w = window_center(screen_w, height, width * 2, mode_name);
@@ -396,14 +704,15 @@ redraw:;
   }
 
   WINDOW *game_W = window_win(game_w);
-  win_height = window_height(game_w), win_width = window_width(game_w) / 2;
+  win_height = window_height(game_w);
+  win_width = window_width(game_w) / (zoom ? 1 : 2);
 
   window_clear(menu_w);
   window_clear(screen_w);
   window_clear(status_w);
 
-  screen_offset_y = t_y - win_height / 2;
-  screen_offset_x = t_x - win_width / 2;
+  screen_offset_y = t_y - win_height * zoom_h / 2;
+  screen_offset_x = t_x - win_width * zoom_w / 2;
 
   if (wrap) {
     screen_offset_x = (screen_offset_x + width) % width;
@@ -421,8 +730,12 @@ redraw:;
   CLAMP(cursor_offset_y, 0, win_height - 1);
   CLAMP(cursor_offset_x, 0, win_width - 1);
 
-  display_game(game_w);
-  display_cursor(game_W);
+  if (zoom) {
+    display_game_zoomed(game_w);
+  } else {
+    display_game(game_w);
+    display_cursor(game_W);
+  }
   wrefresh(game_W);
 
   int screen_change = 1;
@@ -437,20 +750,33 @@ redraw:;
     }
 
     if (play) {
-      do_evolution(gen_step);
+      if (replay_active()) {
+        if (!replay_step(gen_step, &gen))
+          play = 0;
+      } else {
+        history_evolve(gen_step);
+        gen += gen_step;
+        record_frame();
+        checkpoint_tick();
+      }
       screen_change = 1;
-      gen += gen_step;
     }
 
     display_status(status_w);
 
+    if (screen_change && zoom) {
+      display_game_zoomed(game_w);
+      wrefresh(game_W);
+      screen_change = 0;
+    }
+
     if (screen_change) {
       display_game(game_w);
       screen_change = 0;
       cursor_change = 1;
     }
 
-    if (cursor_change) {
+    if (cursor_change && !zoom) {
       display_cursor(game_W);
       wrefresh(game_W);
       cursor_change = 0;
@@ -488,9 +814,34 @@ redraw:;
       case '[':
         time_const -= time_step;
         break;
+
+      // toggle recording
+      case 'c':
+      case 'C':
+        if (record_active())
+          record_stop();
+        else if (!replay_active())
+          record_start();
+        break;
+
+      // toggle removal of escaping spaceships
+      case 'e':
+      case 'E':
+        if (!wrap)
+          gol_escape(universe, universe->escape ? 0 : DEF_ESCAPE);
+        break;
+
+      // change zoom level
+      case 'z':
+      case 'Z':
+      case 'x':
+      case 'X':
+        save_state();
+        zoom_set(zoom + ((c == 'z' || c == 'Z') ? 1 : -1));
+        goto redraw;
       }
 
-      if (!play) {
+      if (!play && !zoom) {
         // move cursor around
         switch (c) {
         case 'w':
@@ -525,10 +876,12 @@ redraw:;
           int mouse_offset_x = (mort.x - window_x(game_w) - 1) / 2;
           int val =
               toggleAt(cord(y_at(mouse_offset_y)), cord(x_at(mouse_offset_x)));
+          history_edit();
 
           if (mouse_offset_x != cursor_offset_x ||
               mouse_offset_y != cursor_offset_y) {
-            mvprint_cell(game_W, mouse_offset_y, mouse_offset_x, 2, CHAR_BLANK);
+            mvprint_cell(game_W, mouse_offset_y, mouse_offset_x, PAIR_CELL,
+                         CHAR_BLANK);
             wrefresh(game_W);
           } else
             cursor_change = 1;
@@ -538,6 +891,7 @@ redraw:;
         // toggle cell
         case ' ':
           toggleAt(cord(y_at(cursor_offset_y)), cord(x_at(cursor_offset_x)));
+          history_edit();
           cursor_change = 1;
           break;
 
@@ -548,6 +902,7 @@ redraw:;
             window_unsplit(menu_w);
             save_pattern();
           }
+          history_edit();
 
           save_state();
           goto reset_screen;
@@ -556,11 +911,18 @@ redraw:;
         case 'l':
         case 'L':
           window_unsplit(menu_w);
-          setPosition(cord(y_at(cursor_offset_y)), cord(x_at(cursor_offset_x)));
+          pos_y = cord(y_at(cursor_offset_y));
+          pos_x = cord(x_at(cursor_offset_x));
           load_pattern();
+          history_edit();
 
           save_state();
           goto reset_screen;
+        }
+      }
+
+      if (!play) {
+        switch (c) {
 
         // save game
         case 'o':
@@ -571,6 +933,27 @@ redraw:;
           save_state();
           goto reset_screen;
 
+        // step back
+        case 'b':
+        case 'B':
+          if (replay_active()) {
+            screen_change = replay_seek(gen - MIN(gen, gen_step), &gen);
+          } else if (history_seek(gen - MIN(gen, gen_step))) {
+            record_stop();
+            gen -= MIN(gen, gen_step);
+            screen_change = 1;
+          }
+          break;
+
+        // jump to a generation
+        case 'j':
+        case 'J':
+          window_unsplit(menu_w);
+          jump();
+
+          save_state();
+          goto reset_screen;
+
         // help menu
         case 'h':
         case 'H':
@@ -595,7 +978,7 @@ redraw:;
       case KEY_END:
       case KEY_HOME:
       case KEY_LEFT:
-        screen_offset_x -= screen_step;
+        screen_offset_x -= screen_step * zoom_w;
         screen_change = 1;
         break;
       case KEY_A3:
@@ -603,7 +986,7 @@ redraw:;
       case KEY_NPAGE:
       case KEY_PPAGE:
       case KEY_RIGHT:
-        screen_offset_x += screen_step;
+        screen_offset_x += screen_step * zoom_w;
         screen_change = 1;
         break;
       }
@@ -614,7 +997,7 @@ redraw:;
       case KEY_HOME:
       case KEY_PPAGE:
       case KEY_UP:
-        screen_offset_y -= screen_step;
+        screen_offset_y -= screen_step * zoom_h;
         screen_change = 1;
         break;
       case KEY_C1:
@@ -622,7 +1005,7 @@ redraw:;
       case KEY_DOWN:
       case KEY_END:
       case KEY_NPAGE:
-        screen_offset_y += screen_step;
+        screen_offset_y += screen_step * zoom_h;
         screen_change = 1;
       }
 
@@ -643,6 +1026,26 @@ redraw:;
   }
 end:;
   window_unsplit(menu_w);
+  checkpoint_stop();
+  history_stop();
+  record_stop();
+  replay_close();
   logic_free();
+
+  free(save_cells);
+  save_cells = NULL;
+  save_cells_s = 0;
+
+  free(zoom_grid);
+  free(zoom_line);
+  zoom_grid = NULL;
+  zoom_line = NULL;
+  zoom_grid_s = zoom_line_s = 0;
+
+  free(screen_cells);
+  free(screen_line);
+  screen_cells = NULL;
+  screen_line = NULL;
+  screen_cells_s = screen_line_s = 0;
   return;
 }
@@ -0,0 +1,349 @@
+/**
+ * @file gol.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the interface of the Game of Life library
+ *
+ * The library is a thin layer over logic.c, which works on the universe of the
+ * calling thread. Each function makes the universe it is given the current one
+ * for the duration of the call, and restores the previous one afterwards, so
+ * the library can be used from a thread that has a current universe of its
+ * own, like the game interface does.
+ *
+ * Coordinates passed to a limited universe are wrapped around its edges.
+ * Universes can be saved to and loaded from the binary snapshots and all of
+ * the supported pattern formats.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "format.h"
+#include "gol.h"
+#include "logic.h"
+#include "page.h"
+#include "snapshot.h"
+#include "utils.h"
+
+/**
+ * @brief Make u the universe of the calling thread, returning the previous one
+ */
+static gol_universe *enter(gol_universe *u) {
+  gol_universe *prev = universe;
+
+  universe = u;
+  return prev;
+}
+
+/**
+ * @brief Wrap the coordinate around the edge of size, if it is limited
+ */
+static int64_t wrap(int64_t val, int size) {
+  return size ? (val % size + size) % size : val;
+}
+
+/**
+ * @brief Check if the file with name is a binary snapshot
+ */
+static int is_snapshot(const char *name) {
+  const char *dot = strrchr(name, '.');
+  return dot != NULL && !strcmp(dot + 1, SNAPSHOT_EXT);
+}
+
+/**
+ * @brief Return the number of game modes
+ */
+int gol_mode_count(void) { return evolution_size; }
+
+/**
+ * @brief Return the name of the game mode, NULL if there is no such mode
+ */
+const char *gol_mode_name(int mode) {
+  return mode >= 0 && mode < evolution_size ? evolution_names[mode] : NULL;
+}
+
+/**
+ * @brief Return the number of cell states of the game mode, including the dead
+ * state, 0 if there is no such mode
+ */
+int gol_mode_states(int mode) {
+  return mode >= 0 && mode < evolution_size ? evolution_cells[mode] : 0;
+}
+
+/**
+ * @brief Create an empty universe of height x width cells wrapping around its
+ * edges, or an unlimited one if either of them is 0. Return NULL if there is
+ * no such game mode
+ */
+gol_universe *gol_create(int height, int width, int mode) {
+  gol_universe *u, *prev;
+
+  if (mode < 0 || mode >= evolution_size || height < 0 || width < 0)
+    return NULL;
+
+  MEM_CHECK(u = calloc(1, sizeof(gol_universe)));
+
+  prev = enter(u);
+  logic_init(height, width, mode);
+  setSeed(0);
+  universe = prev;
+
+  return u;
+}
+
+/**
+ * @brief Destroy the universe and free all of its memory
+ */
+void gol_destroy(gol_universe *u) {
+  gol_universe *prev;
+
+  if (u == NULL)
+    return;
+
+  prev = enter(u);
+  logic_free();
+  universe = prev;
+
+  free(u);
+}
+
+/**
+ * @brief Load a universe from a binary snapshot, which keeps its size, game
+ * mode, seed and generation, or from a pattern into an unlimited universe.
+ * Return NULL if the file can't be read
+ */
+gol_universe *gol_load(const char *name) {
+  gol_universe *u;
+  snapshot_T    info = {0};
+  cells_T       cells = {0};
+  int           format = format_from_name((char *)name);
+
+  if (is_snapshot(name)) {
+    if (!snapshot_read((char *)name, &info, &cells)) {
+      cells_free(&cells);
+      return NULL;
+    }
+  } else if (format != FORMAT_NONE) {
+    FILE *f = fopen(name, "r");
+
+    if (f == NULL)
+      return NULL;
+
+    format_read(f, format, &cells);
+    fclose(f);
+    info.mode = cells.rule < 0 ? 0 : cells.rule;
+  } else {
+    return NULL;
+  }
+
+  if ((u = gol_create(info.height, info.width, info.mode)) == NULL) {
+    cells_free(&cells);
+    return NULL;
+  }
+
+  gol_insert(u, cells.cells, cells.size);
+  cells_free(&cells);
+
+  gol_seed(u, info.seed);
+  u->generation = info.generation;
+  return u;
+}
+
+/**
+ * @brief Save the universe to a binary snapshot, or its living cells to a
+ * pattern, based on the extension of name. Return 0 on failure
+ */
+int gol_save(gol_universe *u, const char *name) {
+  snapshot_T info = {u->height, u->width, u->evolve_index, u->seed,
+                     u->generation};
+  int           format = format_from_name((char *)name);
+  gol_universe *prev;
+  coord_val    *cells;
+  size_t        size;
+  FILE         *f;
+
+  if (!is_snapshot(name) && format == FORMAT_NONE)
+    return 0;
+
+  prev = enter(u);
+  size = logic_collect(&cells);
+  universe = prev;
+
+  if (!is_snapshot(name) && !format_supports(format, cells, size)) {
+    free(cells);
+    return 0;
+  }
+
+  if ((f = fopen(name, is_snapshot(name) ? "wb" : "w")) == NULL) {
+    free(cells);
+    return 0;
+  }
+
+  if (is_snapshot(name))
+    snapshot_write(f, &info, cells, size, NULL);
+  else
+    format_write(f, format, cells, size, u->evolve_index, NULL);
+
+  free(cells);
+  return fclose(f) == 0;
+}
+
+/**
+ * @brief Seed the random number generator of the universe
+ */
+void gol_seed(gol_universe *u, unsigned seed) {
+  gol_universe *prev = enter(u);
+  setSeed(seed);
+  universe = prev;
+}
+
+/**
+ * @brief Evolve the universe by steps generations
+ */
+void gol_evolve(gol_universe *u, int steps) {
+  gol_universe *prev = enter(u);
+  do_evolution(steps);
+  universe = prev;
+}
+
+/**
+ * @brief Return the number of generations the universe has evolved
+ */
+uint64_t gol_generation(const gol_universe *u) { return u->generation; }
+
+/**
+ * @brief Return the number of living cells, including the paged ones
+ */
+size_t gol_population(const gol_universe *u) {
+  return HASH_COUNT(u->hash) + u->paged;
+}
+
+/**
+ * @brief Find the memory used by the universe, split by what it is used for.
+ * Return the total number of bytes
+ *
+ * Dividing the total by gol_population() gives the bytes per living cell.
+ */
+size_t gol_memory_usage(const gol_universe *u, gol_memory *memory) {
+  memory->cells = sizeof(gol_universe) + u->pool_cells * sizeof(Cell) +
+                  u->pool_chunks_s * sizeof(Cell *) -
+                  HASH_COUNT(u->hash) * sizeof(UT_hash_handle);
+  memory->index = HASH_OVERHEAD(hh, u->hash);
+  memory->history = u->change_cells_c * sizeof(coord_val);
+  memory->cache = page_memory(u);
+  memory->total =
+      memory->cells + memory->index + memory->history + memory->cache;
+  return memory->total;
+}
+
+/**
+ * @brief Find the bounding box of the living cells. Return 0 if there are none
+ */
+int gol_bounds(const gol_universe *u, int64_t *row, int64_t *col,
+               int64_t *height, int64_t *width) {
+  int64_t min_row = 0, min_col = 0, max_row = 0, max_col = 0;
+  int     found = 0;
+
+  for (Cell *c = u->hash; c != NULL; c = c->hh.next) {
+    if (!c->val)
+      continue;
+
+    if (!found++) {
+      min_row = max_row = c->cord.row;
+      min_col = max_col = c->cord.col;
+    }
+    min_row = MIN(min_row, c->cord.row);
+    min_col = MIN(min_col, c->cord.col);
+    max_row = MAX(max_row, c->cord.row);
+    max_col = MAX(max_col, c->cord.col);
+  }
+
+  if (!found && u->paged) {
+    min_row = min_col = INT64_MAX;
+    max_row = max_col = INT64_MIN;
+  }
+  found += page_bounds(u, &min_row, &min_col, &max_row, &max_col);
+
+  *row = min_row;
+  *col = min_col;
+  *height = found ? max_row - min_row + 1 : 0;
+  *width = found ? max_col - min_col + 1 : 0;
+  return found != 0;
+}
+
+/**
+ * @brief Return the value of the cell, 0 if it's dead
+ */
+int gol_get(gol_universe *u, int64_t row, int64_t col) {
+  gol_universe *prev = enter(u);
+  int           val = getAt(wrap(row, u->height), wrap(col, u->width));
+
+  universe = prev;
+  return val;
+}
+
+/**
+ * @brief Set the value of the cell, 0 to kill it
+ */
+void gol_set(gol_universe *u, int64_t row, int64_t col, int val) {
+  gol_universe *prev = enter(u);
+
+  row = wrap(row, u->height);
+  col = wrap(col, u->width);
+  if (val)
+    setAt(row, col, val);
+  else
+    deleteAt(row, col);
+
+  universe = prev;
+}
+
+/**
+ * @brief Set the values of many cells at once, same as calling gol_set() on
+ * each of them in order
+ */
+void gol_insert(gol_universe *u, const gol_cell *cells, size_t size) {
+  gol_universe *prev = enter(u);
+  coord_val    *wrapped;
+
+  if (!u->isWrapping) {
+    logic_insert_bulk(cells, size);
+    universe = prev;
+    return;
+  }
+
+  MEM_CHECK(wrapped = malloc((size + 1) * sizeof(coord_val)));
+  for (size_t i = 0; i < size; i++)
+    wrapped[i] = (coord_val){wrap(cells[i].row, u->height),
+                             wrap(cells[i].col, u->width), cells[i].val};
+
+  logic_insert_bulk(wrapped, size);
+  free(wrapped);
+  universe = prev;
+}
+
+/**
+ * @brief Copy the living cells in a region of height x width cells starting
+ * at (row, col) into a new buffer, with coordinates relative to the start of
+ * the region. Return the number of cells
+ *
+ * Buffer is allocated automatically and should be freed with free().
+ */
+size_t gol_query(gol_universe *u, int64_t row, int64_t col, int64_t height,
+                 int64_t width, gol_cell **cells) {
+  gol_universe *prev = enter(u);
+  int           size = logic_extract(wrap(row, u->height), wrap(col, u->width),
+                                     height, width, cells);
+
+  universe = prev;
+  return size;
+}
+
+/**
+ * @brief Kill all cells of the universe
+ */
+void gol_clear(gol_universe *u) {
+  gol_universe *prev = enter(u);
+  logic_clear();
+  universe = prev;
+}
@@ -0,0 +1,304 @@
+/**
+ * @file history.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the history of the running game
+ *
+ * History allows going back to any earlier generation that it still holds.
+ * It is made of segments, each one starting with a keyframe holding all of
+ * the living cells, followed by the cells that changed in each of the
+ * following generations. Both are encoded as described in delta.c. Changes
+ * are reported by the evolution itself, so recording them does not require
+ * comparing the whole game between generations.
+ *
+ * A generation is restored by decoding the keyframe of its segment and
+ * applying the changes up to it. A new keyframe is taken once the changes of
+ * the segment get SEGMENT_RATIO times larger than its keyframe, so restoring
+ * costs at most a few keyframe decodes, no matter how far the game went.
+ *
+ * History is kept within history_budget MiB, the oldest segments are
+ * dropped when it is exceeded. If the game is edited, the edited state
+ * becomes a new keyframe, and going back and playing again replaces the
+ * generations that followed.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "delta.h"
+#include "game.h"
+#include "history.h"
+#include "logic.h"
+#include "record.h"
+#include "utils.h"
+
+/// Minimum size of the changes in a segment before a new keyframe is taken
+#define SEGMENT_MIN 4096
+
+/// Size of the changes in a segment relative to its keyframe before a new
+/// keyframe is taken
+#define SEGMENT_RATIO 8
+
+int history_budget = 64; ///< memory for the history in MiB, 0 to disable
+
+/**
+ * @brief Keyframe with the changes of the generations that follow it
+ */
+typedef struct segment_T {
+  unsigned gen;      ///< generation of the keyframe
+  delta_T  key;      ///< living cells at the generation gen
+  delta_T  changes;  ///< changes of each following generation back to back
+  size_t  *ends;     ///< end of the changes of generation gen + i + 1
+  unsigned count;    ///< number of generations after the keyframe
+  unsigned capacity; ///< capacity of ends
+} segment_T;
+
+static segment_T *segments;   ///< segments from the oldest to the newest
+static int        segments_s; ///< number of segments
+static int        segments_c; ///< capacity of segments
+static int        dirty;      ///< game changed since it was last recorded
+static int        suspended;  ///< keyframe does not fit into the budget
+
+/**
+ * @brief Return the memory used by the segment in bytes
+ */
+static size_t segment_memory(const segment_T *s) {
+  return s->key.capacity + s->changes.capacity +
+         s->capacity * sizeof(size_t);
+}
+
+/**
+ * @brief Free the segment
+ */
+static void segment_free(segment_T *s) {
+  delta_free(&s->key);
+  delta_free(&s->changes);
+  free(s->ends);
+}
+
+/**
+ * @brief Return the last generation held by the segment
+ */
+static unsigned segment_last(const segment_T *s) { return s->gen + s->count; }
+
+/**
+ * @brief Drop all of the segments
+ */
+static void history_clear(void) {
+  for (int i = 0; i < segments_s; i++)
+    segment_free(&segments[i]);
+  segments_s = 0;
+}
+
+/**
+ * @brief Drop every generation after generation
+ */
+static void history_truncate(unsigned generation) {
+  while (segments_s && segments[segments_s - 1].gen > generation)
+    segment_free(&segments[--segments_s]);
+
+  if (segments_s) {
+    segment_T *s = &segments[segments_s - 1];
+    if (segment_last(s) > generation) {
+      s->count = generation - s->gen;
+      s->changes.size = s->count ? s->ends[s->count - 1] : 0;
+    }
+  }
+}
+
+/**
+ * @brief Drop the oldest segments until the history fits into the budget
+ */
+static void history_trim(void) {
+  size_t budget = (size_t)history_budget << 20, used = 0;
+  int    drop = segments_s;
+
+  while (drop > 0 && used + segment_memory(&segments[drop - 1]) <= budget)
+    used += segment_memory(&segments[--drop]);
+
+  // the newest segment is kept even if it alone is over the budget
+  drop = MIN(drop, segments_s - 1);
+  if (drop <= 0)
+    return;
+
+  for (int i = 0; i < drop; i++)
+    segment_free(&segments[i]);
+  memmove(segments, segments + drop, (segments_s - drop) * sizeof(segment_T));
+  segments_s -= drop;
+}
+
+/**
+ * @brief Start a new segment with a keyframe of the game at generation
+ */
+static void history_keyframe(unsigned generation) {
+  coord_val *cells;
+  size_t     size;
+  segment_T *s;
+
+  // the previous segment will not grow anymore
+  if (segments_s)
+    delta_shrink(&segments[segments_s - 1].changes);
+
+  if (segments_s == segments_c) {
+    segments_c = MAX(segments_c * 2, 16);
+    MEM_CHECK(segments = realloc(segments, segments_c * sizeof(segment_T)));
+  }
+
+  size = logic_collect(&cells);
+  delta_sort(cells, size);
+
+  s = &segments[segments_s++];
+  memset(s, 0, sizeof(segment_T));
+  s->gen = generation;
+  for (size_t i = 0; i < size; i++)
+    delta_push(&s->key, &cells[i]);
+  free(cells);
+  delta_shrink(&s->key);
+
+  if (s->key.capacity > (size_t)history_budget << 20) {
+    history_clear();
+    suspended = 1;
+  }
+}
+
+/**
+ * @brief Record the changes of the generation that follows the newest one
+ */
+static void history_record(coord_val *cells, int size) {
+  segment_T *s = &segments[segments_s - 1];
+
+  if (s->count == s->capacity) {
+    s->capacity = MAX(s->capacity * 2, 64);
+    MEM_CHECK(s->ends = realloc(s->ends, s->capacity * sizeof(size_t)));
+  }
+
+  delta_sort(cells, size);
+  delta_begin(&s->changes);
+  for (int i = 0; i < size; i++)
+    delta_push(&s->changes, &cells[i]);
+  s->ends[s->count++] = s->changes.size;
+}
+
+/**
+ * @brief Start recording the history of the current game
+ */
+void history_start(void) {
+  history_clear();
+  dirty = 1;
+  suspended = 0;
+}
+
+/**
+ * @brief Stop recording and free the history
+ */
+void history_stop(void) {
+  history_clear();
+  free(segments);
+  segments = NULL;
+  segments_c = 0;
+}
+
+/**
+ * @brief Mark that the game has been changed by the user at the current
+ * generation
+ */
+void history_edit(void) {
+  dirty = 1;
+  suspended = 0;
+  record_keyframe();
+}
+
+/**
+ * @brief Evolve the game steps times recording each generation, and passing
+ * the changes to the recording if the game is being recorded
+ */
+void history_evolve(int steps) {
+  for (unsigned g = gen; steps--; g++) {
+    int        track = history_budget && !suspended;
+    coord_val *cells;
+    int        size;
+
+    if (track) {
+      // generations after this one are replaced, and so is this one if edited
+      if (dirty && g == 0)
+        history_clear();
+      else
+        history_truncate(dirty ? g - 1 : g);
+
+      if (!segments_s || segment_last(&segments[segments_s - 1]) != g) {
+        history_keyframe(g);
+      } else {
+        segment_T *s = &segments[segments_s - 1];
+        if (s->changes.size >= MAX(s->key.size * SEGMENT_RATIO, SEGMENT_MIN))
+          history_keyframe(g);
+      }
+      dirty = 0;
+    }
+
+    if (!track && !record_active()) {
+      do_evolution(1);
+      continue;
+    }
+
+    size = logic_evolve_changes(&cells);
+    record_changes(cells, size);
+
+    // history_keyframe() might have suspended the history
+    if (!track || !segments_s)
+      continue;
+
+    history_record(cells, size);
+    history_trim();
+  }
+}
+
+/**
+ * @brief Return the memory used by the history in bytes
+ */
+size_t history_memory(void) {
+  size_t used = segments_c * sizeof(segment_T);
+
+  for (int i = 0; i < segments_s; i++)
+    used += segment_memory(&segments[i]);
+  return used;
+}
+
+/**
+ * @brief Get the oldest and the newest generation held by the history, return
+ * 0 if it is empty
+ */
+int history_range(unsigned *first, unsigned *last) {
+  if (!segments_s)
+    return 0;
+
+  *first = segments[0].gen;
+  *last = segment_last(&segments[segments_s - 1]);
+  return 1;
+}
+
+/**
+ * @brief Restore the game at generation, return 0 if the history does not
+ * hold it
+ */
+int history_seek(unsigned generation) {
+  segment_T *s = NULL;
+
+  for (int i = segments_s - 1; i >= 0; i--)
+    if (segments[i].gen <= generation) {
+      s = &segments[i];
+      break;
+    }
+
+  if (s == NULL || generation > segment_last(s))
+    return 0;
+
+  logic_clear();
+  delta_apply(s->key.data, s->key.size);
+  for (unsigned i = 0; i < generation - s->gen; i++) {
+    size_t start = i ? s->ends[i - 1] : 0;
+    delta_apply(s->changes.data + start, s->ends[i] - start);
+  }
+
+  dirty = 0;
+  return 1;
+}
@@ -0,0 +1,548 @@
+/**
+ * @file library.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the index of the pattern library
+ *
+ * Every supported file in the game directory is described by its dimensions,
+ * population, rule and a small thumbnail, so that the menus can list and
+ * preview the patterns without loading them. The descriptions are kept in an
+ * index file in the same directory, and a file is only read again when its
+ * modification time or size changes. On Linux the directory is watched with
+ * inotify, so the sorted list of entries is kept up to date from the reported
+ * changes instead of reading the whole directory again. The index is a text
+ * file with one line per file, holding the tab separated fields of library_T
+ * and the thumbnail in hexadecimal.
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "file.h"
+#include "format.h"
+#include "library.h"
+#include "logic.h"
+#include "record.h"
+#include "snapshot.h"
+#include "utils.h"
+
+/// Name of the index file in the game directory
+#define LIBRARY_INDEX ".library"
+
+/// First line of the index file, changed whenever its layout changes
+#define LIBRARY_MAGIC "GoL library 1"
+
+/// Maximum length of a line in the index file
+#define LINE_SIZE 1024
+
+/// Size of the thumbnail in bytes
+#define THUMB_SIZE (LIBRARY_THUMB_H * LIBRARY_THUMB_W / 4)
+
+library_T **library_entries;   ///< all files sorted by name
+int         library_entries_s; ///< number of files in library_entries
+
+static library_T *library;           ///< all files indexed by name
+static int        library_loaded;    ///< index file has been read
+static int        library_entries_c; ///< capacity of library_entries
+
+#ifdef __linux__
+static int library_watch = -1; ///< inotify descriptor watching the directory
+#endif
+
+/**
+ * @brief Check if the file has one of the extensions that can be loaded
+ */
+static int library_supported(char *name) {
+  char *dot = strrchr(name, '.');
+
+  if (dot == NULL || dot == name)
+    return 0;
+
+  if (!strcmp(dot + 1, "part") || !strcmp(dot + 1, "all") ||
+      !strcmp(dot + 1, SNAPSHOT_EXT) || !strcmp(dot + 1, RECORD_EXT))
+    return 1;
+
+  return format_from_name(name) != FORMAT_NONE;
+}
+
+/**
+ * @brief Create a new entry for the file with name, and add it to the library
+ */
+static library_T *library_new(char *name) {
+  library_T *e;
+  size_t     len = strlen(name);
+
+  MEM_CHECK(e = calloc(1, sizeof(library_T)));
+  MEM_CHECK(e->name = malloc((len + 1) * sizeof(char)));
+  strcpy(e->name, name);
+
+  e->ext = strrchr(e->name, '.') + 1;
+  MEM_CHECK(e->stem = malloc((e->ext - e->name) * sizeof(char)));
+  memcpy(e->stem, e->name, e->ext - e->name - 1);
+  e->stem[e->ext - e->name - 1] = '\0';
+
+  e->rule = -1;
+  HASH_ADD_KEYPTR(hh, library, e->name, len, e);
+  return e;
+}
+
+/**
+ * @brief Remove the entry from the library and free its memory
+ */
+static void library_delete(library_T *e) {
+  HASH_DEL(library, e);
+  free(e->name);
+  free(e->stem);
+  free(e);
+}
+
+/**
+ * @brief Read the pattern of the entry and fill in its description
+ */
+static void library_describe(library_T *e) {
+  cells_T cells = {0};
+  int64_t min_y = 0, min_x = 0, max_y = -1, max_x = -1;
+  int64_t scale = 1;
+
+  e->rule = file_read(e->name, &cells);
+  e->population = 0;
+  memset(e->thumb, 0, THUMB_SIZE);
+
+  for (int i = 0; i < cells.size; i++) {
+    coord_val *c = &cells.cells[i];
+    if (!c->val)
+      continue;
+
+    if (!e->population++) {
+      min_y = max_y = c->row;
+      min_x = max_x = c->col;
+    }
+    min_y = MIN(min_y, c->row);
+    min_x = MIN(min_x, c->col);
+    max_y = MAX(max_y, c->row);
+    max_x = MAX(max_x, c->col);
+  }
+
+  e->height = max_y - min_y + 1;
+  e->width = max_x - min_x + 1;
+
+  if (!e->population) {
+    cells_free(&cells);
+    return;
+  }
+
+  scale = MAX((e->height + LIBRARY_THUMB_H - 1) / LIBRARY_THUMB_H,
+              (e->width + LIBRARY_THUMB_W - 1) / LIBRARY_THUMB_W);
+  scale = MAX(scale, 1);
+
+  for (int i = 0; i < cells.size; i++) {
+    coord_val *c = &cells.cells[i];
+    if (!c->val)
+      continue;
+
+    int val = MIN(c->val, 3);
+    int n = (c->row - min_y) / scale * LIBRARY_THUMB_W +
+            (c->col - min_x) / scale;
+    int old = (e->thumb[n / 4] >> (n % 4 * 2)) & 3;
+
+    if (val > old)
+      e->thumb[n / 4] += (val - old) << (n % 4 * 2);
+  }
+
+  cells_free(&cells);
+}
+
+/**
+ * @brief Return the value of a hexadecimal digit
+ */
+static int hex_digit(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return 0;
+}
+
+/**
+ * @brief Read the index file into the library
+ */
+static void library_read(void) {
+  char  line[LINE_SIZE];
+  FILE *f = fopen(LIBRARY_INDEX, "r");
+
+  if (f == NULL)
+    return;
+
+  if (fgets(line, LINE_SIZE, f) == NULL ||
+      strncmp(line, LIBRARY_MAGIC, strlen(LIBRARY_MAGIC))) {
+    fclose(f);
+    return;
+  }
+
+  while (fgets(line, LINE_SIZE, f) != NULL) {
+    library_T  t = {0}, *e;
+    char      *tab = strchr(line, '\t');
+    char       hex[THUMB_SIZE * 2 + 1];
+
+    if (tab == NULL)
+      continue;
+    *tab = '\0';
+
+    if (sscanf(tab + 1, "%lld %lld %lld %lld %ld %d %256s", &t.mtime, &t.size,
+               &t.height, &t.width, &t.population, &t.rule, hex) != 7 ||
+        strlen(hex) != THUMB_SIZE * 2 || !library_supported(line))
+      continue;
+
+    HASH_FIND_STR(library, line, e);
+    if (e == NULL)
+      e = library_new(line);
+
+    e->mtime = t.mtime;
+    e->size = t.size;
+    e->height = t.height;
+    e->width = t.width;
+    e->population = t.population;
+    e->rule = t.rule;
+    for (int i = 0; i < THUMB_SIZE; i++)
+      e->thumb[i] = hex_digit(hex[i * 2]) << 4 | hex_digit(hex[i * 2 + 1]);
+  }
+
+  fclose(f);
+}
+
+/**
+ * @brief Write the library into the index file
+ *
+ * Index is written into a temporary file first, so that it's never left half
+ * written. Files with tabs or new lines in their names are not indexed.
+ */
+static void library_write(void) {
+  FILE *f = fopen(LIBRARY_INDEX ".tmp", "w");
+
+  if (f == NULL)
+    return;
+
+  fprintf(f, "%s\n", LIBRARY_MAGIC);
+  for (library_T *e = library; e != NULL; e = e->hh.next) {
+    if (strpbrk(e->name, "\t\n\r"))
+      continue;
+
+    fprintf(f, "%s\t%lld %lld %lld %lld %ld %d ", e->name, e->mtime, e->size,
+            e->height, e->width, e->population, e->rule);
+    for (int i = 0; i < THUMB_SIZE; i++) {
+      fputc("0123456789abcdef"[e->thumb[i] >> 4], f);
+      fputc("0123456789abcdef"[e->thumb[i] & 15], f);
+    }
+    fputc('\n', f);
+  }
+
+  if (fclose(f) == 0)
+    rename(LIBRARY_INDEX ".tmp", LIBRARY_INDEX);
+}
+
+/**
+ * @brief Compare the names of two entries, used for sorting
+ */
+static int library_cmp(const void *a, const void *b) {
+  return strcmp((*(library_T **)a)->name, (*(library_T **)b)->name);
+}
+
+/**
+ * @brief Make room for n entries in library_entries
+ */
+static void library_reserve(int n) {
+  library_T **t;
+
+  if (n <= library_entries_c)
+    return;
+
+  library_entries_c = MAX(n, library_entries_c * 2);
+  MEM_CHECK(t = realloc(library_entries,
+                        library_entries_c * sizeof(library_T *)));
+  library_entries = t;
+}
+
+/**
+ * @brief Bring the entry for the file with name up to date, creating or
+ * deleting it as needed. Return 1 if anything changed
+ *
+ * If force is not set, the file is only read when its modification time or
+ * size is different from the ones in the entry.
+ */
+static int library_sync(char *name, int force) {
+  struct stat st;
+  library_T  *e;
+
+  HASH_FIND_STR(library, name, e);
+  if (stat(name, &st) != 0 || !S_ISREG(st.st_mode)) {
+    if (e == NULL)
+      return 0;
+
+    library_delete(e);
+    return 1;
+  }
+
+  if (e == NULL)
+    e = library_new(name);
+  else if (!force && e->mtime == st.st_mtime && e->size == st.st_size) {
+    e->seen = 1;
+    return 0;
+  }
+
+  e->mtime = st.st_mtime;
+  e->size = st.st_size;
+  e->seen = 1;
+  library_describe(e);
+  return 1;
+}
+
+/**
+ * @brief Read the whole directory, bringing all entries up to date and
+ * removing the ones for the files that are gone. Return 1 if anything changed
+ */
+static int library_scan(void) {
+  struct dirent *de;
+  library_T     *e, *tmp;
+  DIR           *dr;
+  int            changed = 0;
+
+  for (e = library; e != NULL; e = e->hh.next)
+    e->seen = 0;
+
+  if ((dr = opendir(".")) != NULL) {
+    while ((de = readdir(dr)) != NULL)
+      if (library_supported(de->d_name))
+        changed |= library_sync(de->d_name, 0);
+    closedir(dr);
+  }
+
+  HASH_ITER(hh, library, e, tmp) {
+    if (!e->seen) {
+      library_delete(e);
+      changed = 1;
+    }
+  }
+
+  library_entries_s = 0;
+  library_reserve(HASH_COUNT(library) + 1);
+  for (e = library; e != NULL; e = e->hh.next)
+    library_entries[library_entries_s++] = e;
+  qsort(library_entries, library_entries_s, sizeof(library_T *), library_cmp);
+
+  return changed;
+}
+
+#ifdef __linux__
+/**
+ * @brief Start watching the directory for changes, falling back to scanning it
+ * each time if that's not possible
+ *
+ * Creation is watched for the hard links and symbolic links, that are never
+ * written to through the directory.
+ */
+static void library_watch_start(void) {
+  library_watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (library_watch < 0)
+    return;
+
+  if (inotify_add_watch(library_watch, ".",
+                        IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO |
+                            IN_MOVED_FROM | IN_DELETE | IN_DELETE_SELF |
+                            IN_MOVE_SELF) < 0) {
+    close(library_watch);
+    library_watch = -1;
+  }
+}
+
+/**
+ * @brief Return the position of the entry with name in library_entries, or
+ * where it should be inserted if there is no such entry
+ */
+static int library_position(const char *name) {
+  int low = 0, high = library_entries_s;
+
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (strcmp(library_entries[mid]->name, name) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  return low;
+}
+
+/**
+ * @brief Read the file with name again after it was reported as changed,
+ * keeping library_entries sorted. Return 1 if anything changed
+ */
+static int library_refresh(char *name) {
+  int        pos = library_position(name), changed;
+  int        found = pos < library_entries_s &&
+              !strcmp(library_entries[pos]->name, name);
+  library_T *e;
+
+  changed = library_sync(name, 1);
+  HASH_FIND_STR(library, name, e);
+
+  if (found && e == NULL) {
+    memmove(library_entries + pos, library_entries + pos + 1,
+            (--library_entries_s - pos) * sizeof(library_T *));
+  } else if (!found && e != NULL) {
+    library_reserve(library_entries_s + 1);
+    memmove(library_entries + pos + 1, library_entries + pos,
+            (library_entries_s++ - pos) * sizeof(library_T *));
+    library_entries[pos] = e;
+  }
+
+  return changed;
+}
+
+/**
+ * @brief Apply the pending changes reported for the directory. Return 1 if
+ * anything changed
+ *
+ * When events were lost, or the directory itself was moved or deleted, the
+ * whole directory is scanned instead.
+ */
+static int library_events(void) {
+  char buffer[4096]
+      __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t len;
+  int     changed = 0, rescan = 0;
+
+  while ((len = read(library_watch, buffer, sizeof(buffer))) > 0) {
+    struct inotify_event *ev;
+
+    for (char *p = buffer; p < buffer + len; p += sizeof(*ev) + ev->len) {
+      ev = (struct inotify_event *)p;
+
+      if (ev->mask & IN_Q_OVERFLOW)
+        rescan = 1;
+
+      if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+        close(library_watch);
+        library_watch = -1;
+        return changed | library_scan();
+      }
+
+      if (ev->len && library_supported(ev->name))
+        changed |= library_refresh(ev->name);
+    }
+  }
+
+  return rescan ? changed | library_scan() : changed;
+}
+#endif
+
+/**
+ * @brief Bring the library up to date with the current directory and fill
+ * library_entries
+ *
+ * The index file is read and the directory is scanned on the first call. After
+ * that, changes to the directory are picked up from inotify on Linux, so only
+ * the files that were created, written, moved or deleted are looked at. Other
+ * systems scan the directory each time, reading only the files that are new or
+ * whose modification time or size changed. The index file is written again if
+ * anything changed.
+ */
+void library_update(void) {
+  int changed;
+
+  if (!library_loaded) {
+    library_read();
+    library_loaded = 1;
+#ifdef __linux__
+    library_watch_start();
+#endif
+    changed = library_scan();
+  }
+#ifdef __linux__
+  else if (library_watch >= 0)
+    changed = library_events();
+#endif
+  else
+    changed = library_scan();
+
+  if (changed)
+    library_write();
+}
+
+/**
+ * @brief Free the memory used by the library
+ */
+void library_free(void) {
+  library_T *e, *tmp;
+
+  HASH_ITER(hh, library, e, tmp) { library_delete(e); }
+
+#ifdef __linux__
+  if (library_watch >= 0)
+    close(library_watch);
+  library_watch = -1;
+#endif
+
+  free(library_entries);
+  library_entries = NULL;
+  library_entries_s = library_entries_c = 0;
+  library_loaded = 0;
+}
+
+/**
+ * @brief Draw the description and thumbnail of the library entry passed as
+ * data, in the h x w area of the window starting at (y, x)
+ */
+void library_preview(WINDOW *win, int y, int x, int h, int w, void *data) {
+  library_T *e = data;
+  long long  scale;
+  int        rows, cols;
+
+  if (e == NULL || h < 4 || w < 12)
+    return;
+
+  wattrset(win, COLOR_PAIR(0));
+  mvwprintw(win, y++, x, "%.*s", w, e->ext);
+  mvwprintw(win, y++, x, "%lldx%lld", e->width, e->height);
+  mvwprintw(win, y++, x, "%ld cells", e->population);
+  mvwprintw(win, y++, x, "%.*s", w,
+            e->rule >= 0 && e->rule < evolution_size ? evolution_names[e->rule]
+                                                     : "-");
+  h -= 5;
+  y++;
+
+  if (!e->population || h <= 0)
+    return;
+
+  scale = MAX((e->height + LIBRARY_THUMB_H - 1) / LIBRARY_THUMB_H,
+              (e->width + LIBRARY_THUMB_W - 1) / LIBRARY_THUMB_W);
+  scale = MAX(scale, 1);
+  rows = MIN((e->height + scale - 1) / scale, h);
+  cols = MIN((e->width + scale - 1) / scale, w);
+
+  for (int i = 0; i < rows; i++) {
+    wmove(win, y + i, x);
+    for (int j = 0; j < cols; j++) {
+      int n = i * LIBRARY_THUMB_W + j;
+      int val = (e->thumb[n / 4] >> (n % 4 * 2)) & 3;
+
+      if (val) {
+        wattrset(win, COLOR_PAIR(val + PAIR_CELL) | A_REVERSE);
+        waddch(win, ' ');
+      } else {
+        wattrset(win, COLOR_PAIR(0));
+        waddch(win, '.');
+      }
+    }
+  }
+  wattrset(win, COLOR_PAIR(0));
+}
@@ -5,136 +5,318 @@
  * @brief This file contains functions used in games logic.
  */
 
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-#include "game.h"
+#include "escape.h"
 #include "logic.h"
+#include "page.h"
 #include "utils.h"
 
-Cell *hash = NULL;
+/// Number of cells allocated at once when the pool runs out
+#define POOL_CHUNK 4096
+
+/// Cells are sorted into tiles of 2^TILE_BITS x 2^TILE_BITS before inserting
+#define TILE_BITS 6
+
+/// Low bits of the value that hold the state of a cell of the Generations
+/// family during the evolution, the rest count its living neighbours
+#define GENERATIONS_BITS 4
+
+/// Value added to the neighbours of a living cell of the Generations family
+#define GENERATIONS_ALIVE (1 << GENERATIONS_BITS)
+
+static gol_universe main_universe; ///< universe of the game interface
+
+/// Universe that the functions work on, separate for each thread
+_Thread_local gol_universe *universe = &main_universe;
+
+/**
+ * @brief function that records the new value of a cell changed by the
+ * evolution;
+ */
+static void change_push(gol_universe *u, Cell *c, int val) {
+  if (u->change_cells_s == u->change_cells_c) {
+    coord_val *t;
+    u->change_cells_c = MAX(u->change_cells_c * 2, 1024);
+    MEM_CHECK(t = realloc(u->change_cells,
+                          u->change_cells_c * sizeof(coord_val)));
+    u->change_cells = t;
+  }
+  u->change_cells[u->change_cells_s++] =
+      (coord_val){c->cord.row, c->cord.col, val};
+}
+
+/**
+ * @brief function that allocates a block of n cells and adds them to the pool
+ * so that they are handed out in the order of their addresses;
+ */
+static void pool_grow(gol_universe *u, size_t n) {
+  Cell **chunks, *block;
+
+  MEM_CHECK(block = malloc(n * sizeof(Cell)));
+  MEM_CHECK(chunks = realloc(u->pool_chunks,
+                             (u->pool_chunks_s + 1) * sizeof(Cell *)));
+  u->pool_chunks = chunks;
+  u->pool_chunks[u->pool_chunks_s++] = block;
+
+  for (size_t k = 0; k + 1 < n; k++)
+    block[k].hh.next = &block[k + 1];
+  block[n - 1].hh.next = u->pool_free;
+  u->pool_free = block;
+  u->pool_free_s += n;
+  u->pool_cells += n;
+}
+
+/**
+ * @brief function that takes an unused cell from the pool;
+ */
+static Cell *cell_alloc(gol_universe *u) {
+  Cell *c;
+
+  if (!u->pool_free)
+    pool_grow(u, POOL_CHUNK);
+
+  c = u->pool_free;
+  u->pool_free = c->hh.next;
+  u->pool_free_s--;
+  return c;
+}
+
+/**
+ * @brief function that returns the cell to the pool;
+ */
+static void cell_free(gol_universe *u, Cell *c) {
+  c->hh.next = u->pool_free;
+  u->pool_free = c;
+  u->pool_free_s++;
+}
 
 /**
  * @brief function that delets cell from hash table utilazing uthash.h
  */
-void deleter(Cell *c) {
-  HASH_DEL(hash, c);
-  free(c);
+static void deleter(gol_universe *u, Cell *c) {
+  if (u->isTracking && c->prev)
+    change_push(u, c, 0);
+  HASH_DEL(u->hash, c);
+  cell_free(u, c);
 }
 
 /**
- * @brief function that returns pointer to the cell in hash table at given
- * position.
+ * @brief function that returns the hash of the coordinates;
+ *
+ * Both coordinates are packed into one 64-bit key and mixed with two
+ * multiplications, which is much cheaper than hashing the 16 bytes of the key
+ * byte by byte. The upper half of the product depends on all bits of the key.
+ */
+static uint32_t cord_hash(int64_t row, int64_t col) {
+  uint64_t key = (uint64_t)row * 0x9E3779B97F4A7C15 ^ (uint64_t)col;
+  return (key * 0xBF58476D1CE4E5B9) >> 32;
+}
+
+/**
+ * @brief function that adds the cell with the given hash of its coordinates
+ * to the hash table;
  */
-Cell *get(int row, int col) {
-  Cell *c, t;
+static void hash_add(gol_universe *u, Cell *c, uint32_t hashv) {
+  HASH_ADD_BYHASHVALUE(hh, u->hash, cord, sizeof(Cell_cord), hashv, c);
+}
 
-  memset(&t, 0, sizeof(Cell));
-  t.cord.row = row;
-  t.cord.col = col;
-  HASH_FIND(hh, hash, &t.cord, sizeof(Cell_cord), c);
+/**
+ * @brief function that returns pointer to the cell in hash table at given
+ * position, with the given hash of its coordinates.
+ */
+static Cell *get_hashed(gol_universe *u, int64_t row, int64_t col,
+                        uint32_t hashv) {
+  Cell_cord t = {row, col};
+  Cell     *c;
 
+  HASH_FIND_BYHASHVALUE(hh, u->hash, &t, sizeof(Cell_cord), hashv, c);
   return c;
 }
 
-void insert(int row, int col, int val, int mod) {
-  Cell *c;
+/**
+ * @brief function that returns pointer to the cell in hash table at given
+ * position.
+ */
+static Cell *get(gol_universe *u, int64_t row, int64_t col) {
+  return get_hashed(u, row, col, cord_hash(row, col));
+}
 
-  c = get(row, col);
+/**
+ * @brief function that adds mod to the value of the cell at given position,
+ * inserting it with the value val if it's not in the hash table.
+ */
+static void insert(gol_universe *u, int64_t row, int64_t col, int val,
+                   int mod) {
+  uint32_t hashv = cord_hash(row, col);
+  Cell    *c;
+
+  c = get_hashed(u, row, col, hashv);
   if (c == NULL) {
-    MEM_CHECK(c = malloc(sizeof(Cell)));
+    c = cell_alloc(u);
     c->cord.row = row;
     c->cord.col = col;
     c->val = val;
-    HASH_ADD(hh, hash, cord, sizeof(Cell_cord), c);
+    c->prev = 0;
+    hash_add(u, c, hashv);
   }
   c->val += mod;
 }
 
-extern int width, height;
-int        isExpanding;
+char *evolution_names[] = {"Normal",        "CoExsistance", "Predator",
+                           "Virus",         "Unknown",      "Brian's Brain",
+                           "Star Wars",     "Frogs",        "Spirals"};
+char *evolution_rules[] = {"B3/S23",     NULL,         NULL,
+                           NULL,         NULL,         "B2/S/C3",
+                           "B2/S345/C4", "B34/S12/C3", "B234/S2/C5"};
+int   evolution_cells[] = {2, 3, 3, 3, 3, 3, 4, 3, 5};
+int   evolution_random[] = {0, 0, 0, 0, 1,
+                            0, 0, 0, 0}; ///< game mode is not deterministic
+int   evolution_size = 9;
+
+/**
+ * @brief function that parses a rule of the Generations family, in the B/S/C
+ * notation like B2/S345/C4, or the S/B/C one like 345/2/4, into the masks of
+ * the numbers of living neighbours a cell is born and survives with, and the
+ * number of states. Return 0 if the rule is not valid;
+ *
+ * A rule without the number of states is a Life-like rule of two states.
+ * Rules where cells are born without living neighbours are not supported,
+ * they would fill the unlimited universe at once.
+ */
+int logic_rule(const char *rule, uint16_t *birth, uint16_t *survive,
+               int *states) {
+  const char *p = rule;
+  char       *end;
+
+  *birth = *survive = 0;
+  *states = 2;
+
+  for (int part = 0; part < 3; part++) {
+    int kind = tolower((unsigned char)*p);
 
-Cell **save_cells;
-int    save_cells_s;
-int    save_cells_sm;
+    // without the letters, parts are the survival, birth and states in order
+    if (kind == 'b' || kind == 's' || kind == 'c')
+      p++;
+    else
+      kind = "sbc"[part];
 
-int pos_y;
-int pos_x;
+    if (kind == 'c') {
+      if (!isdigit((unsigned char)*p))
+        return 0;
+      *states = strtol(p, &end, 10);
+      p = end;
+    } else
+      for (; *p >= '0' && *p <= '8'; p++)
+        *(kind == 'b' ? birth : survive) |= 1 << (*p - '0');
 
-char *evolution_names[] = {"Normal", "CoExsistance", "Predator", "Virus",
-                           "Unknown"};
-int   evolution_cells[] = {2, 3, 3, 3, 3};
-int   evolution_size = 5;
-int   evolve_index;
-int   toggle_mod = 2;
+    if (*p != '/')
+      break;
+    p++;
+  }
 
-static void (*evolve)(void);
-static void (*addToCells)(int i, int j, int value);
+  return !*p && *states >= 2 && *states <= STATES_MAX && !(*birth & 1);
+}
 
 /**
- * @brief function that adds its value to neighbouring cells;
+ * @brief function that returns the next number of the random number generator
+ * of the universe, xorshift32;
  */
+static uint32_t logic_rand(gol_universe *u) {
+  uint32_t x = u->rng;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return u->rng = x;
+}
 
-void addToCellsNormal(int i, int j, int value) {
-  int mod = 0;
+/**
+ * @brief function that returns the value a cell adds to its neighbours, 4 for
+ * each neighbour of the first kind and 32 for each of the second;
+ */
+static int neighbour_mod(int value) {
   switch (value & 3) {
   case 1:
-    mod = 4;
-    break;
+    return 4;
   case 2:
-    mod = 32;
-    break;
+    return 32;
   }
-  for (int k = i - 1; k <= i + 1; k++)
-    for (int l = j - 1; l <= j + 1; l++)
+  return 0;
+}
+
+/**
+ * @brief function that adds mod to neighbouring cells;
+ */
+
+static void addToCellsNormal(gol_universe *u, int64_t i, int64_t j, int mod) {
+  for (int64_t k = i - 1; k <= i + 1; k++)
+    for (int64_t l = j - 1; l <= j + 1; l++)
       if (k != i || l != j)
-        insert(k, l, 0, mod);
+        insert(u, k, l, 0, mod);
 }
 
 /**
  * @brief simmilar to addToCellsNormal() with exception that it check for
  * corners in case of wrapping;
  */
-void addToCellsWrap(int i, int j, int value) {
-  int mod = 0;
-  switch (value & 3) {
-  case 1:
-    mod = 4;
-    break;
-  case 2:
-    mod = 32;
-    break;
-  }
-
-  for (int k = i - 1; k <= i + 1; k++)
-    for (int l = j - 1; l <= j + 1; l++) {
-      int a = WCLAMP(k, height);
-      int b = WCLAMP(l, width);
+static void addToCellsWrap(gol_universe *u, int64_t i, int64_t j, int mod) {
+  for (int64_t k = i - 1; k <= i + 1; k++)
+    for (int64_t l = j - 1; l <= j + 1; l++) {
+      int64_t a = WCLAMP(k, u->height);
+      int64_t b = WCLAMP(l, u->width);
       if (a != i || b != j)
-        insert(a, b, 0, mod);
+        insert(u, a, b, 0, mod);
     }
 }
 
-void doAdditions(void) {
-  Cell *c;
+/**
+ * @brief function that adds the value of every cell to its neighbours;
+ *
+ * New cells are appended to the end of the hash, so only the cells that were
+ * there at the start are visited. Their values are remembered in prev.
+ */
+static void doAdditions(gol_universe *u) {
+  Cell    *c;
+  unsigned size = HASH_COUNT(u->hash);
 
-  Cell *buff[10000];
-  int   size = 0;
-  for (c = hash; c != NULL; c = c->hh.next)
-    buff[size++] = c;
+  for (c = u->hash; size--; c = c->hh.next) {
+    c->prev = c->val;
+    u->addToCells(u, c->cord.row, c->cord.col, neighbour_mod(c->val));
+  }
+}
+
+/**
+ * @brief function that adds the living cells of the Generations family to
+ * their neighbours;
+ *
+ * Counts are added above the GENERATIONS_BITS of the state, so the state of a
+ * cell can be remembered in prev even after some of its neighbours were added.
+ */
+static void doAdditionsGenerations(gol_universe *u) {
+  Cell    *c;
+  unsigned size = HASH_COUNT(u->hash);
 
-  for (int i = 0; i < size; i++)
-    addToCells(buff[i]->cord.row, buff[i]->cord.col, buff[i]->val);
+  for (c = u->hash; size--; c = c->hh.next) {
+    c->prev = c->val & (GENERATIONS_ALIVE - 1);
+    if (c->prev == 1)
+      u->addToCells(u, c->cord.row, c->cord.col, GENERATIONS_ALIVE);
+  }
 }
 
 /**
  * @brief function responsible for calculation for a game mode called "Normal";
  */
-void evolveNormal(void) {
+static void evolveNormal(gol_universe *u) {
   Cell *c, *c_next;
 
-  doAdditions();
-  for (c = hash; c != NULL; c = c_next) {
+  doAdditions(u);
+  for (c = u->hash; c != NULL; c = c_next) {
     c_next = c->hh.next;
     switch (c->val) {
     case 9:
@@ -143,7 +325,7 @@ void evolveNormal(void) {
       c->val = 1;
       break;
     default:
-      deleter(c);
+      deleter(u, c);
     }
   }
 }
@@ -151,12 +333,12 @@ void evolveNormal(void) {
 /**
  * @brief function responsible for calculation for a game mode called "CoExist";
  */
-void evolveCoExist(void) {
+static void evolveCoExist(gol_universe *u) {
   Cell *c, *c_next;
 
-  doAdditions();
+  doAdditions(u);
   int s1, s2, mod;
-  for (c = hash; c != NULL; c = c_next) {
+  for (c = u->hash; c != NULL; c = c_next) {
     c_next = c->hh.next;
     s2 = c->val >> 5;
     s1 = (c->val & 31) >> 2;
@@ -171,7 +353,7 @@ void evolveCoExist(void) {
       }
     }
     if ((s1 + s2) < 2 || (s1 + s2) > 3) {
-      deleter(c);
+      deleter(u, c);
     }
     c->val = mod;
   }
@@ -181,17 +363,17 @@ void evolveCoExist(void) {
  * @brief function responsible for calculation for a game mode called
  * "Predator";
  */
-void evolvePredator(void) {
+static void evolvePredator(gol_universe *u) {
   Cell *c, *c_next;
-  doAdditions();
+  doAdditions(u);
   int s1, s2, mod;
-  for (c = hash; c != NULL; c = c_next) {
+  for (c = u->hash; c != NULL; c = c_next) {
     c_next = c->hh.next;
     s2 = c->val >> 5;
     s1 = (c->val & 31) >> 2;
     mod = c->val & 3;
     if ((s1 + s2) < 2 || (s1 + s2) > 3) {
-      deleter(c);
+      deleter(u, c);
       continue;
     }
     switch (mod) {
@@ -203,11 +385,11 @@ void evolvePredator(void) {
           c->val = 1;
         continue;
       }
-      deleter(c);
+      deleter(u, c);
       break;
     case 1:
       if (s2 > 0) {
-        deleter(c);
+        deleter(u, c);
         continue;
       }
       break;
@@ -219,17 +401,17 @@ void evolvePredator(void) {
 /**
  * @brief function responsible for calculation for a game mode called "Virus";
  */
-void evolveVirus(void) {
+static void evolveVirus(gol_universe *u) {
   Cell *c, *c_next;
-  doAdditions();
+  doAdditions(u);
   int s1, s2, mod;
-  for (c = hash; c != NULL; c = c_next) {
+  for (c = u->hash; c != NULL; c = c_next) {
     c_next = c->hh.next;
     s2 = c->val >> 5;
     s1 = (c->val & 31) >> 2;
     mod = c->val & 3;
     if ((s1 + s2) < 2 || (s1 + s2) > 3) {
-      deleter(c);
+      deleter(u, c);
       continue;
     }
     switch (mod) {
@@ -241,7 +423,7 @@ void evolveVirus(void) {
           c->val = 1;
         continue;
       }
-      deleter(c);
+      deleter(u, c);
       break;
     case 1:
       if (s2 > 0) {
@@ -257,12 +439,13 @@ void evolveVirus(void) {
 /**
  * @brief function responsible for calculation for a game mode called "Unknown";
  */
-void evolveUnknown(void) { // Assumption 3 ones and 3 twos result in 50/50
-                           // chanse of 0 becoming one of them:
+// Assumption 3 ones and 3 twos result in 50/50 chanse of 0 becoming one of
+// them:
+static void evolveUnknown(gol_universe *u) {
   Cell *c, *c_next;
-  doAdditions();
+  doAdditions(u);
   int s1, s2, mod;
-  for (c = hash; c != NULL; c = c_next) {
+  for (c = u->hash; c != NULL; c = c_next) {
     c_next = c->hh.next;
     s2 = c->val >> 5;
     s1 = (c->val & 31) >> 2;
@@ -270,7 +453,7 @@ void evolveUnknown(void) { // Assumption 3 ones and 3 twos result in 50/50
     switch (mod) {
     case 0:
       if (s1 == 3 && s2 == 3) {
-        c->val = rand() % 2 + 1;
+        c->val = logic_rand(u) % 2 + 1;
         continue;
       }
       if (s1 == 3) {
@@ -281,17 +464,17 @@ void evolveUnknown(void) { // Assumption 3 ones and 3 twos result in 50/50
         c->val = 2;
         continue;
       }
-      deleter(c);
+      deleter(u, c);
       break;
     case 1:
       if (s1 < 2 || s1 > 3) {
-        deleter(c);
+        deleter(u, c);
         continue;
       }
       break;
     case 2:
       if (s2 < 2 || s2 > 3) {
-        deleter(c);
+        deleter(u, c);
         continue;
       }
       break;
@@ -300,33 +483,111 @@ void evolveUnknown(void) { // Assumption 3 ones and 3 twos result in 50/50
   }
 }
 
+/**
+ * @brief function responsible for calculation for the game modes of the
+ * Generations family;
+ *
+ * Living cells have the state 1, and when they don't survive they go through
+ * the decay states 2 and up until they die. Decaying cells don't count as
+ * living neighbours, and no cell is born in their place until they die.
+ */
+static void evolveGenerations(gol_universe *u) {
+  Cell *c, *c_next;
+
+  doAdditionsGenerations(u);
+  for (c = u->hash; c != NULL; c = c_next) {
+    int state = c->val & (GENERATIONS_ALIVE - 1);
+    int count = c->val >> GENERATIONS_BITS;
+
+    c_next = c->hh.next;
+    if (state == 0 ? u->birth >> count & 1
+                   : state == 1 && u->survive >> count & 1)
+      c->val = 1;
+    else if (state && state + 1 < u->toggle_mod)
+      c->val = state + 1;
+    else
+      deleter(u, c);
+  }
+}
+
 /* Initializing functions */
-static void (*evolution_modes[])() = {
-    evolveNormal, evolveCoExist, evolvePredator, evolveVirus, evolveUnknown};
-static void (*addition_modes[])(int i, int j, int value) = {addToCellsNormal,
-                                                            addToCellsWrap};
+static void (*evolution_modes[])(gol_universe *u) = {
+    evolveNormal,      evolveCoExist,     evolvePredator,
+    evolveVirus,       evolveUnknown,     evolveGenerations,
+    evolveGenerations, evolveGenerations, evolveGenerations};
+static void (*addition_modes[])(gol_universe *u, int64_t i, int64_t j,
+                                int mod) = {
+    addToCellsNormal, addToCellsWrap};
+
+/**
+ * @brief function that evolves the universe one step, removing the escaping
+ * spaceships if it's time to;
+ */
+static void evolve_step(gol_universe *u) {
+  u->evolve(u);
+  u->generation++;
+
+  if (u->escape && u->generation % u->escape == 0)
+    escape_remove(u);
+
+  if (u->page)
+    page_step(u);
+}
 
 /**
  * @brief parent function that calls evolution;
  */
 void do_evolution(int steps) {
-  while (steps--) {
-    evolve();
-  }
+  gol_universe *u = universe;
+
+  while (steps--)
+    evolve_step(u);
+}
+
+/**
+ * @brief function that evolves the game one step and returns the cells that
+ * changed with their new values, 0 for the cells that died. The buffer is
+ * valid until the next call;
+ */
+int logic_evolve_changes(coord_val **buffer) {
+  gol_universe *u = universe;
+
+  u->change_cells_s = 0;
+
+  // removed spaceships are recorded as changes as well
+  u->isTracking = 1;
+  evolve_step(u);
+  u->isTracking = 0;
+
+  for (Cell *c = u->hash; c != NULL; c = c->hh.next)
+    if (c->val != c->prev)
+      change_push(u, c, c->val);
+
+  *buffer = u->change_cells;
+  return u->change_cells_s;
 }
 
 /**
- * @brief init function for game logic;
+ * @brief init function for game logic, the universe wraps around if both
+ * height and width are set;
  */
-int logic_init(int isWrapping, int index) {
-  save_cells_s = 0;
-  save_cells_sm = 100;
-  MEM_CHECK(save_cells = malloc(save_cells_sm * sizeof(struct Cell *)));
+int logic_init(int height, int width, int index) {
+  gol_universe *u = universe;
+
+  u->isWrapping = height > 0 && width > 0;
+  u->height = u->isWrapping ? height : 0;
+  u->width = u->isWrapping ? width : 0;
+  u->addToCells = addition_modes[u->isWrapping];
+  u->evolve = evolution_modes[index];
+  u->evolve_index = index;
+  u->toggle_mod = evolution_cells[index];
 
-  addToCells = addition_modes[isWrapping];
-  evolve = evolution_modes[index];
-  evolve_index = index;
-  toggle_mod = evolution_cells[index];
+  if (evolution_rules[index])
+    logic_rule(evolution_rules[index], &u->birth, &u->survive,
+               &u->toggle_mod);
+
+  if (!u->rng)
+    setSeed(u->seed);
   return 1;
 }
 
@@ -334,79 +595,532 @@ int logic_init(int isWrapping, int index) {
  * @brief memory cleaner for logic.c;
  */
 int logic_free(void) {
-  HASH_CLEAR(hh, hash);
-  addToCells = NULL;
-  evolve = NULL;
-  toggle_mod = -1;
-  free(save_cells);
-  save_cells_s = 0;
+  gol_universe *u = universe;
+
+  HASH_CLEAR(hh, u->hash);
+  for (int i = 0; i < u->pool_chunks_s; i++)
+    free(u->pool_chunks[i]);
+  free(u->pool_chunks);
+  free(u->change_cells);
+  free(u->escaped);
+  page_close(u);
+  memset(u, 0, sizeof(gol_universe));
+  u->toggle_mod = -1;
   return 1;
 }
 
+/**
+ * @brief function that removes all cells, keeping them in the pool;
+ */
+void logic_clear(void) {
+  Cell *c, *tmp;
+
+  HASH_ITER(hh, universe->hash, c, tmp) { deleter(universe, c); }
+  page_clear(universe);
+}
+
 /**
  * @brief function that toggles the value at coords (i,j). E.g from 0->1, 1->2
  * or 2->0;
  */
-int toggleAt(int i, int j) {
-  Cell *c;
+int toggleAt(int64_t i, int64_t j) {
+  gol_universe *u = universe;
+  Cell         *c;
 
-  if (!(c = get(i, j))) {
-    insert(i, j, 1, 0);
+  page_touch(u, i, j, 1, 1);
+  if (!(c = get(u, i, j))) {
+    insert(u, i, j, 1, 0);
     return 1;
   }
 
-  int val = c->val = (c->val + 1) % toggle_mod;
+  int val = c->val = (c->val + 1) % u->toggle_mod;
   if (!c->val)
-    deleter(c);
+    deleter(u, c);
   return val;
 }
 
 /**
  * @brief function that destroys cell at coords(i,j);
  */
-void deleteAt(int i, int j) {
+void deleteAt(int64_t i, int64_t j) {
   Cell *c;
 
-  if ((c = get(i, j)))
-    deleter(c);
+  page_touch(universe, i, j, 1, 1);
+  if ((c = get(universe, i, j)))
+    deleter(universe, c);
 }
 
 /**
  * @brief function that sets value(val) at coords(i,j);
  */
-void setAt(int i, int j, int val) {
+void setAt(int64_t i, int64_t j, int val) {
   Cell *c;
 
-  if ((c = get(i, j)) != NULL)
+  page_touch(universe, i, j, 1, 1);
+  if ((c = get(universe, i, j)) != NULL)
     c->val = val;
   else
-    insert(i, j, val, 0);
+    insert(universe, i, j, val, 0);
 }
 
 /**
  * @brief functiong that returns value of a cell at given coords.
  */
-int getAt(int i, int j) {
-  Cell *c = get(i, j);
-  return ((c) ? c->val : 0);
+int getAt(int64_t i, int64_t j) {
+  Cell *c = get(universe, i, j);
+  return ((c) ? c->val : page_get(universe, i, j));
+}
+
+/**
+ * @brief function that seeds the random number generator used by evolution;
+ */
+void setSeed(unsigned s) {
+  universe->seed = s;
+  universe->rng = s ^ 0x9E3779B9 ? s ^ 0x9E3779B9 : 1;
 }
 
-void setPosition(int i, int j) {
-  pos_y = i;
-  pos_x = j;
+/**
+ * @brief function that returns the offset of a cell from the start of a
+ * region (i,j) along one axis, wrapping around the edge of the game if needed;
+ */
+static int64_t region_offset(gol_universe *u, int64_t val, int64_t start,
+                             int size) {
+  return u->isWrapping ? WCLAMP(val - start, size) : val - start;
 }
 
-void saveCell(int i, int j) {
+/**
+ * @brief function that collects pointers to all stored cells in a region of
+ * h x w cells starting at coords (i,j), wrapping around the edges of the game;
+ *
+ * The cheaper of probing each coordinate of the region and a single pass over
+ * the hash is chosen based on the region area and the number of cells.
+ */
+static int region_cells(gol_universe *u, int64_t i, int64_t j, int64_t h,
+                        int64_t w, Cell ***buffer) {
   Cell *c;
+  int   size = 0;
+
+  if (u->isWrapping) {
+    h = MIN(h, u->height);
+    w = MIN(w, u->width);
+  }
+
+  if (h <= 0 || w <= 0) {
+    *buffer = NULL;
+    return 0;
+  }
+
+  // the area is compared in parts, so it can't overflow
+  if (h < HASH_COUNT(u->hash) && w < HASH_COUNT(u->hash) &&
+      h * w < HASH_COUNT(u->hash)) {
+    MEM_CHECK(*buffer = malloc(h * w * sizeof(Cell *)));
+    for (int64_t k = 0; k < h; k++)
+      for (int64_t l = 0; l < w; l++) {
+        int64_t row = u->isWrapping ? WCLAMP(i + k, u->height) : i + k;
+        int64_t col = u->isWrapping ? WCLAMP(j + l, u->width) : j + l;
+        if ((c = get(u, row, col)))
+          (*buffer)[size++] = c;
+      }
+  } else {
+    MEM_CHECK(*buffer = malloc((HASH_COUNT(u->hash) + 1) * sizeof(Cell *)));
+    for (c = u->hash; c != NULL; c = c->hh.next) {
+      int64_t k = region_offset(u, c->cord.row, i, u->height);
+      int64_t l = region_offset(u, c->cord.col, j, u->width);
+      if (k >= 0 && k < h && l >= 0 && l < w)
+        (*buffer)[size++] = c;
+    }
+  }
+
+  return size;
+}
+
+/**
+ * @brief function that extracts all living cells in a region of h x w cells
+ * starting at coords (i,j) into a packed buffer, with coordinates relative to
+ * the start of the region. Returns the number of cells extracted;
+ *
+ * Memory for the buffer is allocated automatically and should be freed with
+ * free() after it's no longer needed.
+ */
+int logic_extract(int64_t i, int64_t j, int64_t h, int64_t w,
+                  coord_val **buffer) {
+  gol_universe *u = universe;
+  Cell        **cells;
+  coord_val    *paged;
+  int           n = region_cells(u, i, j, h, w, &cells), size = 0;
+  size_t        m = page_cells(u, i, j, h, w, &paged);
+
+  MEM_CHECK(*buffer = malloc((n + m + 1) * sizeof(coord_val)));
+  for (int k = 0; k < n; k++) {
+    if (!cells[k]->val)
+      continue;
+
+    (*buffer)[size].row = region_offset(u, cells[k]->cord.row, i, u->height);
+    (*buffer)[size].col = region_offset(u, cells[k]->cord.col, j, u->width);
+    (*buffer)[size++].val = cells[k]->val;
+  }
+
+  for (size_t k = 0; k < m; k++) {
+    (*buffer)[size].row = region_offset(u, paged[k].row, i, u->height);
+    (*buffer)[size].col = region_offset(u, paged[k].col, j, u->width);
+    (*buffer)[size++].val = paged[k].val;
+  }
+
+  free(paged);
+  free(cells);
+  return size;
+}
+
+/**
+ * @brief function that destroys all cells in a region of h x w cells starting
+ * at coords (i,j);
+ */
+void deleteRegion(int64_t i, int64_t j, int64_t h, int64_t w) {
+  Cell **cells;
+  int    size;
+
+  page_touch(universe, i, j, h, w);
+  size = region_cells(universe, i, j, h, w, &cells);
+
+  for (int k = 0; k < size; k++)
+    deleter(universe, cells[k]);
+
+  free(cells);
+}
+
+/**
+ * @brief function that toggles every cell in a region of h x w cells starting
+ * at coords (i,j), same as calling toggleAt() on each of them;
+ *
+ * Living cells are changed in place, and dead ones are added without looking
+ * them up in the hash.
+ */
+void toggleRegion(int64_t i, int64_t j, int64_t h, int64_t w) {
+  gol_universe  *u = universe;
+  Cell         **cells;
+  unsigned char *alive;
+  int            size;
+
+  page_touch(u, i, j, h, w);
+  size = region_cells(u, i, j, h, w, &cells);
+
+  if (u->isWrapping) {
+    h = MIN(h, u->height);
+    w = MIN(w, u->width);
+  }
+
+  if (h <= 0 || w <= 0)
+    return;
+
+  logic_reserve(h * w - size);
+  MEM_CHECK(alive = calloc((h * w + 7) / 8, sizeof(unsigned char)));
+  for (int k = 0; k < size; k++) {
+    Cell   *c = cells[k];
+    int64_t n = region_offset(u, c->cord.row, i, u->height) * w +
+                region_offset(u, c->cord.col, j, u->width);
+
+    alive[n / 8] |= 1 << (n % 8);
+    if (!(c->val = (c->val + 1) % u->toggle_mod))
+      deleter(u, c);
+  }
+
+  for (int64_t k = 0; k < h; k++)
+    for (int64_t l = 0; l < w; l++) {
+      int64_t n = k * w + l;
+      if (alive[n / 8] & (1 << (n % 8)))
+        continue;
+
+      Cell *c = cell_alloc(u);
+      c->cord.row = u->isWrapping ? WCLAMP(i + k, u->height) : i + k;
+      c->cord.col = u->isWrapping ? WCLAMP(j + l, u->width) : j + l;
+      c->val = 1;
+      hash_add(u, c, cord_hash(c->cord.row, c->cord.col));
+    }
+
+  free(alive);
+  free(cells);
+}
+
+/**
+ * @brief function that makes room for n more cells, so that they can be added
+ * without growing the pool or the hash table; buckets are added until they
+ * hold about HASH_BKT_CAPACITY_THRESH cells each, the length of a chain at
+ * which the hash table grows by itself;
+ */
+void logic_reserve(size_t n) {
+  gol_universe *u = universe;
+
+  if (n > u->pool_free_s)
+    pool_grow(u, n - u->pool_free_s);
+
+  if (u->hash == NULL)
+    return;
+
+  n = (n + HASH_COUNT(u->hash)) / HASH_BKT_CAPACITY_THRESH;
+  while (u->hash->hh.tbl->num_buckets < n && !u->hash->hh.tbl->noexpand &&
+         u->hash->hh.tbl->num_buckets < (1U << 31))
+    HASH_EXPAND_BUCKETS(hh, u->hash->hh.tbl, oomed);
+}
+
+/**
+ * @brief function that returns the key ordering cells by tile, and then
+ * row-major inside of the tile, relative to coords (i,j). Both offsets have to
+ * fit into 32 bits;
+ */
+static uint64_t tile_key(const coord_val *c, int64_t i, int64_t j) {
+  uint32_t row = (uint64_t)c->row - (uint64_t)i;
+  uint32_t col = (uint64_t)c->col - (uint64_t)j;
+  uint32_t mask = (1U << TILE_BITS) - 1;
+
+  return (uint64_t)(row >> TILE_BITS) << (32 + TILE_BITS) |
+         (uint64_t)(col >> TILE_BITS) << (2 * TILE_BITS) |
+         (row & mask) << TILE_BITS | (col & mask);
+}
+
+/**
+ * @brief structure that stores a cell with its place in the input, used to
+ * sort cells spread too far apart for tile_key();
+ */
+typedef struct placed_cell {
+  coord_val cell;
+  size_t    index;
+} placed_cell;
+
+/**
+ * @brief function that compares placed cells row-major, and then by their
+ * place in the input;
+ */
+static int placed_cmp(const void *a, const void *b) {
+  const placed_cell *x = a, *y = b;
+
+  if (x->cell.row != y->cell.row)
+    return x->cell.row < y->cell.row ? -1 : 1;
+  if (x->cell.col != y->cell.col)
+    return x->cell.col < y->cell.col ? -1 : 1;
+  return (x->index > y->index) - (x->index < y->index);
+}
+
+/**
+ * @brief function that returns a copy of packed cells sorted row-major, with
+ * equal cells in the order they were given;
+ */
+static coord_val *sort_rows(const coord_val *cells, size_t size) {
+  placed_cell *placed;
+  coord_val   *sorted;
+
+  MEM_CHECK(placed = malloc(size * sizeof(placed_cell)));
+  for (size_t k = 0; k < size; k++)
+    placed[k] = (placed_cell){cells[k], k};
+  qsort(placed, size, sizeof(placed_cell), placed_cmp);
 
-  if ((c = get(i, j))) {
-    if (save_cells_s == save_cells_sm) {
-      Cell **t;
-      save_cells_sm *= 2;
-      MEM_CHECK(t = realloc(save_cells, save_cells_sm));
-      save_cells = t;
+  MEM_CHECK(sorted = malloc(size * sizeof(coord_val)));
+  for (size_t k = 0; k < size; k++)
+    sorted[k] = placed[k].cell;
+
+  free(placed);
+  return sorted;
+}
+
+/**
+ * @brief function that returns a copy of packed cells sorted by tile;
+ *
+ * Stable counting sort is done on each 16 bit digit of the key, skipping the
+ * digits that are zero for every cell. Equal cells end up next to each other
+ * in the order they were given. Cells too far apart to be tiled are sorted
+ * row-major instead.
+ */
+static coord_val *sort_tiles(const coord_val *cells, size_t size) {
+  coord_val *src, *dst;
+  size_t    *count;
+  uint64_t   used = 0, far = 0;
+  int64_t    i = INT64_MAX, j = INT64_MAX;
+
+  for (size_t k = 0; k < size; k++) {
+    i = MIN(i, cells[k].row);
+    j = MIN(j, cells[k].col);
+  }
+
+  // tiles of cells spread further than 32 bits apart don't fit in the key
+  for (size_t k = 0; k < size; k++)
+    far |= ((uint64_t)cells[k].row - (uint64_t)i) |
+           ((uint64_t)cells[k].col - (uint64_t)j);
+  if (far >> 32)
+    return sort_rows(cells, size);
+  for (size_t k = 0; k < size; k++)
+    used |= tile_key(&cells[k], i, j);
+
+  MEM_CHECK(src = malloc(size * sizeof(coord_val)));
+  MEM_CHECK(dst = malloc(size * sizeof(coord_val)));
+  MEM_CHECK(count = malloc((1 << 16) * sizeof(size_t)));
+  memcpy(src, cells, size * sizeof(coord_val));
+
+  for (int shift = 0; shift < 64; shift += 16) {
+    if (!((used >> shift) & 0xFFFF))
+      continue;
+
+    memset(count, 0, (1 << 16) * sizeof(size_t));
+    for (size_t k = 0; k < size; k++)
+      count[(tile_key(&src[k], i, j) >> shift) & 0xFFFF]++;
+
+    for (size_t k = 0, sum = 0; k < (1 << 16); k++) {
+      size_t t = count[k];
+      count[k] = sum;
+      sum += t;
+    }
+
+    for (size_t k = 0; k < size; k++)
+      dst[count[(tile_key(&src[k], i, j) >> shift) & 0xFFFF]++] = src[k];
+
+    coord_val *t = src;
+    src = dst;
+    dst = t;
+  }
+
+  free(count);
+  free(dst);
+  return src;
+}
+
+/**
+ * @brief function that sets all packed cells at once, same as calling setAt()
+ * on each of them in order;
+ *
+ * Cells are sorted by tile first, so that the neighbouring cells end up next
+ * to each other in memory. Storage is reserved up front, and cells are added
+ * without looking them up when the hash is empty.
+ */
+void logic_insert_bulk(const coord_val *buf, size_t n) {
+  gol_universe *u = universe;
+  coord_val    *cells;
+  int           empty;
+
+  if (!n)
+    return;
+
+  for (size_t k = 0; u->paged && k < n; k++)
+    page_touch(u, buf[k].row, buf[k].col, 1, 1);
+  empty = u->hash == NULL;
+
+  cells = sort_tiles(buf, n);
+  logic_reserve(n);
+
+  for (size_t k = 0; k < n; k++) {
+    coord_val *p = &cells[k];
+    Cell      *c;
+
+    if (k + 1 < n && cells[k + 1].row == p->row && cells[k + 1].col == p->col)
+      continue;
+
+    if (!empty && (c = get(u, p->row, p->col)) != NULL) {
+      if (!(c->val = p->val))
+        deleter(u, c);
+      continue;
+    }
+
+    if (!p->val)
+      continue;
+
+    c = cell_alloc(u);
+    c->cord.row = p->row;
+    c->cord.col = p->col;
+    c->val = p->val;
+    hash_add(u, c, cord_hash(c->cord.row, c->cord.col));
+
+    if (HASH_COUNT(u->hash) == 1)
+      logic_reserve(n - k - 1);
+  }
+
+  free(cells);
+}
+
+/**
+ * @brief function that places packed cells with coordinates relative to coords
+ * (i,j), wrapping around the edges of the game;
+ *
+ * All cells in the bounding box of the placed cells are destroyed first, so
+ * the pattern replaces what was there without leaving any dead cells behind.
+ */
+void setRegion(int64_t i, int64_t j, const coord_val *cells, int size) {
+  gol_universe *u = universe;
+  coord_val    *placed;
+  int64_t min_y = INT64_MAX, min_x = INT64_MAX, max_y = INT64_MIN,
+          max_x = INT64_MIN;
+
+  if (!size)
+    return;
+
+  for (int k = 0; k < size; k++) {
+    min_y = MIN(min_y, cells[k].row);
+    min_x = MIN(min_x, cells[k].col);
+    max_y = MAX(max_y, cells[k].row);
+    max_x = MAX(max_x, cells[k].col);
+  }
+
+  deleteRegion(i + min_y, j + min_x, max_y - min_y + 1, max_x - min_x + 1);
+
+  MEM_CHECK(placed = malloc(size * sizeof(coord_val)));
+  for (int k = 0; k < size; k++) {
+    int64_t row = i + cells[k].row, col = j + cells[k].col;
+    placed[k].row = u->isWrapping ? WCLAMP(row, u->height) : row;
+    placed[k].col = u->isWrapping ? WCLAMP(col, u->width) : col;
+    placed[k].val = cells[k].val;
+  }
+
+  logic_insert_bulk(placed, size);
+  free(placed);
+}
+
+/**
+ * @brief function that removes the cells being paged out from the hash, without
+ * recording them as changes;
+ */
+void logic_evict(const coord_val *cells, size_t n) {
+  gol_universe *u = universe;
+  Cell         *c;
+
+  for (size_t k = 0; k < n; k++)
+    if ((c = get(u, cells[k].row, cells[k].col)) != NULL) {
+      HASH_DEL(u->hash, c);
+      cell_free(u, c);
     }
+}
+
+/**
+ * @brief function that adds the cells being paged in back to the hash, as if
+ * they were there during the last evolution;
+ */
+void logic_restore(const coord_val *cells, size_t n) {
+  gol_universe *u = universe;
+  Cell         *c;
 
-    save_cells[save_cells_s++] = c;
+  logic_reserve(n);
+  for (size_t k = 0; k < n; k++) {
+    if ((c = get(u, cells[k].row, cells[k].col)) == NULL) {
+      c = cell_alloc(u);
+      c->cord.row = cells[k].row;
+      c->cord.col = cells[k].col;
+      hash_add(u, c, cord_hash(c->cord.row, c->cord.col));
+    }
+    c->val = c->prev = cells[k].val;
   }
 }
+
+/**
+ * @brief function that collects all living cells of the game, including the
+ * paged ones, into a packed buffer. Returns the number of cells collected;
+ *
+ * Memory for the buffer is allocated automatically and should be freed with
+ * free() after it's no longer needed.
+ */
+size_t logic_collect(coord_val **buffer) {
+  gol_universe *u = universe;
+  size_t        size = 0;
+
+  MEM_CHECK(*buffer = malloc((HASH_COUNT(u->hash) + u->paged + 1) *
+                             sizeof(coord_val)));
+  for (Cell *c = u->hash; c != NULL; c = c->hh.next)
+    if (c->val)
+      (*buffer)[size++] = (coord_val){c->cord.row, c->cord.col, c->val};
+
+  return size + page_all(u, *buffer + size);
+}
@@ -0,0 +1,433 @@
+/**
+ * @file macrocell.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the reader and writer for the Macrocell format
+ *
+ * Macrocell (.mc) stores the pattern as a quadtree where each distinct node is
+ * written only once and referenced by its line number, so large but repetitive
+ * patterns take very little space. Nodes of level 3 are 8x8 leaves written as
+ * rows of '.' and '*' separated by '$', other nodes are written as their level
+ * followed by the line numbers of their four children, where 0 is an empty
+ * child. Multi-state patterns use level 1 nodes holding four cell states
+ * instead of leaves.
+ *
+ * Both reading and writing go through a table of canonical nodes, indexed by a
+ * hash so that equal subtrees are stored once. When writing, the tree is built
+ * bottom up from the cells and each new node is written as soon as it is
+ * created. When reading, the tree is built from the nodes in the file and only
+ * its non-empty parts are walked to produce the living cells.
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "format.h"
+#include "macrocell.h"
+#include "utils.h"
+
+/// Level of the 8x8 leaves of two-state patterns
+#define LEAF_LEVEL 3
+
+/// Maximum length of a line that is going to be parsed
+#define LINE_SIZE 1024
+
+/// Highest level of a node, the tree covers 2^MAX_LEVEL cells on each side
+#define MAX_LEVEL 62
+
+/**
+ * @brief Content of a node in the quadtree, used as the key of the hash
+ */
+typedef struct node_key_T {
+  uint64_t bits;     ///< 8x8 bitmap of a leaf, 0 for other nodes
+  uint32_t level;    ///< level of the node, the node covers 2^level cells
+  uint32_t child[4]; ///< nw, ne, sw, se children or states of a level 1 node
+} node_key_T;
+
+/**
+ * @brief A canonical node in the hash
+ */
+typedef struct node_T {
+  node_key_T     key; ///< content of the node
+  uint32_t       id;  ///< index of the node in the tree
+  UT_hash_handle hh;
+} node_T;
+
+/**
+ * @brief Table of canonical nodes, where node 0 is an empty subtree
+ */
+typedef struct tree_T {
+  node_T     *index;    ///< hash of all nodes by their content
+  node_key_T *nodes;    ///< content of each node by its id
+  uint32_t    size;     ///< id of the last node
+  uint32_t    capacity; ///< number of ids that fit in nodes
+} tree_T;
+
+/**
+ * @brief Return the id of the canonical node with key, adding it if needed.
+ * Created is set to 1 if the node is new
+ */
+static uint32_t tree_node(tree_T *self, node_key_T *key, int *created) {
+  node_T *n;
+
+  *created = 0;
+  if (!key->bits && !key->child[0] && !key->child[1] && !key->child[2] &&
+      !key->child[3])
+    return 0;
+
+  HASH_FIND(hh, self->index, key, sizeof(node_key_T), n);
+  if (n != NULL)
+    return n->id;
+
+  if (self->size + 1 >= self->capacity) {
+    node_key_T *t;
+    self->capacity = self->capacity ? self->capacity * 2 : 256;
+    MEM_CHECK(t = realloc(self->nodes, self->capacity * sizeof(node_key_T)));
+    self->nodes = t;
+  }
+
+  MEM_CHECK(n = malloc(sizeof(node_T)));
+  n->key = *key;
+  n->id = ++self->size;
+  self->nodes[n->id] = *key;
+  HASH_ADD(hh, self->index, key, sizeof(node_key_T), n);
+
+  *created = 1;
+  return n->id;
+}
+
+/**
+ * @brief Free the memory used by the tree
+ */
+static void tree_free(tree_T *self) {
+  node_T *n, *tmp;
+
+  HASH_ITER(hh, self->index, n, tmp) {
+    HASH_DEL(self->index, n);
+    free(n);
+  }
+  free(self->nodes);
+}
+
+/**
+ * @brief State of the writer
+ */
+typedef struct writer_T {
+  tree_T            tree;     ///< nodes written so far
+  FILE             *f;        ///< file that is being written
+  int               multi;    ///< level 1 nodes with states, not leaves
+  format_progress_f progress; ///< called as the cells are written, or NULL
+  size_t            done;     ///< number of cells in the nodes built so far
+} writer_T;
+
+/**
+ * @brief Count the cells of a built node as written, reporting the progress
+ * every FORMAT_PROGRESS_STEP cells
+ */
+static void written(writer_T *w, int size) {
+  size_t prev = w->done;
+
+  w->done += size;
+  if (w->progress &&
+      prev / FORMAT_PROGRESS_STEP != w->done / FORMAT_PROGRESS_STEP)
+    w->progress(w->done);
+}
+
+/**
+ * @brief Move the cells in the first half of the node by row, or by column
+ * if row is 0, to the start of the array. Return the number of such cells
+ */
+static int partition(coord_val *cells, int size, int64_t half, int row) {
+  int i = 0;
+
+  for (int j = 0; j < size; j++)
+    if (!((row ? cells[j].row : cells[j].col) & half)) {
+      coord_val t = cells[i];
+      cells[i++] = cells[j];
+      cells[j] = t;
+    }
+
+  return i;
+}
+
+/**
+ * @brief Write the leaf as rows of '.' and '*' separated by '$', without the
+ * trailing dead cells and empty rows
+ */
+static void write_leaf(FILE *f, uint64_t bits) {
+  for (int i = 0; i < 8 && (bits >> (i * 8)); i++) {
+    int row = (bits >> (i * 8)) & 0xFF;
+    for (int j = 0; j < 8 && (row >> j); j++)
+      fputc((row >> j) & 1 ? '*' : '.', f);
+    fputc('$', f);
+  }
+  fputc('\n', f);
+}
+
+/**
+ * @brief Build the node of a given level from the cells inside of it, writing
+ * every new node. Return the id of the node
+ *
+ * Node of level n covers an aligned square of 2^n cells, so the position of a
+ * cell inside of it is given by the lowest n bits of its coordinates.
+ */
+static uint32_t build(writer_T *w, coord_val *cells, int size, int level) {
+  node_key_T key;
+  int        created;
+
+  if (!size)
+    return 0;
+
+  memset(&key, 0, sizeof(key));
+  key.level = level;
+
+  if (!w->multi && level == LEAF_LEVEL) {
+    for (int i = 0; i < size; i++)
+      key.bits |= 1ULL << ((cells[i].row & 7) * 8 + (cells[i].col & 7));
+    written(w, size);
+
+    uint32_t id = tree_node(&w->tree, &key, &created);
+    if (created)
+      write_leaf(w->f, key.bits);
+    return id;
+  }
+
+  if (level == 1) {
+    for (int i = 0; i < size; i++)
+      key.child[(cells[i].row & 1) * 2 + (cells[i].col & 1)] = cells[i].val;
+    written(w, size);
+  } else {
+    int64_t half = 1LL << (level - 1);
+    int     top = partition(cells, size, half, 1);
+    int     nw = partition(cells, top, half, 0);
+    int     sw = partition(cells + top, size - top, half, 0);
+
+    key.child[0] = build(w, cells, nw, level - 1);
+    key.child[1] = build(w, cells + nw, top - nw, level - 1);
+    key.child[2] = build(w, cells + top, sw, level - 1);
+    key.child[3] = build(w, cells + top + sw, size - top - sw, level - 1);
+  }
+
+  uint32_t id = tree_node(&w->tree, &key, &created);
+  if (created)
+    fprintf(w->f, "%u %u %u %u %u\n", key.level, key.child[0], key.child[1],
+            key.child[2], key.child[3]);
+  return id;
+}
+
+/**
+ * @brief Write the cells in the Macrocell format with a given rule
+ *
+ * Cells are expected to be moved so that their bounding box starts at (0, 0),
+ * and are reordered in place.
+ */
+void macrocell_write(FILE *f, coord_val *cells, int size, char *rule,
+                     format_progress_f progress) {
+  writer_T w = {{0}, f, 0, progress, 0};
+  int64_t  extent = 1;
+  int      level;
+
+  for (int i = 0; i < size; i++) {
+    extent = MAX(extent, MAX(cells[i].row, cells[i].col) + 1);
+    w.multi |= cells[i].val > 1;
+  }
+
+  level = w.multi ? 1 : LEAF_LEVEL;
+  while (level < MAX_LEVEL && (1LL << level) < extent)
+    level++;
+
+  fprintf(f, "[M2] (gol)\n#R %s\n", rule);
+  build(&w, cells, size, level);
+  tree_free(&w.tree);
+}
+
+/**
+ * @brief State of the reader
+ */
+typedef struct reader_T {
+  tree_T   tree;   ///< canonical nodes read so far
+  int64_t *min_y;  ///< top row of the living cells of each node, -1 if unknown
+  int64_t *min_x;  ///< left column of the living cells of each node
+  int64_t  base_y; ///< top row of the living cells of the pattern
+  int64_t  base_x; ///< left column of the living cells of the pattern
+} reader_T;
+
+/**
+ * @brief Calculate the top row and left column of the living cells of a node
+ * relative to its corner, remembering the result for each canonical node
+ */
+static void bounds(reader_T *r, uint32_t id) {
+  node_key_T *n = &r->tree.nodes[id];
+  int64_t     y = INT64_MAX, x = INT64_MAX;
+
+  if (r->min_y[id] >= 0)
+    return;
+
+  if (n->level == LEAF_LEVEL && n->bits) {
+    for (int i = 0; i < 64; i++)
+      if (n->bits >> i & 1) {
+        y = MIN(y, i / 8);
+        x = MIN(x, i % 8);
+      }
+  } else if (n->level == 1) {
+    for (int i = 0; i < 4; i++)
+      if (n->child[i]) {
+        y = MIN(y, i / 2);
+        x = MIN(x, i % 2);
+      }
+  } else {
+    int64_t half = 1LL << (n->level - 1);
+    for (int i = 0; i < 4; i++) {
+      uint32_t c = n->child[i];
+      if (!c)
+        continue;
+
+      bounds(r, c);
+      y = MIN(y, r->min_y[c] + (i / 2) * half);
+      x = MIN(x, r->min_x[c] + (i % 2) * half);
+    }
+  }
+
+  r->min_y[id] = y;
+  r->min_x[id] = x;
+}
+
+/**
+ * @brief Add the living cells of a node with the top left corner at (y, x)
+ */
+static void expand(reader_T *r, uint32_t id, int64_t y, int64_t x,
+                   cells_T *cells) {
+  node_key_T *n = &r->tree.nodes[id];
+
+  if (n->level == LEAF_LEVEL && n->bits) {
+    for (int i = 0; i < 64; i++)
+      if (n->bits >> i & 1) {
+        cells_push(cells, y + i / 8 - r->base_y, x + i % 8 - r->base_x, 1);
+      }
+    return;
+  }
+
+  if (n->level == 1) {
+    for (int i = 0; i < 4; i++)
+      if (n->child[i]) {
+        cells_push(cells, y + i / 2 - r->base_y, x + i % 2 - r->base_x,
+                   MIN(n->child[i], UCHAR_MAX));
+      }
+    return;
+  }
+
+  int64_t half = 1LL << (n->level - 1);
+  for (int i = 0; i < 4; i++)
+    if (n->child[i])
+      expand(r, n->child[i], y + (i / 2) * half, x + (i % 2) * half, cells);
+}
+
+/**
+ * @brief Parse the 8x8 leaf written as rows of '.' and '*' separated by '$'
+ */
+static uint64_t parse_leaf(char *line) {
+  uint64_t bits = 0;
+  int      row = 0, col = 0;
+
+  for (char *p = line; *p && row < 8; p++) {
+    switch (*p) {
+    case '$':
+      row++;
+      col = 0;
+      break;
+    case '*':
+      if (col < 8)
+        bits |= 1ULL << (row * 8 + col);
+      col++;
+      break;
+    case '.':
+      col++;
+      break;
+    }
+  }
+
+  return bits;
+}
+
+/**
+ * @brief Read the pattern in the Macrocell format
+ *
+ * Line numbers of the nodes in the file are mapped to the canonical nodes, so
+ * references to the children are resolved while reading. Nodes that reference
+ * lines that were not read yet, or have an invalid level, are treated as empty.
+ */
+void macrocell_read(FILE *f, cells_T *cells) {
+  reader_T  r = {{0}};
+  char      line[LINE_SIZE];
+  uint32_t *ids = NULL, ids_s = 0, ids_c = 0, root = 0;
+
+  while (fgets(line, LINE_SIZE, f) != NULL) {
+    node_key_T key;
+    int        created;
+    unsigned   level, c[4];
+
+    if (line[0] == '[' || line[0] == '\n' || line[0] == '\r')
+      continue;
+
+    if (line[0] == '#') {
+      if (line[1] == 'R') {
+        char *rule = line + 2, *end;
+        while (isspace(*rule))
+          rule++;
+        for (end = rule; *end && !isspace(*end); end++)
+          ;
+        *end = '\0';
+        cells->rule = format_rule(rule);
+      }
+      continue;
+    }
+
+    memset(&key, 0, sizeof(key));
+    if (line[0] == '$' || line[0] == '.' || line[0] == '*') {
+      key.level = LEAF_LEVEL;
+      key.bits = parse_leaf(line);
+    } else if (sscanf(line, "%u %u %u %u %u", &level, &c[0], &c[1], &c[2],
+                      &c[3]) == 5 &&
+               level >= 1 && level <= MAX_LEVEL) {
+      key.level = level;
+      for (int i = 0; i < 4; i++) {
+        if (level == 1)
+          key.child[i] = c[i];
+        else if (c[i] && c[i] <= ids_s && ids[c[i]] &&
+                 r.tree.nodes[ids[c[i]]].level == level - 1)
+          key.child[i] = ids[c[i]];
+      }
+    } else {
+      continue;
+    }
+
+    if (ids_s + 1 >= ids_c) {
+      uint32_t *t;
+      ids_c = ids_c ? ids_c * 2 : 256;
+      MEM_CHECK(t = realloc(ids, ids_c * sizeof(uint32_t)));
+      ids = t;
+      ids[0] = 0;
+    }
+    ids[++ids_s] = root = tree_node(&r.tree, &key, &created);
+  }
+
+  if (root) {
+    MEM_CHECK(r.min_y = malloc((r.tree.size + 1) * sizeof(int64_t)));
+    MEM_CHECK(r.min_x = malloc((r.tree.size + 1) * sizeof(int64_t)));
+    memset(r.min_y, -1, (r.tree.size + 1) * sizeof(int64_t));
+
+    bounds(&r, root);
+    r.base_y = r.min_y[root];
+    r.base_x = r.min_x[root];
+    expand(&r, root, 0, 0, cells);
+
+    free(r.min_y);
+    free(r.min_x);
+  }
+
+  free(ids);
+  tree_free(&r.tree);
+}
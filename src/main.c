@@ -3,12 +3,21 @@
 #include <locale.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "checkpoint.h"
 #include "display.h"
+#include "export.h"
 #include "file.h"
+#include "format.h"
 #include "game.h"
+#include "history.h"
 #include "logic.h"
+#include "record.h"
+#include "search.h"
+#include "shard.h"
+#include "snapshot.h"
 #include "utils.h"
 #include "window.h"
 
@@ -19,6 +28,10 @@ void settings(char *pass, int index) {
   struct imenu_T imenu_items[] = {
       {   "Number of rows", 9, isdigit, NULL},
       {"Number of columns", 9, isdigit, NULL},
+      {"Checkpoint every n generations", 9, isdigit, NULL},
+      {"Checkpoint every n seconds", 9, isdigit, NULL},
+      {"History memory in MiB", 9, isdigit, NULL},
+      {"Cell memory in MiB", 9, isdigit, NULL},
   };
   int imenu_items_s = sizeof(imenu_items) / sizeof(struct imenu_T);
 
@@ -27,7 +40,18 @@ void settings(char *pass, int index) {
     int row = atoi(imenu_items[0].buffer);
     int column = atoi(imenu_items[1].buffer);
 
-    game(row, column, index);
+    // empty fields keep the current checkpoint, history and paging settings
+    if (*imenu_items[2].buffer)
+      checkpoint_gens = atoi(imenu_items[2].buffer);
+    if (*imenu_items[3].buffer)
+      checkpoint_secs = atoi(imenu_items[3].buffer);
+    if (*imenu_items[4].buffer)
+      history_budget = atoi(imenu_items[4].buffer);
+    if (*imenu_items[5].buffer)
+      page_budget = atoi(imenu_items[5].buffer);
+
+    setSeed(time(NULL));
+    game(row, column, index, 0);
     break;
   }
 
@@ -40,7 +64,7 @@ void settings(char *pass, int index) {
 void mode_select(char *pass, int index) {
   struct menu_T *mode_items;
 
-  MEM_CHECK(mode_items = malloc(evolution_size * sizeof(struct menu_T)));
+  MEM_CHECK(mode_items = calloc(evolution_size, sizeof(struct menu_T)));
   for (int i = 0; i < evolution_size; i++) {
     mode_items[i].name = evolution_names[i];
     mode_items[i].callback = settings;
@@ -52,6 +76,14 @@ void mode_select(char *pass, int index) {
 
 void (*file_save_method)(char *, int);
 
+/// Menu items for a new pattern, named after the extension of its format
+char *new_pattern_items[] = {"NEW", "NEW .rle", "NEW .cells", "NEW .lif",
+                             "NEW .mc"};
+
+/// Menu items for a new game, named after the extension of its format
+char *new_game_items[] = {"NEW", "NEW ." SNAPSHOT_EXT, "NEW .rle", "NEW .cells",
+                          "NEW .lif", "NEW .mc"};
+
 void new_file(char *pass, int index) {
   struct imenu_T new_file_items[] = {
       {"Pick a name", 10, isalnum, NULL},
@@ -60,7 +92,11 @@ void new_file(char *pass, int index) {
 
   window_set_title(menu_w, "New File");
   while (display_imenu(menu_w, new_file_items, new_file_items_s)) {
-    file_save_method(new_file_items[0].buffer, index);
+    char  name[32];
+    char *ext = strchr(pass, '.');
+    sprintf(name, "%s%s", new_file_items[0].buffer, ext ? ext : "");
+
+    file_save_method(name, index);
     break;
   }
 
@@ -70,31 +106,51 @@ void new_file(char *pass, int index) {
   }
 }
 
-struct menu_T *file_menu_list(char *ext, void (*callback)(char *, int),
+/// Maximum number of extra extensions listed by file_menu_list()
+#define EXTRA_MAX 2
+
+struct menu_T *file_menu_list(char *ext, char **extra,
+                              void (*callback)(char *, int), char **new_items,
                               int offset, int *size) {
   struct menu_T *file_items;
-  char         **buffer;
-  int            n;
+  library_T    **buffer[FORMAT_NONE + 1 + EXTRA_MAX];
+  int            n[FORMAT_NONE + 1 + EXTRA_MAX] = {0}, total = offset;
+  int            lists = FORMAT_NONE + 1;
 
   load_files();
-  n = file_select_extension(ext, &buffer);
+  total += n[0] = file_select_extension(ext, &buffer[0]);
 
-  MEM_CHECK(file_items = malloc((n + offset) * sizeof(struct menu_T)));
-  for (int i = 0; i < n; i++) {
-    file_items[i + offset].name = buffer[i];
-    file_items[i + offset].callback = callback;
+  // other formats are listed with their extension
+  for (int i = 0; i < FORMAT_NONE; i++)
+    total += n[i + 1] = file_select_extension(format_ext[i], &buffer[i + 1]);
+
+  for (int i = 0; extra && i < EXTRA_MAX && extra[i]; i++, lists++)
+    total += n[lists] = file_select_extension(extra[i], &buffer[lists]);
+
+  MEM_CHECK(file_items = calloc(total, sizeof(struct menu_T)));
+  for (int i = 0; i < offset; i++) {
+    file_items[i].name = new_items[i];
+    file_items[i].callback = new_file;
   }
-  free(buffer);
 
-  *size = n + offset;
+  for (int i = 0, k = offset; i < lists; i++) {
+    for (int j = 0; j < n[i]; j++, k++) {
+      file_items[k].name = i ? buffer[i][j]->name : buffer[i][j]->stem;
+      file_items[k].callback = callback;
+      file_items[k].preview = library_preview;
+      file_items[k].data = buffer[i][j];
+    }
+    free(buffer[i]);
+  }
+
+  *size = total;
   return file_items;
 }
 
 void save_pattern(void) {
-  int            n;
-  struct menu_T *file_items = file_menu_list("part", file_save_pattern, 1, &n);
-  file_items[0].name = "NEW";
-  file_items[0].callback = new_file;
+  int            n, new_n = sizeof(new_pattern_items) / sizeof(char *);
+  struct menu_T *file_items = file_menu_list(
+      "part", NULL, file_save_pattern, new_pattern_items, new_n, &n);
 
   file_save_method = file_save_pattern;
   display_menu(menu_w, "Save Pattern", file_items, n, 0);
@@ -103,25 +159,38 @@ void save_pattern(void) {
 
 void load_pattern(void) {
   int            n;
-  struct menu_T *file_items = file_menu_list("part", file_load_pattern, 0, &n);
+  struct menu_T *file_items =
+      file_menu_list("part", NULL, file_load_pattern, NULL, 0, &n);
 
   display_menu(menu_w, "Load Pattern", file_items, n, 0);
   free(file_items);
 }
 
+/// Menu item for resuming the game from the last checkpoint
+char *resume_items[] = {"RESUME"};
+
+/// Extra extensions of the files that can be loaded as a game
+char *load_extra[] = {SNAPSHOT_EXT, RECORD_EXT, NULL};
+
+/// Extra extensions of the files that a game can be saved to
+char *save_extra[] = {SNAPSHOT_EXT, NULL};
+
 void load(char *pass, int index) {
-  int            n;
-  struct menu_T *file_items = file_menu_list("all", file_load, 0, &n);
+  int            n, resume = checkpoint_exists();
+  struct menu_T *file_items = file_menu_list("all", load_extra, file_load,
+                                             resume_items, resume, &n);
+
+  if (resume)
+    file_items[0].callback = checkpoint_resume;
 
   display_menu(menu_w, "Load Game", file_items, n, 0);
   free(file_items);
 }
 
 void save(void) {
-  int            n;
-  struct menu_T *file_items = file_menu_list("all", file_save, 1, &n);
-  file_items[0].name = "NEW";
-  file_items[0].callback = new_file;
+  int            n, new_n = sizeof(new_game_items) / sizeof(char *);
+  struct menu_T *file_items = file_menu_list("all", save_extra, file_save,
+                                             new_game_items, new_n, &n);
 
   file_save_method = file_save;
   display_menu(menu_w, "Save Pattern", file_items, n, 0);
@@ -144,9 +213,19 @@ struct menu_T menu_items[] = {
 
 int menu_items_s = sizeof(menu_items) / sizeof(struct menu_T);
 
-int main(void) {
+int main(int argc, char *argv[]) {
+  if (argc > 1 && !strcmp(argv[1], "search"))
+    return search_main(argc, argv);
+
+  if (argc > 1 && !strcmp(argv[1], "shard"))
+    return shard_main(argc, argv);
+
+  if (argc > 1)
+    return export_main(argc, argv);
+
   setlocale(LC_ALL, "");
   atexit(display_stop);
+  atexit(file_save_wait);
 
   file_setup();
   display_start();
@@ -0,0 +1,1098 @@
+/**
+ * @file page.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the paging of cold tiles of the library
+ *
+ * A universe can be given a budget for the memory of its living cells. Every
+ * PAGE_INTERVAL generations its cells are split into tiles of PAGE_SIDE x
+ * PAGE_SIDE, and while the cells take more than the budget, the tiles that
+ * haven't changed for PAGE_COLD generations are paged out, the least recently
+ * changed first. Paged tiles are encoded as runs of delta.c, a few bytes per
+ * cell, and kept in an arena in memory or in a memory mapped backing file.
+ *
+ * Only still lifes with no other living cells within PAGE_HALO cells of them
+ * are paged out, so the rest of the universe evolves the same without them.
+ * Each generation the tiles that living cells came that close to are paged
+ * back in, before they could interact, and so are the tiles that are changed
+ * by hand. Tiles remember which cells they have on their edges, so a tile can
+ * be paged out next to living cells that are out of its reach. Still lifes
+ * cut by the edges of tiles are paged out and back in as a group of the tiles
+ * they span, up to PAGE_GROUP of them. Functions reading a region or the whole
+ * universe see the paged cells as well.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "delta.h"
+#include "page.h"
+#include "utils.h"
+
+/// Tiles are 2^PAGE_BITS x 2^PAGE_BITS cells
+#define PAGE_BITS 6
+
+/// Number of cells on the side of a tile
+#define PAGE_SIDE (1 << PAGE_BITS)
+
+/// Least distance between a paged tile and the living cells of the universe
+#define PAGE_HALO 2
+
+/// Generations between scans for tiles to page out
+#define PAGE_INTERVAL 64
+
+/// Generations a tile has to stay the same before it can be paged out
+#define PAGE_COLD 256
+
+/// Largest number of tiles paged out as one group
+#define PAGE_GROUP 64
+
+/// Least number of bytes the arena grows by
+#define PAGE_ARENA (1 << 20)
+
+/// Memory taken by a living cell that is not paged out
+#define PAGE_CELL_BYTES (sizeof(Cell) + sizeof(UT_hash_bucket))
+
+/**
+ * @brief Position of a tile, its first row and column divided by PAGE_SIDE
+ */
+typedef struct tile_key {
+  int64_t row;
+  int64_t col;
+} tile_key;
+
+/**
+ * @brief Cells on the edges of a tile, as bitmasks of the columns of the cells
+ * in the first and the last PAGE_HALO rows, and of the rows of the cells in the
+ * first and the last PAGE_HALO columns
+ */
+enum edge { EDGE_TOP, EDGE_BOTTOM, EDGE_LEFT, EDGE_RIGHT, EDGE_COUNT };
+
+/**
+ * @brief Tile that is paged out
+ */
+typedef struct paged_T {
+  tile_key       key;
+  uint64_t       edges[EDGE_COUNT]; ///< cells on the edges
+  size_t         offset;  ///< offset of the encoded cells in the arena
+  size_t         bytes;   ///< size of the encoded cells
+  size_t         count;   ///< number of cells
+  int64_t        min_row; ///< bounding box of the cells
+  int64_t        min_col;
+  int64_t        max_row;
+  int64_t        max_col;
+  int            queued; ///< already queued to be paged in
+  UT_hash_handle hh;
+} paged_T;
+
+/**
+ * @brief Tile with living cells that is not paged out
+ */
+typedef struct tile_T {
+  tile_key       key;
+  uint64_t       edges[EDGE_COUNT]; ///< cells on the edges at the last scan
+  uint64_t       sum;     ///< checksum of the cells at the last scan
+  size_t         count;   ///< number of cells at the last scan
+  size_t         first;   ///< index of its first cell in the last scan
+  uint64_t       changed; ///< generation it last changed or was paged in
+  uint64_t       seen;    ///< last scan that found cells in it
+  struct tile_T *group;   ///< tile its group was merged into, during a scan
+  struct tile_T *next;    ///< next tile of its group, during a scan
+  size_t         tiles;   ///< number of tiles of its group, during a scan
+  UT_hash_handle hh;
+} tile_T;
+
+/**
+ * @brief Group of tiles that can be paged out
+ */
+typedef struct group_T {
+  tile_T  *first;   ///< first tile of the group
+  uint64_t changed; ///< last generation any tile of the group changed in
+} group_T;
+
+/**
+ * @brief Paged tiles queued to be paged in
+ */
+typedef struct queue_T {
+  paged_T **tiles;
+  size_t    size;
+  size_t    capacity;
+} queue_T;
+
+/**
+ * @brief State of the paging of a universe
+ */
+typedef struct page_T {
+  size_t     budget;   ///< bytes the living cells may take
+  int        fd;       ///< backing file, -1 if the arena is in memory
+  char      *name;     ///< name of the backing file
+  uint8_t   *data;     ///< arena of the encoded tiles
+  size_t     size;     ///< bytes of the arena in use
+  size_t     capacity; ///< bytes of the arena allocated
+  size_t     garbage;  ///< bytes of the tiles paged back in
+  paged_T   *paged;    ///< tiles paged out
+  tile_T    *tiles;    ///< tiles not paged out
+  uint64_t   scans;    ///< number of scans done
+  delta_T    delta;    ///< buffer for encoding a tile
+  coord_val *cells;    ///< buffer for decoding a tile
+  size_t     cells_s;  ///< number of cells in cells
+  size_t     cells_c;  ///< capacity of cells
+} page_T;
+
+/// Paging that decode_push() appends the cells of a tile to
+static _Thread_local page_T *decoding;
+
+/**
+ * @brief Return the tile of a coordinate, rounding towards negative infinity
+ */
+static int64_t tile_of(int64_t val) {
+  return val >= 0 ? val >> PAGE_BITS : ~(~val >> PAGE_BITS);
+}
+
+/**
+ * @brief Return the key of the tile the cell is in
+ */
+static tile_key key_of(int64_t row, int64_t col) {
+  return (tile_key){tile_of(row), tile_of(col)};
+}
+
+/**
+ * @brief Wrap the coordinate around the edge of size, if it is limited
+ */
+static int64_t wrap(int64_t val, int size) {
+  return size ? (val % size + size) % size : val;
+}
+
+/**
+ * @brief Check if the tile lies whole inside of the universe
+ *
+ * Tiles cut by the edge of a limited universe are never paged out, and
+ * neither are the tiles of one too small to tell their sides apart.
+ */
+static int is_full(const gol_universe *u, tile_key key) {
+  if (!u->isWrapping)
+    return 1;
+
+  return u->height >= PAGE_SIDE + 2 * PAGE_HALO &&
+         u->width >= PAGE_SIDE + 2 * PAGE_HALO &&
+         (key.row + 1) * PAGE_SIDE <= u->height &&
+         (key.col + 1) * PAGE_SIDE <= u->width;
+}
+
+/**
+ * @brief Return the offset of the coordinate from the start of a tile, from
+ * -PAGE_HALO up, wrapping around the edge of size if it is limited
+ */
+static int64_t tile_offset(int64_t val, int64_t start, int size) {
+  return size ? wrap(val - start + PAGE_HALO, size) - PAGE_HALO : val - start;
+}
+
+/**
+ * @brief Add the cell to the edges of its tile
+ */
+static void edge_add(uint64_t *edges, tile_key key, int64_t row, int64_t col) {
+  int r = row - key.row * PAGE_SIDE, c = col - key.col * PAGE_SIDE;
+
+  if (r < PAGE_HALO)
+    edges[EDGE_TOP] |= 1ULL << c;
+  if (r >= PAGE_SIDE - PAGE_HALO)
+    edges[EDGE_BOTTOM] |= 1ULL << c;
+  if (c < PAGE_HALO)
+    edges[EDGE_LEFT] |= 1ULL << r;
+  if (c >= PAGE_SIDE - PAGE_HALO)
+    edges[EDGE_RIGHT] |= 1ULL << r;
+}
+
+/**
+ * @brief Check if the edge has cells within PAGE_HALO of the position along it
+ */
+static int edge_near(uint64_t edge, int64_t pos) {
+  int64_t lo = MAX(pos - PAGE_HALO, 0);
+  int64_t hi = MIN(pos + PAGE_HALO, PAGE_SIDE - 1);
+
+  return lo <= hi && (edge >> lo & ((2ULL << (hi - lo)) - 1));
+}
+
+/**
+ * @brief Check if the cell outside of the tile might be within PAGE_HALO cells
+ * of the cells of the tile with the edges
+ *
+ * Cells of the tile that close to an outside cell have to be on the edge it is
+ * next to, so that edge alone is checked.
+ */
+static int edge_hit(const gol_universe *u, const uint64_t *edges, tile_key key,
+                    int64_t row, int64_t col) {
+  int64_t r = tile_offset(row, key.row * PAGE_SIDE, u->height);
+  int64_t c = tile_offset(col, key.col * PAGE_SIDE, u->width);
+
+  if (r < 0)
+    return edge_near(edges[EDGE_TOP], c);
+  if (r >= PAGE_SIDE)
+    return edge_near(edges[EDGE_BOTTOM], c);
+  if (c < 0)
+    return edge_near(edges[EDGE_LEFT], r);
+  if (c >= PAGE_SIDE)
+    return edge_near(edges[EDGE_RIGHT], r);
+  return 1;
+}
+
+/**
+ * @brief Check if the cell is within PAGE_HALO cells of another tile
+ */
+static int near_edge(const gol_universe *u, int64_t row, int64_t col) {
+  int64_t r = row & (PAGE_SIDE - 1), c = col & (PAGE_SIDE - 1);
+
+  if (r < PAGE_HALO || r >= PAGE_SIDE - PAGE_HALO || c < PAGE_HALO ||
+      c >= PAGE_SIDE - PAGE_HALO)
+    return 1;
+
+  return u->isWrapping &&
+         (row < PAGE_HALO || row >= u->height - PAGE_HALO ||
+          col < PAGE_HALO || col >= u->width - PAGE_HALO);
+}
+
+/**
+ * @brief Return the key of the tile at the k-th of the 8 points PAGE_HALO
+ * cells away from the cell
+ *
+ * Every tile within PAGE_HALO cells of the cell, other than its own, has at
+ * least one of these points in it.
+ */
+static tile_key probe(const gol_universe *u, int64_t row, int64_t col, int k) {
+  static const int offsets[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                    {0, 1},   {1, -1}, {1, 0},  {1, 1}};
+
+  row = wrap(row + offsets[k][0] * PAGE_HALO, u->height);
+  col = wrap(col + offsets[k][1] * PAGE_HALO, u->width);
+  return key_of(row, col);
+}
+
+/**
+ * @brief Return the paged tile with the key, NULL if it's not paged out
+ */
+static paged_T *paged_find(page_T *p, tile_key key) {
+  paged_T *t;
+
+  HASH_FIND(hh, p->paged, &key, sizeof(tile_key), t);
+  return t;
+}
+
+/**
+ * @brief Return the resident tile with the key, NULL if there is none
+ */
+static tile_T *tile_find(page_T *p, tile_key key) {
+  tile_T *t;
+
+  HASH_FIND(hh, p->tiles, &key, sizeof(tile_key), t);
+  return t;
+}
+
+/**
+ * @brief Return the resident tile with the key, adding it as changed in
+ * generation if there is none
+ */
+static tile_T *tile_get(page_T *p, tile_key key, uint64_t generation) {
+  tile_T *t = tile_find(p, key);
+
+  if (t == NULL) {
+    MEM_CHECK(t = calloc(1, sizeof(tile_T)));
+    t->key = key;
+    t->changed = generation;
+    HASH_ADD(hh, p->tiles, key, sizeof(tile_key), t);
+  }
+  return t;
+}
+
+/**
+ * @brief Queue the paged tile to be paged in, unless it already is
+ */
+static void queue_push(queue_T *q, paged_T *t) {
+  if (t->queued)
+    return;
+
+  if (q->size == q->capacity) {
+    paged_T **tiles;
+
+    q->capacity = MAX(q->capacity * 2, 16);
+    MEM_CHECK(tiles = realloc(q->tiles, q->capacity * sizeof(paged_T *)));
+    q->tiles = tiles;
+  }
+  t->queued = 1;
+  q->tiles[q->size++] = t;
+}
+
+/**
+ * @brief Append a cell of the tile being decoded to the buffer of decoding
+ */
+static void decode_push(int64_t row, int64_t col, int val) {
+  page_T *p = decoding;
+
+  if (p->cells_s == p->cells_c) {
+    coord_val *t;
+
+    p->cells_c = MAX(p->cells_c * 2, PAGE_SIDE * PAGE_SIDE);
+    MEM_CHECK(t = realloc(p->cells, p->cells_c * sizeof(coord_val)));
+    p->cells = t;
+  }
+  p->cells[p->cells_s++] = (coord_val){row, col, val};
+}
+
+/**
+ * @brief Decode the cells of the paged tile into the buffer of the paging,
+ * return the number of them
+ */
+static size_t decode(page_T *p, const paged_T *t) {
+  p->cells_s = 0;
+  decoding = p;
+  delta_decode(p->data + t->offset, t->bytes, decode_push);
+  decoding = NULL;
+  return p->cells_s;
+}
+
+/**
+ * @brief Make room for n more bytes at the end of the arena
+ */
+static void arena_reserve(page_T *p, size_t n) {
+  size_t   capacity;
+  uint8_t *data;
+
+  if (p->size + n <= p->capacity)
+    return;
+
+  capacity = MAX(MAX(p->capacity * 2, p->size + n), PAGE_ARENA);
+
+#ifndef _WIN32
+  if (p->fd >= 0) {
+    if (ftruncate(p->fd, capacity) != 0)
+      err("Can't grow the page file %s", p->name);
+    if (p->data != NULL)
+      munmap(p->data, p->capacity);
+
+    data = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, p->fd, 0);
+    if (data == MAP_FAILED)
+      err("Can't map the page file %s", p->name);
+
+    p->data = data;
+    p->capacity = capacity;
+    return;
+  }
+#endif
+
+  MEM_CHECK(data = realloc(p->data, capacity));
+  p->data = data;
+  p->capacity = capacity;
+}
+
+/**
+ * @brief Compare paged tiles by their offset in the arena
+ */
+static int offset_cmp(const paged_T *a, const paged_T *b) {
+  return (a->offset > b->offset) - (a->offset < b->offset);
+}
+
+/**
+ * @brief Move the paged tiles to the start of the arena, once the tiles paged
+ * back in take more than half of it
+ *
+ * Tiles are moved in the order of their offsets, so each of them only moves
+ * towards the start, and no second copy of the arena is needed.
+ */
+static void arena_compact(page_T *p) {
+  size_t size = 0;
+
+  if (p->garbage < PAGE_ARENA || p->garbage * 2 < p->size)
+    return;
+
+  HASH_SRT(hh, p->paged, offset_cmp);
+  for (paged_T *t = p->paged; t != NULL; t = t->hh.next) {
+    memmove(p->data + size, p->data + t->offset, t->bytes);
+    t->offset = size;
+    size += t->bytes;
+  }
+
+  p->size = size;
+  p->garbage = 0;
+}
+
+/**
+ * @brief Page out the tile with its cells sorted row-major
+ */
+static void page_out(gol_universe *u, page_T *p, tile_T *tile,
+                     const coord_val *cells, size_t n) {
+  paged_T *t;
+
+  MEM_CHECK(t = calloc(1, sizeof(paged_T)));
+  t->key = tile->key;
+  memcpy(t->edges, tile->edges, sizeof(t->edges));
+  t->count = n;
+  t->min_row = cells[0].row;
+  t->max_row = cells[n - 1].row;
+  t->min_col = t->max_col = cells[0].col;
+
+  p->delta.size = 0;
+  delta_begin(&p->delta);
+  for (size_t k = 0; k < n; k++) {
+    t->min_col = MIN(t->min_col, cells[k].col);
+    t->max_col = MAX(t->max_col, cells[k].col);
+    delta_push(&p->delta, &cells[k]);
+  }
+
+  arena_reserve(p, p->delta.size);
+  memcpy(p->data + p->size, p->delta.data, p->delta.size);
+  t->offset = p->size;
+  t->bytes = p->delta.size;
+  p->size += t->bytes;
+  HASH_ADD(hh, p->paged, key, sizeof(tile_key), t);
+
+  HASH_DEL(p->tiles, tile);
+  free(tile);
+
+  logic_evict(cells, n);
+  u->paged += n;
+}
+
+/**
+ * @brief Page the queued tiles back in, which frees them and the queue
+ *
+ * The tiles that the cells paged in reach are paged in as well, so a group of
+ * tiles is never split.
+ */
+static void page_in(gol_universe *u, page_T *p, queue_T *q) {
+  for (size_t k = 0; k < q->size; k++) {
+    paged_T *t = q->tiles[k];
+    size_t   m = decode(p, t);
+
+    logic_restore(p->cells, m);
+    tile_get(p, t->key, u->generation)->changed = u->generation;
+
+    u->paged -= t->count;
+    p->garbage += t->bytes;
+    HASH_DEL(p->paged, t);
+    free(t);
+
+    for (size_t l = 0; l < m; l++) {
+      const coord_val *c = &p->cells[l];
+
+      if (!near_edge(u, c->row, c->col))
+        continue;
+
+      for (int d = 0; d < 8; d++) {
+        paged_T *n = paged_find(p, probe(u, c->row, c->col, d));
+
+        if (n != NULL && edge_hit(u, n->edges, n->key, c->row, c->col))
+          queue_push(q, n);
+      }
+    }
+  }
+
+  free(q->tiles);
+  *q = (queue_T){0};
+
+  if (!u->paged) {
+    p->size = 0;
+    p->garbage = 0;
+  }
+  arena_compact(p);
+}
+
+/**
+ * @brief Check if the range of coordinates from lo to hi overlaps size of them
+ * starting at start, wrapping around the edge of board if it's limited
+ */
+static int axis_hits(int64_t lo, int64_t hi, int64_t start, int64_t size,
+                     int board) {
+  if (board)
+    return WCLAMP(lo - start, board) < size || (lo <= start && start <= hi);
+  return hi >= start && (lo <= start || lo - start < size);
+}
+
+/**
+ * @brief Wrap the start of a region of the limited universe and clip its size
+ * to the universe. Return 0 if the region is empty
+ */
+static int region_clip(const gol_universe *u, int64_t *i, int64_t *j,
+                       int64_t *h, int64_t *w) {
+  if (u->isWrapping) {
+    *i = wrap(*i, u->height);
+    *j = wrap(*j, u->width);
+    *h = MIN(*h, u->height);
+    *w = MIN(*w, u->width);
+  }
+  return *h > 0 && *w > 0;
+}
+
+/**
+ * @brief Queue the paged tiles overlapping a region of h x w cells starting at
+ * (i,j)
+ *
+ * The cheaper of looking up each tile of the region and a single pass over
+ * the paged tiles is chosen based on the region area and the number of tiles.
+ */
+static void region_tiles(gol_universe *u, page_T *p, int64_t i, int64_t j,
+                         int64_t h, int64_t w, queue_T *q) {
+  size_t   total = HASH_COUNT(p->paged);
+  uint64_t rows, cols;
+
+  if (!total || !region_clip(u, &i, &j, &h, &w))
+    return;
+
+  // tiles cut by the region and by the edge of the universe
+  rows = (uint64_t)h / PAGE_SIDE + 3;
+  cols = (uint64_t)w / PAGE_SIDE + 3;
+
+  if (rows < total && cols < total && rows * cols < total) {
+    for (int64_t k = 0, dk; k < h; k += dk) {
+      int64_t row = wrap(i + k, u->height);
+
+      dk = PAGE_SIDE - (row & (PAGE_SIDE - 1));
+      if (u->isWrapping)
+        dk = MIN(dk, u->height - row);
+
+      for (int64_t l = 0, dl; l < w; l += dl) {
+        int64_t  col = wrap(j + l, u->width);
+        paged_T *t = paged_find(p, key_of(row, col));
+
+        dl = PAGE_SIDE - (col & (PAGE_SIDE - 1));
+        if (u->isWrapping)
+          dl = MIN(dl, u->width - col);
+
+        if (t != NULL)
+          queue_push(q, t);
+      }
+    }
+  } else {
+    for (paged_T *t = p->paged; t != NULL; t = t->hh.next)
+      if (axis_hits(t->min_row, t->max_row, i, h, u->height) &&
+          axis_hits(t->min_col, t->max_col, j, w, u->width))
+        queue_push(q, t);
+  }
+}
+
+/**
+ * @brief Page in the tiles within PAGE_HALO cells of a region of h x w cells
+ * starting at (i,j), which is about to be changed
+ */
+void page_touch(gol_universe *u, int64_t i, int64_t j, int64_t h, int64_t w) {
+  queue_T q = {0};
+
+  if (!u->paged)
+    return;
+
+  region_tiles(u, u->page, i - PAGE_HALO, j - PAGE_HALO, h + 2 * PAGE_HALO,
+               w + 2 * PAGE_HALO, &q);
+  page_in(u, u->page, &q);
+}
+
+/**
+ * @brief Return the value of a paged cell, 0 if it is not paged out
+ */
+int page_get(gol_universe *u, int64_t row, int64_t col) {
+  paged_T *t;
+  size_t   n;
+
+  if (!u->paged || (t = paged_find(u->page, key_of(row, col))) == NULL)
+    return 0;
+
+  n = decode(u->page, t);
+  for (size_t k = 0; k < n; k++)
+    if (u->page->cells[k].row == row && u->page->cells[k].col == col)
+      return u->page->cells[k].val;
+  return 0;
+}
+
+/**
+ * @brief Copy the paged cells in a region of h x w cells starting at (i,j)
+ * into a new buffer. Return the number of cells
+ *
+ * Buffer is allocated automatically and should be freed with free().
+ */
+size_t page_cells(gol_universe *u, int64_t i, int64_t j, int64_t h, int64_t w,
+                  coord_val **buffer) {
+  queue_T q = {0};
+  size_t  count = 0, size = 0;
+
+  if (u->paged) {
+    region_tiles(u, u->page, i, j, h, w, &q);
+    region_clip(u, &i, &j, &h, &w);
+  }
+
+  for (size_t k = 0; k < q.size; k++) {
+    q.tiles[k]->queued = 0;
+    count += q.tiles[k]->count;
+  }
+
+  MEM_CHECK(*buffer = malloc((count + 1) * sizeof(coord_val)));
+  for (size_t k = 0; k < q.size; k++) {
+    size_t     m = decode(u->page, q.tiles[k]);
+    coord_val *cells = u->page->cells;
+
+    for (size_t l = 0; l < m; l++)
+      if (axis_hits(cells[l].row, cells[l].row, i, h, u->height) &&
+          axis_hits(cells[l].col, cells[l].col, j, w, u->width))
+        (*buffer)[size++] = cells[l];
+  }
+
+  free(q.tiles);
+  return size;
+}
+
+/**
+ * @brief Copy all paged cells into the buffer, which has room for u->paged of
+ * them. Return the number of cells
+ */
+size_t page_all(gol_universe *u, coord_val *buffer) {
+  size_t size = 0;
+
+  if (!u->paged)
+    return 0;
+
+  for (paged_T *t = u->page->paged; t != NULL; t = t->hh.next) {
+    size_t n = decode(u->page, t);
+
+    memcpy(buffer + size, u->page->cells, n * sizeof(coord_val));
+    size += n;
+  }
+  return size;
+}
+
+/**
+ * @brief Extend the bounding box by the paged cells. Return 0 if there are
+ * none and the box is left as it is
+ */
+int page_bounds(const gol_universe *u, int64_t *min_row, int64_t *min_col,
+                int64_t *max_row, int64_t *max_col) {
+  if (!u->paged)
+    return 0;
+
+  for (paged_T *t = u->page->paged; t != NULL; t = t->hh.next) {
+    *min_row = MIN(*min_row, t->min_row);
+    *min_col = MIN(*min_col, t->min_col);
+    *max_row = MAX(*max_row, t->max_row);
+    *max_col = MAX(*max_col, t->max_col);
+  }
+  return 1;
+}
+
+/**
+ * @brief Page in the tiles that living cells came within PAGE_HALO cells of
+ */
+static void page_halo(gol_universe *u, page_T *p) {
+  queue_T q = {0};
+
+  for (Cell *c = u->hash; c != NULL; c = c->hh.next) {
+    if (!near_edge(u, c->cord.row, c->cord.col))
+      continue;
+
+    for (int k = 0; k < 8; k++) {
+      paged_T *t = paged_find(p, probe(u, c->cord.row, c->cord.col, k));
+
+      if (t != NULL && edge_hit(u, t->edges, t->key, c->cord.row, c->cord.col))
+        queue_push(&q, t);
+    }
+  }
+
+  page_in(u, p, &q);
+}
+
+/**
+ * @brief Compare cells by tile, and then row-major inside of the tile
+ */
+static int tile_cmp(const void *a, const void *b) {
+  const coord_val *x = a, *y = b;
+  int64_t          tx = tile_of(x->row), ty = tile_of(y->row);
+
+  if (tx != ty)
+    return tx < ty ? -1 : 1;
+  if ((tx = tile_of(x->col)) != (ty = tile_of(y->col)))
+    return tx < ty ? -1 : 1;
+  if (x->row != y->row)
+    return x->row < y->row ? -1 : 1;
+  return (x->col > y->col) - (x->col < y->col);
+}
+
+/**
+ * @brief Compare groups by the generation they last changed in
+ */
+static int changed_cmp(const void *a, const void *b) {
+  const group_T *x = a, *y = b;
+
+  if (x->changed != y->changed)
+    return x->changed < y->changed ? -1 : 1;
+  if (x->first->key.row != y->first->key.row)
+    return x->first->key.row < y->first->key.row ? -1 : 1;
+  return (x->first->key.col > y->first->key.col) -
+         (x->first->key.col < y->first->key.col);
+}
+
+/**
+ * @brief Return the tile the group of the tile was merged into
+ */
+static tile_T *group_find(tile_T *t) {
+  while (t->group != t)
+    t = t->group = t->group->group;
+  return t;
+}
+
+/**
+ * @brief Merge the groups of two tiles
+ */
+static void group_merge(tile_T *a, tile_T *b) {
+  a = group_find(a);
+  b = group_find(b);
+  if (a != b)
+    b->group = a;
+}
+
+/**
+ * @brief Return the part of the checksum of a tile added by the cell
+ */
+static uint64_t cell_sum(const coord_val *c) {
+  uint64_t x = (uint64_t)c->row * 0x9E3779B97F4A7C15 ^
+               (uint64_t)c->col * 0xC2B2AE3D27D4EB4F ^ c->val;
+
+  x ^= x >> 31;
+  return x * 0xBF58476D1CE4E5B9;
+}
+
+/**
+ * @brief Check if the cells are a still life, using scratch universe of the
+ * same size and game mode
+ */
+static int is_still(gol_universe *scratch, const coord_val *cells, size_t n) {
+  size_t alive = 0;
+
+  gol_clear(scratch);
+  gol_insert(scratch, cells, n);
+  gol_evolve(scratch, 1);
+
+  // some game modes keep dead cells in the hash
+  for (Cell *c = scratch->hash; c != NULL; c = c->hh.next)
+    alive += c->val != 0;
+  if (alive != n)
+    return 0;
+
+  for (size_t k = 0; k < n; k++)
+    if (gol_get(scratch, cells[k].row, cells[k].col) != cells[k].val)
+      return 0;
+  return 1;
+}
+
+/**
+ * @brief Update the tiles of the universe, and page out the groups of cold
+ * ones while the living cells take more than the budget
+ */
+static void page_scan(gol_universe *u, page_T *p) {
+  coord_val    *cells, *group = NULL;
+  tile_T       *t, *tmp;
+  group_T      *groups;
+  gol_universe *scratch;
+  size_t        size = 0, count = 0, group_c = 0, resident;
+
+  MEM_CHECK(cells = malloc((HASH_COUNT(u->hash) + 1) * sizeof(coord_val)));
+  for (Cell *c = u->hash; c != NULL; c = c->hh.next)
+    if (c->val)
+      cells[size++] = (coord_val){c->cord.row, c->cord.col, c->val};
+  qsort(cells, size, sizeof(coord_val), tile_cmp);
+
+  p->scans++;
+  for (size_t k = 0, end; k < size; k = end) {
+    tile_key key = key_of(cells[k].row, cells[k].col);
+    uint64_t sum = 0;
+
+    t = tile_get(p, key, u->generation);
+    memset(t->edges, 0, sizeof(t->edges));
+    for (end = k; end < size && tile_of(cells[end].row) == key.row &&
+                  tile_of(cells[end].col) == key.col;
+         end++) {
+      sum += cell_sum(&cells[end]);
+      edge_add(t->edges, key, cells[end].row, cells[end].col);
+    }
+
+    if (t->sum != sum || t->count != end - k) {
+      t->sum = sum;
+      t->count = end - k;
+      t->changed = u->generation;
+    }
+    t->first = k;
+    t->seen = p->scans;
+    t->group = t;
+    t->next = NULL;
+    t->tiles = 1;
+  }
+
+  HASH_ITER(hh, p->tiles, t, tmp) {
+    if (t->seen != p->scans) {
+      HASH_DEL(p->tiles, t);
+      free(t);
+    }
+  }
+
+  resident = size * PAGE_CELL_BYTES;
+  if (resident <= p->budget) {
+    free(cells);
+    return;
+  }
+
+  // tiles with cells within reach of each other are grouped together
+  for (size_t k = 0; k < size; k++) {
+    tile_key key = key_of(cells[k].row, cells[k].col);
+    tile_T  *own = NULL;
+
+    if (!near_edge(u, cells[k].row, cells[k].col))
+      continue;
+
+    for (int l = 0; l < 8; l++) {
+      tile_key other = probe(u, cells[k].row, cells[k].col, l);
+
+      if ((other.row == key.row && other.col == key.col) ||
+          (t = tile_find(p, other)) == NULL ||
+          !edge_hit(u, t->edges, t->key, cells[k].row, cells[k].col))
+        continue;
+
+      if (own == NULL)
+        own = tile_find(p, key);
+      group_merge(own, t);
+    }
+  }
+
+  for (t = p->tiles; t != NULL; t = t->hh.next) {
+    tile_T *first = group_find(t);
+
+    if (first != t) {
+      t->next = first->next;
+      first->next = t;
+      first->tiles++;
+    }
+  }
+
+  MEM_CHECK(groups = malloc((HASH_COUNT(p->tiles) + 1) * sizeof(group_T)));
+  for (t = p->tiles; t != NULL; t = t->hh.next) {
+    group_T g = {t, 0};
+    int     cold = t->group == t && t->tiles <= PAGE_GROUP;
+
+    for (tile_T *m = t; cold && m != NULL; m = m->next) {
+      cold = is_full(u, m->key) && u->generation - m->changed >= PAGE_COLD;
+      g.changed = MAX(g.changed, m->changed);
+    }
+
+    if (cold)
+      groups[count++] = g;
+  }
+  qsort(groups, count, sizeof(group_T), changed_cmp);
+
+  scratch = gol_create(u->height, u->width, u->evolve_index);
+  for (size_t k = 0; k < count && resident > p->budget; k++) {
+    size_t n = 0;
+
+    for (tile_T *m = groups[k].first; m != NULL; m = m->next) {
+      if (n + m->count > group_c) {
+        coord_val *c;
+
+        group_c = MAX(group_c * 2, n + m->count);
+        MEM_CHECK(c = realloc(group, group_c * sizeof(coord_val)));
+        group = c;
+      }
+      memcpy(group + n, cells + m->first, m->count * sizeof(coord_val));
+      n += m->count;
+    }
+
+    if (!is_still(scratch, group, n)) {
+      for (tile_T *m = groups[k].first; m != NULL; m = m->next)
+        m->changed = u->generation;
+      continue;
+    }
+
+    for (tile_T *m = groups[k].first, *next; m != NULL; m = next) {
+      next = m->next;
+      resident -= m->count * PAGE_CELL_BYTES;
+      page_out(u, p, m, cells + m->first, m->count);
+    }
+  }
+
+  gol_destroy(scratch);
+  free(groups);
+  free(group);
+  free(cells);
+}
+
+/**
+ * @brief Page in the tiles that are about to be reached by living cells, and
+ * page out the cold ones if it's time to, after each generation
+ */
+void page_step(gol_universe *u) {
+  if (u->paged)
+    page_halo(u, u->page);
+
+  if (u->generation % PAGE_INTERVAL == 0)
+    page_scan(u, u->page);
+}
+
+/**
+ * @brief Return the bytes used by the paging of the universe, with the arena
+ * of the paged tiles, or 0 if it's disabled
+ */
+size_t page_memory(const gol_universe *u) {
+  const page_T *p = u->page;
+
+  if (p == NULL)
+    return 0;
+
+  // handles of the tiles are counted by HASH_OVERHEAD
+  return sizeof(page_T) + p->capacity + p->delta.capacity +
+         p->cells_c * sizeof(coord_val) +
+         HASH_COUNT(p->paged) * (sizeof(paged_T) - sizeof(UT_hash_handle)) +
+         HASH_OVERHEAD(hh, p->paged) +
+         HASH_COUNT(p->tiles) * (sizeof(tile_T) - sizeof(UT_hash_handle)) +
+         HASH_OVERHEAD(hh, p->tiles);
+}
+
+/**
+ * @brief Drop all paged tiles of the universe, which is being cleared
+ */
+void page_clear(gol_universe *u) {
+  page_T  *p = u->page;
+  paged_T *t, *t_tmp;
+  tile_T  *r, *r_tmp;
+
+  if (p == NULL)
+    return;
+
+  HASH_ITER(hh, p->paged, t, t_tmp) {
+    HASH_DEL(p->paged, t);
+    free(t);
+  }
+  HASH_ITER(hh, p->tiles, r, r_tmp) {
+    HASH_DEL(p->tiles, r);
+    free(r);
+  }
+
+  p->size = 0;
+  p->garbage = 0;
+  u->paged = 0;
+}
+
+/**
+ * @brief Stop paging and free the paging of the universe, dropping the paged
+ * tiles and removing its backing file
+ */
+void page_close(gol_universe *u) {
+  page_T *p = u->page;
+
+  if (p == NULL)
+    return;
+
+  page_clear(u);
+
+#ifndef _WIN32
+  if (p->fd >= 0) {
+    if (p->data != NULL)
+      munmap(p->data, p->capacity);
+    close(p->fd);
+    unlink(p->name);
+    p->data = NULL;
+  }
+#endif
+
+  free(p->data);
+  free(p->name);
+  free(p->cells);
+  delta_free(&p->delta);
+  free(p);
+  u->page = NULL;
+}
+
+/**
+ * @brief Open the backing file with name for the paged tiles. Return -1 if it
+ * can't be created, or paged tiles are always kept in memory
+ */
+static int page_open(const char *name) {
+#ifndef _WIN32
+  return open(name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+#else
+  (void)name;
+  return -1;
+#endif
+}
+
+/**
+ * @brief Keep the living cells of the universe within budget bytes by paging
+ * out cold still lifes, or page them all back in and stop paging if it's 0.
+ * Paged tiles are kept in the backing file with name, which is removed when
+ * paging stops, or in memory if it is NULL. Return 0 if the game mode is
+ * random or the file can't be created
+ *
+ * The backing file is only used on systems with memory mapped files, and
+ * changing the budget of a universe that is already paging keeps its file.
+ */
+int gol_page(gol_universe *u, size_t budget, const char *file) {
+  gol_universe *prev = universe;
+  page_T       *p = u->page;
+
+  if (!budget) {
+    queue_T q = {0};
+
+    if (p == NULL)
+      return 1;
+
+    universe = u;
+    for (paged_T *t = p->paged; t != NULL; t = t->hh.next)
+      queue_push(&q, t);
+    page_in(u, p, &q);
+
+    page_close(u);
+    universe = prev;
+    return 1;
+  }
+
+  if (evolution_random[u->evolve_index])
+    return 0;
+
+  if (p == NULL) {
+    MEM_CHECK(p = calloc(1, sizeof(page_T)));
+    p->fd = -1;
+
+    if (file != NULL) {
+      p->fd = page_open(file);
+      if (p->fd >= 0)
+        MEM_CHECK(p->name = strdup(file));
+#ifndef _WIN32
+      if (p->fd < 0) {
+        free(p);
+        return 0;
+      }
+#endif
+    }
+
+    u->page = p;
+    universe = u;
+    page_scan(u, p);
+    universe = prev;
+  }
+
+  p->budget = budget;
+  return 1;
+}
+
+/**
+ * @brief Get the number of tiles with living cells in memory and paged out.
+ * Return 0 if the universe is not paging
+ *
+ * Tiles in memory are counted at the last scan, which happens every few
+ * generations.
+ */
+int gol_tiles(const gol_universe *u, size_t *resident, size_t *paged) {
+  if (u->page == NULL) {
+    *resident = *paged = 0;
+    return 0;
+  }
+
+  *resident = HASH_COUNT(u->page->tiles);
+  *paged = HASH_COUNT(u->page->paged);
+  return 1;
+}
@@ -0,0 +1,211 @@
+/**
+ * @file pool.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the work stealing thread pool of the library
+ *
+ * The pool runs a task for each index in a range on a number of threads,
+ * which is used to evolve many independent universes at once. The range is
+ * split evenly between the threads up front, and each of them works through
+ * its own part from the front. A thread that runs out of work steals the back
+ * half of the largest part left, so the threads stay busy even when some of
+ * the tasks take much longer than the others, like universes that take long
+ * to settle down.
+ *
+ * Tasks are not created while the pool is running, so a thread that finds no
+ * work left anywhere is done. The calling thread takes part in the work.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "gol.h"
+#include "utils.h"
+
+/**
+ * @brief Part of the range owned by one thread
+ */
+typedef struct part_T {
+  pthread_mutex_t lock; ///< guards next and end
+  size_t          next; ///< next index to be run
+  size_t          end;  ///< index after the last one of the part
+} part_T;
+
+/**
+ * @brief State of a running pool
+ */
+typedef struct pool_T {
+  part_T    *parts;   ///< parts of the range, one for each thread
+  int        threads; ///< number of threads
+  gol_task_f task;    ///< function run for each index
+  void      *arg;     ///< argument passed to the task
+} pool_T;
+
+/**
+ * @brief Argument of a pool thread
+ */
+typedef struct worker_T {
+  pool_T *pool; ///< pool the thread belongs to
+  int     id;   ///< index of the part owned by the thread
+} worker_T;
+
+/**
+ * @brief Take the next index from the part, return 0 if it's empty
+ */
+static int part_take(part_T *p, size_t *index) {
+  int found = 0;
+
+  pthread_mutex_lock(&p->lock);
+  if (p->next < p->end) {
+    *index = p->next++;
+    found = 1;
+  }
+  pthread_mutex_unlock(&p->lock);
+  return found;
+}
+
+/**
+ * @brief Move the back half of the largest part of the other threads into the
+ * part of thread id, return 0 if there is no work left
+ */
+static int pool_steal(pool_T *pool, int id) {
+  part_T *own = &pool->parts[id];
+  size_t  best = 0, start, end;
+  int     victim = -1;
+
+  for (int k = 1; k < pool->threads; k++) {
+    part_T *p = &pool->parts[(id + k) % pool->threads];
+    size_t  left;
+
+    pthread_mutex_lock(&p->lock);
+    left = p->end - p->next;
+    pthread_mutex_unlock(&p->lock);
+
+    if (left > best) {
+      best = left;
+      victim = (id + k) % pool->threads;
+    }
+  }
+
+  if (victim < 0)
+    return 0;
+
+  part_T *p = &pool->parts[victim];
+  pthread_mutex_lock(&p->lock);
+  if (p->next == p->end) {
+    pthread_mutex_unlock(&p->lock);
+    return 1; // taken in the meantime, look again
+  }
+  start = p->next + (p->end - p->next) / 2;
+  end = p->end;
+  p->end = start;
+  pthread_mutex_unlock(&p->lock);
+
+  pthread_mutex_lock(&own->lock);
+  own->next = start;
+  own->end = end;
+  pthread_mutex_unlock(&own->lock);
+  return 1;
+}
+
+/**
+ * @brief Run the tasks of the own part, then the stolen ones until there are
+ * none left
+ */
+static void *pool_worker(void *arg) {
+  worker_T *w = arg;
+  pool_T   *pool = w->pool;
+  size_t    index;
+
+  do {
+    while (part_take(&pool->parts[w->id], &index))
+      pool->task(index, pool->arg);
+  } while (pool_steal(pool, w->id));
+
+  return NULL;
+}
+
+/**
+ * @brief Return the number of threads to use when 0 is requested, the number
+ * of processors
+ */
+int gol_threads(void) {
+#ifdef _WIN32
+  return 4;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? n : 1;
+#endif
+}
+
+/**
+ * @brief Run task for each index from 0 to count - 1 on threads threads, or
+ * on all processors if threads is 0, and wait for all of them to finish
+ */
+void gol_parallel(size_t count, int threads, gol_task_f task, void *arg) {
+  pool_T     pool = {NULL, threads > 0 ? threads : gol_threads(), task, arg};
+  worker_T  *workers;
+  pthread_t *ids;
+  int        started = 1;
+
+  if (!count)
+    return;
+
+  if ((size_t)pool.threads > count)
+    pool.threads = count;
+
+  MEM_CHECK(pool.parts = malloc(pool.threads * sizeof(part_T)));
+  MEM_CHECK(workers = malloc(pool.threads * sizeof(worker_T)));
+  MEM_CHECK(ids = malloc(pool.threads * sizeof(pthread_t)));
+
+  for (int i = 0; i < pool.threads; i++) {
+    pthread_mutex_init(&pool.parts[i].lock, NULL);
+    pool.parts[i].next = count * i / pool.threads;
+    pool.parts[i].end = count * (i + 1) / pool.threads;
+    workers[i] = (worker_T){&pool, i};
+  }
+
+  // the work of the threads that can't be started is stolen by the others
+  for (int i = 1; i < pool.threads; i++, started++)
+    if (pthread_create(&ids[i], NULL, pool_worker, &workers[i]) != 0)
+      break;
+
+  pool_worker(&workers[0]);
+
+  for (int i = 1; i < started; i++)
+    pthread_join(ids[i], NULL);
+
+  for (int i = 0; i < pool.threads; i++)
+    pthread_mutex_destroy(&pool.parts[i].lock);
+
+  free(ids);
+  free(workers);
+  free(pool.parts);
+}
+
+/**
+ * @brief Argument of evolve_task()
+ */
+typedef struct evolve_T {
+  gol_universe **universes; ///< universes to evolve
+  int            steps;     ///< number of generations
+} evolve_T;
+
+/**
+ * @brief Evolve one of the universes
+ */
+static void evolve_task(size_t index, void *arg) {
+  evolve_T *e = arg;
+  gol_evolve(e->universes[index], e->steps);
+}
+
+/**
+ * @brief Evolve all of the universes by steps generations on threads threads,
+ * or on all processors if threads is 0
+ */
+void gol_evolve_many(gol_universe **universes, size_t count, int steps,
+                     int threads) {
+  evolve_T e = {universes, steps};
+  gol_parallel(count, threads, evolve_task, &e);
+}
@@ -0,0 +1,566 @@
+/**
+ * @file record.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains recording and replaying of the game
+ *
+ * A recording is a header with the game size and mode, followed by frames,
+ * one for each displayed generation. A frame holds either all of the living
+ * cells, called a keyframe, or the cells that changed since the previous
+ * frame, both encoded as described in delta.c. The first frame is always a
+ * keyframe, and a new one is written once the frames since the last keyframe
+ * get RECORD_RATIO times larger than it, or after the game has been edited.
+ *
+ * Changes are reported by the evolution, so the game thread only copies them
+ * into a queue. Sorting, encoding and writing them is done on a separate
+ * thread, which flushes the file whenever the queue is empty. If the writing
+ * falls behind by RECORD_QUEUE frames, the game waits.
+ *
+ * Replay indexes the frames when the recording is opened, and then drives the
+ * game from the file without evolving it. Seeking decodes the nearest
+ * keyframe and applies the frames up to the requested one, or just the frames
+ * in between when seeking forward.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "delta.h"
+#include "game.h"
+#include "record.h"
+#include "utils.h"
+
+/// Magic bytes at the start of every recording
+#define RECORD_MAGIC "GOLR"
+
+/// Version of the recording format
+#define RECORD_VERSION 1
+
+/// Maximum number of frames waiting to be written
+#define RECORD_QUEUE 64
+
+/// Size of the frames since the last keyframe relative to it before a new
+/// keyframe is written
+#define RECORD_RATIO 8
+
+/// Minimum size of the frames since the last keyframe before a new keyframe
+/// is written
+#define RECORD_MIN 4096
+
+/// Size of the buffer of the recording file
+#define RECORD_BUFFER (1 << 20)
+
+/**
+ * @brief Header at the start of the recording
+ */
+typedef struct header_T {
+  char     magic[4]; ///< RECORD_MAGIC
+  uint32_t version;  ///< RECORD_VERSION
+  int32_t  height;   ///< height of the game, 0 if unlimited
+  int32_t  width;    ///< width of the game, 0 if unlimited
+  int32_t  mode;     ///< index of the game mode
+  uint32_t reserved; ///< always 0
+} header_T;
+
+/**
+ * @brief Header of a frame in the recording
+ */
+typedef struct frame_T {
+  uint64_t generation; ///< generation of the frame
+  uint64_t size;       ///< size of the encoded cells in bytes
+  uint32_t keyframe;   ///< frame holds all of the living cells
+  uint32_t reserved;   ///< always 0
+} frame_T;
+
+/**
+ * @brief Frame waiting to be written
+ */
+typedef struct job_T {
+  struct job_T *next;       ///< next frame in the queue
+  uint64_t      generation; ///< generation of the frame
+  int           keyframe;   ///< cells are all of the living cells
+  coord_val    *cells;      ///< cells of the frame
+  size_t        size;       ///< number of cells
+} job_T;
+
+/**
+ * @brief State of the recording of the current game
+ */
+typedef struct recorder_T {
+  FILE           *file;      ///< recording being written
+  pthread_t       thread;    ///< thread writing the frames
+  pthread_mutex_t lock;      ///< guards the queue
+  pthread_cond_t  cond;      ///< signals changes of the queue
+  job_T          *head;      ///< oldest frame in the queue
+  job_T          *tail;      ///< newest frame in the queue
+  int             queued;    ///< number of frames in the queue
+  int             stop;      ///< thread should exit once the queue is empty
+  atomic_int      want_key;  ///< next frame should be a keyframe
+  delta_T         delta;     ///< buffer for encoding a frame
+  size_t          key_size;  ///< size of the last keyframe
+  size_t          since_key; ///< size of the frames since the last keyframe
+  coord_val      *pending;   ///< changes of the frame being collected
+  size_t          pending_s; ///< number of changes in pending
+  size_t          pending_c; ///< capacity of pending
+  int             steps;     ///< number of generations in pending
+  int             active;    ///< game is being recorded
+} recorder_T;
+
+/**
+ * @brief Position of a frame in the recording being replayed
+ */
+typedef struct index_T {
+  uint64_t generation; ///< generation of the frame
+  long     offset;     ///< offset of the encoded cells in the file
+  uint64_t size;       ///< size of the encoded cells in bytes
+  size_t   key;        ///< index of the last keyframe at or before the frame
+} index_T;
+
+/**
+ * @brief State of the recording being replayed
+ */
+typedef struct player_T {
+  FILE     *file;     ///< recording being replayed
+  header_T  header;   ///< header of the recording
+  index_T  *frames;   ///< all complete frames of the recording
+  size_t    frames_s; ///< number of frames
+  size_t    current;  ///< index of the frame shown, frames_s if none
+  uint8_t  *data;     ///< buffer for reading a frame
+  size_t    data_c;   ///< capacity of data
+  int       active;   ///< recording is being replayed
+} player_T;
+
+static recorder_T rec;
+static player_T   player;
+
+/**
+ * @brief Encode and write the frame, run on the recording thread
+ */
+static void record_write(job_T *job) {
+  frame_T h;
+
+  delta_sort(job->cells, job->size);
+  rec.delta.size = 0;
+  delta_begin(&rec.delta);
+  for (size_t i = 0; i < job->size; i++) {
+    // the same cell changed in more than one generation of the frame
+    if (i && !delta_cmp(&job->cells[i - 1], &job->cells[i]))
+      continue;
+    delta_push(&rec.delta, &job->cells[i]);
+  }
+
+  h = (frame_T){job->generation, rec.delta.size, job->keyframe, 0};
+  fwrite(&h, sizeof(h), 1, rec.file);
+  fwrite(rec.delta.data, 1, rec.delta.size, rec.file);
+
+  if (job->keyframe) {
+    rec.key_size = rec.delta.size;
+    rec.since_key = 0;
+  } else {
+    rec.since_key += rec.delta.size;
+    if (rec.since_key >= MAX(rec.key_size * RECORD_RATIO, RECORD_MIN))
+      atomic_store(&rec.want_key, 1);
+  }
+}
+
+/**
+ * @brief Write the queued frames until the recording is stopped
+ */
+static void *record_worker(void *arg) {
+  pthread_mutex_lock(&rec.lock);
+  while (TRUE) {
+    job_T *job;
+
+    while (!rec.head && !rec.stop)
+      pthread_cond_wait(&rec.cond, &rec.lock);
+    if (!rec.head)
+      break;
+
+    job = rec.head;
+    if (!(rec.head = job->next))
+      rec.tail = NULL;
+    rec.queued--;
+    pthread_cond_broadcast(&rec.cond);
+    pthread_mutex_unlock(&rec.lock);
+
+    record_write(job);
+    free(job->cells);
+    free(job);
+
+    pthread_mutex_lock(&rec.lock);
+    if (!rec.head) {
+      // nothing else to write, so the frames reach the file in case of a crash
+      pthread_mutex_unlock(&rec.lock);
+      fflush(rec.file);
+      pthread_mutex_lock(&rec.lock);
+    }
+  }
+  pthread_mutex_unlock(&rec.lock);
+  return NULL;
+}
+
+/**
+ * @brief Queue the frame to be written, waiting if the queue is full
+ */
+static void record_push(job_T *job) {
+  pthread_mutex_lock(&rec.lock);
+  while (rec.queued >= RECORD_QUEUE)
+    pthread_cond_wait(&rec.cond, &rec.lock);
+
+  if (rec.tail)
+    rec.tail->next = job;
+  else
+    rec.head = job;
+  rec.tail = job;
+  rec.queued++;
+
+  pthread_cond_broadcast(&rec.cond);
+  pthread_mutex_unlock(&rec.lock);
+}
+
+/**
+ * @brief Start recording the current game to a new file named after the
+ * current time
+ */
+void record_start(void) {
+  header_T h = {RECORD_MAGIC, RECORD_VERSION, height, width,
+                universe->evolve_index, 0};
+  time_t   t = time(NULL);
+  char     name[64];
+
+  if (rec.active)
+    return;
+
+  strftime(name, sizeof(name), "%Y%m%d-%H%M%S." RECORD_EXT, localtime(&t));
+  if ((rec.file = fopen(name, "wb")) == NULL)
+    return;
+
+  setvbuf(rec.file, NULL, _IOFBF, RECORD_BUFFER);
+  fwrite(&h, sizeof(h), 1, rec.file);
+
+  pthread_mutex_init(&rec.lock, NULL);
+  pthread_cond_init(&rec.cond, NULL);
+  rec.stop = 0;
+  rec.key_size = 0;
+  rec.since_key = 0;
+  rec.pending_s = 0;
+  rec.steps = 0;
+
+  if (pthread_create(&rec.thread, NULL, record_worker, NULL) != 0) {
+    fclose(rec.file);
+    return;
+  }
+  rec.active = 1;
+
+  record_keyframe();
+  record_frame();
+}
+
+/**
+ * @brief Stop recording, waiting for the queued frames to be written
+ */
+void record_stop(void) {
+  if (!rec.active)
+    return;
+
+  pthread_mutex_lock(&rec.lock);
+  rec.stop = 1;
+  pthread_cond_broadcast(&rec.cond);
+  pthread_mutex_unlock(&rec.lock);
+
+  pthread_join(rec.thread, NULL);
+  pthread_mutex_destroy(&rec.lock);
+  pthread_cond_destroy(&rec.cond);
+  fclose(rec.file);
+
+  free(rec.pending);
+  rec.pending = NULL;
+  rec.pending_c = 0;
+  delta_free(&rec.delta);
+  rec.active = 0;
+}
+
+/**
+ * @brief Check if the game is being recorded
+ */
+int record_active(void) { return rec.active; }
+
+/**
+ * @brief Make the next frame a keyframe, used when the game is edited
+ */
+void record_keyframe(void) { atomic_store(&rec.want_key, 1); }
+
+/**
+ * @brief Add the cells changed by a generation to the frame being collected
+ */
+void record_changes(const coord_val *cells, int size) {
+  if (!rec.active)
+    return;
+
+  if (rec.pending_s + size > rec.pending_c) {
+    coord_val *t;
+    rec.pending_c = MAX(rec.pending_c * 2, rec.pending_s + size);
+    MEM_CHECK(t = realloc(rec.pending, rec.pending_c * sizeof(coord_val)));
+    rec.pending = t;
+  }
+
+  memcpy(rec.pending + rec.pending_s, cells, size * sizeof(coord_val));
+  rec.pending_s += size;
+  rec.steps++;
+}
+
+/**
+ * @brief Queue the frame of the displayed generation to be written
+ */
+void record_frame(void) {
+  job_T *job;
+
+  if (!rec.active)
+    return;
+
+  MEM_CHECK(job = calloc(1, sizeof(job_T)));
+  job->generation = gen;
+
+  if (atomic_exchange(&rec.want_key, 0)) {
+    job->keyframe = 1;
+    job->size = logic_collect(&job->cells);
+  } else {
+    // cells that changed more than once get their final value
+    if (rec.steps > 1)
+      for (size_t i = 0; i < rec.pending_s; i++)
+        rec.pending[i].val = getAt(rec.pending[i].row, rec.pending[i].col);
+
+    job->cells = rec.pending;
+    job->size = rec.pending_s;
+    rec.pending = NULL;
+    rec.pending_c = 0;
+  }
+
+  rec.pending_s = 0;
+  rec.steps = 0;
+  record_push(job);
+}
+
+/// Buffer that record_push_cell() appends to while a recording is read
+static cells_T *record_loading;
+
+/**
+ * @brief Append a cell of the first frame to record_loading
+ */
+static void record_push_cell(int64_t row, int64_t col, int val) {
+  cells_push(record_loading, row, col, val);
+}
+
+/**
+ * @brief Read the first frame of the recording with name into cells, return
+ * the index of its game mode or -1 if the file is not a valid recording
+ */
+int record_read(char *name, cells_T *cells) {
+  header_T h;
+  frame_T  r;
+  uint8_t *data;
+  int      mode = -1;
+  FILE    *f;
+
+  if ((f = fopen(name, "rb")) == NULL)
+    return -1;
+
+  if (fread(&h, sizeof(h), 1, f) == 1 && !memcmp(h.magic, RECORD_MAGIC, 4) &&
+      h.version == RECORD_VERSION && fread(&r, sizeof(r), 1, f) == 1 &&
+      r.size < ((uint64_t)1 << 40) && (data = malloc(r.size + 1))) {
+    record_loading = cells;
+    if (fread(data, 1, r.size, f) == r.size &&
+        delta_decode(data, r.size, record_push_cell))
+      mode = h.mode;
+    record_loading = NULL;
+    free(data);
+  }
+
+  fclose(f);
+  return mode;
+}
+
+/**
+ * @brief Open the recording with name for replay and index its frames,
+ * return 0 if it is not a valid recording
+ */
+int replay_open(char *name) {
+  frame_T r;
+  long    offset, end;
+  size_t  capacity = 0;
+
+  replay_close();
+  if ((player.file = fopen(name, "rb")) == NULL)
+    return 0;
+
+  fseek(player.file, 0, SEEK_END);
+  end = ftell(player.file);
+  rewind(player.file);
+
+  if (fread(&player.header, sizeof(header_T), 1, player.file) != 1 ||
+      memcmp(player.header.magic, RECORD_MAGIC, 4) ||
+      player.header.version != RECORD_VERSION) {
+    replay_close();
+    return 0;
+  }
+
+  offset = sizeof(header_T);
+  while (fread(&r, sizeof(r), 1, player.file) == 1) {
+    offset += sizeof(r);
+
+    // incomplete frame at the end, or a recording that does not start with
+    // a keyframe
+    if (r.size > (uint64_t)(end - offset) || (!player.frames_s && !r.keyframe))
+      break;
+
+    if (player.frames_s == capacity) {
+      index_T *t;
+      capacity = MAX(capacity * 2, 1024);
+      MEM_CHECK(t = realloc(player.frames, capacity * sizeof(index_T)));
+      player.frames = t;
+    }
+
+    player.frames[player.frames_s] = (index_T){
+        r.generation, offset, r.size,
+        r.keyframe ? player.frames_s : player.frames[player.frames_s - 1].key};
+    player.frames_s++;
+
+    offset += r.size;
+    if (fseek(player.file, offset, SEEK_SET) != 0)
+      break;
+  }
+
+  if (!player.frames_s) {
+    replay_close();
+    return 0;
+  }
+
+  player.current = player.frames_s;
+  player.active = 1;
+  return 1;
+}
+
+/**
+ * @brief Stop the replay and close the recording
+ */
+void replay_close(void) {
+  if (player.file)
+    fclose(player.file);
+  free(player.frames);
+  free(player.data);
+  memset(&player, 0, sizeof(player));
+}
+
+/**
+ * @brief Check if a recording is being replayed
+ */
+int replay_active(void) { return player.active; }
+
+/**
+ * @brief Apply the frame with index i to the game
+ */
+static void replay_apply(size_t i) {
+  index_T *frame = &player.frames[i];
+
+  if (frame->size + 1 > player.data_c) {
+    uint8_t *t;
+    MEM_CHECK(t = realloc(player.data, frame->size + 1));
+    player.data = t;
+    player.data_c = frame->size + 1;
+  }
+
+  fseek(player.file, frame->offset, SEEK_SET);
+  if (fread(player.data, 1, frame->size, player.file) != frame->size)
+    return;
+
+  if (frame->key == i)
+    logic_clear();
+  delta_apply(player.data, frame->size);
+}
+
+/**
+ * @brief Show the frame with index i
+ */
+static void replay_goto(size_t i) {
+  size_t start = player.frames[i].key;
+
+  if (i == player.current)
+    return;
+
+  // frames in between are enough when moving forward past no keyframe
+  if (player.current < i && player.current >= start)
+    start = player.current + 1;
+
+  for (; start <= i; start++)
+    replay_apply(start);
+  player.current = i;
+}
+
+/**
+ * @brief Advance the replay by steps frames and set generation to the
+ * generation shown, return 0 if the replay is at its end
+ */
+int replay_step(int steps, unsigned *generation) {
+  size_t i;
+
+  if (player.current + 1 >= player.frames_s)
+    return 0;
+
+  i = MIN(player.current + steps, player.frames_s - 1);
+  replay_goto(i);
+  *generation = player.frames[i].generation;
+  return 1;
+}
+
+/**
+ * @brief Show the last frame at or before generation and set found to its
+ * generation, return 0 if there is none
+ */
+int replay_seek(unsigned generation, unsigned *found) {
+  size_t low = 0, high = player.frames_s;
+
+  // find the first frame after generation
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (player.frames[mid].generation <= generation)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  if (low == 0)
+    return 0;
+
+  replay_goto(low - 1);
+  *found = player.frames[low - 1].generation;
+  return 1;
+}
+
+/**
+ * @brief Get the generations of the first and the last frame, return 0 if no
+ * recording is being replayed
+ */
+int replay_range(unsigned *first, unsigned *last) {
+  if (!player.active)
+    return 0;
+
+  *first = player.frames[0].generation;
+  *last = player.frames[player.frames_s - 1].generation;
+  return 1;
+}
+
+/**
+ * @brief Replay the recording with name
+ */
+void replay_load(char *name, int index) {
+  if (!replay_open(name))
+    err("Invalid recording %s", name);
+
+  replay_goto(0);
+  game(player.header.height, player.header.width, player.header.mode,
+       player.frames[0].generation);
+}
@@ -0,0 +1,679 @@
+/**
+ * @file search.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the headless search of random soups
+ *
+ * Search fills a small square of an unlimited game at random, a soup, and
+ * evolves it until it settles down into still lifes, oscillators and
+ * spaceships flying away, its ash. Objects of the ash are counted over many
+ * soups into a census, which is written as CSV or JSON.
+ *
+ * Each soup is generated from its own number, so any soup in the census can be
+ * reproduced. Soups are searched in batches on the thread pool of the library,
+ * each batch counting its objects into a census of its own, which is then
+ * merged into the total one. The game of a batch is cleared and reused for
+ * each of its soups, so the cells are allocated only once.
+ *
+ * A soup is considered settled when its population repeats with a period p of
+ * at most SEARCH_PERIOD generations for the last 4p generations, and at least
+ * SEARCH_WINDOW of them.
+ *
+ * Soups of the Normal game mode start on a board of BOARD_SIZE x BOARD_SIZE
+ * cells, one bit per cell, where 64 cells of a row are evolved at once with
+ * bitwise operations. Only the words next to living cells are evolved, as the
+ * first and last word with living cells is kept for each row.
+ * When a cell reaches the edge of the board, usually a glider flying away, the
+ * cells are moved into the game and the soup is evolved there from then on.
+ * Both give the same generations, so the census doesn't depend on the board.
+ *
+ * Ash is split into objects and classified by the library. Each object is
+ * identified by its canonical code, the same in every phase and orientation,
+ * and named after the known object it is, or after its kind when it's not
+ * known: xs and the number of cells for still lifes, xp and the period for
+ * oscillators, and xq and the period for spaceships.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gol.h"
+#include "search.h"
+#include "uthash.h"
+#include "utils.h"
+
+/// Number of soups searched by one task of the thread pool
+#define SEARCH_BATCH 64
+
+/// Longest period of the population that is detected
+#define SEARCH_PERIOD 30
+
+/// Least number of generations the population has to repeat for
+#define SEARCH_WINDOW 96
+
+/// Number of populations kept, power of two above five periods
+#define SEARCH_HISTORY 256
+
+/// Generations between the checks if the soup has settled
+#define SEARCH_CHECK 16
+
+/// Game mode evolved on the board, B3/S23
+#define BOARD_MODE 0
+
+/// Number of 64 bit words in a row of the board
+#define BOARD_WORDS 32
+
+/// Width and height of the board in cells
+#define BOARD_SIZE (BOARD_WORDS * 64)
+
+/// Number of cells moved from the board into the game at once
+#define BOARD_BATCH 256
+
+/**
+ * @brief Object of the census
+ */
+typedef struct object_T {
+  char          *code;   ///< cells of the object, see the file description
+  char          *name;   ///< name of the object, see the file description
+  int            cells;  ///< number of living cells
+  int            period; ///< period of the object, 0 if it's not known
+  unsigned long  count; ///< number of times the object was found
+  unsigned long  soup;  ///< first soup the object was found in
+  UT_hash_handle hh;
+} object_T;
+
+/**
+ * @brief Objects found in a number of soups
+ */
+typedef struct census_T {
+  object_T     *objects;     ///< objects by their code
+  unsigned long soups;       ///< number of soups searched
+  unsigned long unsettled;   ///< soups that didn't settle in time
+  uint64_t      generations; ///< generations evolved in total
+} census_T;
+
+/**
+ * @brief State of the search
+ */
+typedef struct search_T {
+  unsigned long   soups;   ///< number of soups
+  unsigned long   first;   ///< number of the first soup
+  int             size;    ///< size of the soup square
+  int             density; ///< percentage of living cells in the soup
+  int             mode;    ///< index of the game mode
+  int             gens;    ///< generations a soup has to settle in
+  int             threads; ///< number of threads
+  char           *output;  ///< name of the census file
+  pthread_mutex_t lock;    ///< guards census
+  census_T        census;  ///< objects found in all soups
+} search_T;
+
+/**
+ * @brief Board a soup is evolved on, see the file description
+ */
+typedef struct board_T {
+  uint64_t rows[2][BOARD_SIZE][BOARD_WORDS]; ///< current and next cells
+  int      left[2][BOARD_SIZE];  ///< first word with living cells of a row
+  int      right[2][BOARD_SIZE]; ///< last word with living cells of a row
+  int      top[2];               ///< first row with living cells
+  int      bottom[2];            ///< last row with living cells
+  int      current;              ///< index of the current cells
+  int      offset;               ///< row and column of the soup on the board
+  int      edge;                 ///< a living cell is on the edge of the board
+  uint32_t population;           ///< number of living cells
+} board_T;
+
+static search_T search;
+
+/**
+ * @brief Return the next number of the random number generator of a soup,
+ * splitmix64
+ */
+static uint64_t soup_rand(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return z ^ (z >> 31);
+}
+
+/**
+ * @brief Count the object into the census
+ */
+static void census_add(census_T *c, const char *code, const char *name,
+                       int cells, int period, unsigned long count,
+                       unsigned long soup) {
+  object_T *o;
+
+  HASH_FIND_STR(c->objects, code, o);
+  if (o == NULL) {
+    size_t len = strlen(code);
+
+    MEM_CHECK(o = calloc(1, sizeof(object_T)));
+    MEM_CHECK(o->code = malloc((len + 1) * sizeof(char)));
+    MEM_CHECK(o->name = malloc((strlen(name) + 1) * sizeof(char)));
+    strcpy(o->code, code);
+    strcpy(o->name, name);
+    o->cells = cells;
+    o->period = period;
+    o->soup = soup;
+    HASH_ADD_KEYPTR(hh, c->objects, o->code, len, o);
+  }
+
+  o->count += count;
+  o->soup = MIN(o->soup, soup);
+}
+
+/**
+ * @brief Add all objects and counts of src into dst, and free src
+ */
+static void census_merge(census_T *dst, census_T *src) {
+  object_T *o, *tmp;
+
+  HASH_ITER(hh, src->objects, o, tmp) {
+    census_add(dst, o->code, o->name, o->cells, o->period, o->count, o->soup);
+    HASH_DEL(src->objects, o);
+    free(o->code);
+    free(o->name);
+    free(o);
+  }
+
+  dst->soups += src->soups;
+  dst->unsettled += src->unsettled;
+  dst->generations += src->generations;
+}
+
+/**
+ * @brief Write the name of the object into a new string, the name of a known
+ * object or the kind of an unknown one, see the file description
+ */
+static char *object_name(const gol_object *o) {
+  char *name;
+
+  if (o->name != NULL) {
+    MEM_CHECK(name = malloc(strlen(o->name) + 1));
+    return strcpy(name, o->name);
+  }
+
+  MEM_CHECK(name = malloc(16 * sizeof(char)));
+  switch (o->kind) {
+  case GOL_STILL_LIFE:
+    snprintf(name, 16, "xs%d", o->cells);
+    break;
+  case GOL_OSCILLATOR:
+    snprintf(name, 16, "xp%d", o->period);
+    break;
+  case GOL_SPACESHIP:
+    snprintf(name, 16, "xq%d", o->period);
+    break;
+  default:
+    snprintf(name, 16, "unknown");
+  }
+  return name;
+}
+
+/**
+ * @brief Split the living cells of the game into objects, classify them and
+ * count them into the census
+ */
+static void census_ash(census_T *census, gol_universe *u, unsigned long soup) {
+  gol_object *objects;
+  size_t      size = gol_classify(u, SEARCH_PERIOD, &objects);
+
+  for (size_t i = 0; i < size; i++) {
+    char *name = object_name(&objects[i]);
+    census_add(census, objects[i].code, name, objects[i].cells,
+               objects[i].period, 1, soup);
+    free(name);
+  }
+
+  gol_objects_free(objects, size);
+}
+
+/**
+ * @brief Create an empty board
+ */
+static board_T *board_create(void) {
+  board_T *b;
+
+  MEM_CHECK(b = calloc(1, sizeof(board_T)));
+  for (int i = 0; i < 2; i++) {
+    for (int r = 0; r < BOARD_SIZE; r++) {
+      b->left[i][r] = BOARD_WORDS;
+      b->right[i][r] = -1;
+    }
+    b->top[i] = BOARD_SIZE;
+    b->bottom[i] = -1;
+  }
+
+  return b;
+}
+
+/**
+ * @brief Clear the row r of the cells with index i
+ */
+static void board_clear(board_T *b, int i, int r) {
+  for (int w = b->left[i][r]; w <= b->right[i][r]; w++)
+    b->rows[i][r][w] = 0;
+
+  b->left[i][r] = BOARD_WORDS;
+  b->right[i][r] = -1;
+}
+
+/**
+ * @brief Check if the current cells have reached the edge of the board, where
+ * they can't be evolved any more
+ */
+static int board_edge(const board_T *b) {
+  const int c = b->current;
+
+  // a new row is evolved from the row past it, which has to be on the board
+  if (b->top[c] <= 1 || b->bottom[c] >= BOARD_SIZE - 2)
+    return 1;
+
+  for (int r = b->top[c]; r <= b->bottom[c]; r++)
+    if ((b->rows[c][r][0] & 1) || (b->rows[c][r][BOARD_WORDS - 1] >> 63))
+      return 1;
+
+  return 0;
+}
+
+/**
+ * @brief Place the cells of the soup in the middle of an empty board
+ */
+static void board_fill(board_T *b, const gol_cell *cells, int size) {
+  const int c = b->current;
+
+  for (int i = 0; i < 2; i++) {
+    for (int r = b->top[i]; r <= b->bottom[i]; r++)
+      board_clear(b, i, r);
+    b->top[i] = BOARD_SIZE;
+    b->bottom[i] = -1;
+  }
+
+  b->offset = (BOARD_SIZE - search.size) / 2;
+  b->population = size;
+
+  for (int i = 0; i < size; i++) {
+    int row = cells[i].row + b->offset, col = cells[i].col + b->offset;
+
+    b->rows[c][row][col / 64] |= (uint64_t)1 << (col % 64);
+    b->left[c][row] = MIN(b->left[c][row], col / 64);
+    b->right[c][row] = MAX(b->right[c][row], col / 64);
+    b->top[c] = MIN(b->top[c], row);
+    b->bottom[c] = MAX(b->bottom[c], row);
+  }
+
+  b->edge = size && board_edge(b);
+}
+
+/**
+ * @brief Evolve the board one generation, valid only if no living cell is on
+ * its edge
+ *
+ * Each column of three rows is summed into two bits first, and the sums of
+ * three neighbouring columns then into the number of living cells in the
+ * block of nine. A cell lives if there are 3 of them, or 4 if it's alive.
+ */
+static void board_step(board_T *b) {
+  const int c = b->current, n = !c;
+  uint64_t(*src)[BOARD_WORDS] = b->rows[c], (*dst)[BOARD_WORDS] = b->rows[n];
+  int r0 = b->top[c] - 1, r1 = b->bottom[c] + 1;
+
+  for (int r = b->top[n]; r <= b->bottom[n]; r++)
+    if (r < r0 || r > r1)
+      board_clear(b, n, r);
+
+  b->top[n] = BOARD_SIZE;
+  b->bottom[n] = -1;
+  b->population = 0;
+
+  for (int r = r0; r <= r1; r++) {
+    // sums of the columns with a word of padding on both sides
+    uint64_t low[BOARD_WORDS + 2], high[BOARD_WORDS + 2];
+    int      w0 = MIN(MIN(b->left[c][r - 1], b->left[c][r]), b->left[c][r + 1]);
+    int      w1 = MAX(MAX(b->right[c][r - 1], b->right[c][r]),
+                      b->right[c][r + 1]);
+
+    board_clear(b, n, r);
+    if (w0 > w1)
+      continue;
+
+    w0 = MAX(w0 - 1, 0);
+    w1 = MIN(w1 + 1, BOARD_WORDS - 1);
+
+    low[w0] = high[w0] = low[w1 + 2] = high[w1 + 2] = 0;
+    for (int w = w0; w <= w1; w++) {
+      uint64_t up = src[r - 1][w], mid = src[r][w], down = src[r + 1][w];
+
+      low[w + 1] = up ^ mid ^ down;
+      high[w + 1] = (up & mid) | (down & (up ^ mid));
+    }
+
+    for (int w = w0; w <= w1; w++) {
+      uint64_t ll = low[w + 1] << 1 | low[w] >> 63;
+      uint64_t lr = low[w + 1] >> 1 | low[w + 2] << 63;
+      uint64_t hl = high[w + 1] << 1 | high[w] >> 63;
+      uint64_t hr = high[w + 1] >> 1 | high[w + 2] << 63;
+      uint64_t lc = low[w + 1], hc = high[w + 1];
+
+      // ones of the sum, and the number of twos from the highs and the carry
+      uint64_t ones = ll ^ lc ^ lr, carry = (ll & lc) | (lr & (ll ^ lc));
+      uint64_t t0 = hl ^ hc ^ hr, t1 = (hl & hc) | (hr & (hl ^ hc));
+      uint64_t one = ~t1 & (t0 ^ carry), two = (t0 ^ t1) & (t1 ^ carry);
+      uint64_t next = (ones & one) | (~ones & two & src[r][w]);
+
+      if (!next)
+        continue;
+
+      dst[r][w] = next;
+      b->population += __builtin_popcountll(next);
+      b->left[n][r] = MIN(b->left[n][r], w);
+      b->right[n][r] = w;
+    }
+
+    if (b->left[n][r] < BOARD_WORDS) {
+      b->top[n] = MIN(b->top[n], r);
+      b->bottom[n] = r;
+    }
+  }
+
+  b->current = n;
+  b->edge = b->population && board_edge(b);
+}
+
+/**
+ * @brief Insert the living cells of the board into the game, at the same
+ * place as if the soup was evolved in the game
+ */
+static void board_insert(board_T *b, gol_universe *u) {
+  const int c = b->current;
+  gol_cell  cells[BOARD_BATCH];
+  int       size = 0;
+
+  for (int r = b->top[c]; r <= b->bottom[c]; r++)
+    for (int w = b->left[c][r]; w <= b->right[c][r]; w++)
+      for (uint64_t bits = b->rows[c][r][w]; bits; bits &= bits - 1) {
+        int col = w * 64 + __builtin_ctzll(bits);
+
+        cells[size++] = (gol_cell){r - b->offset, col - b->offset, 1};
+        if (size == BOARD_BATCH) {
+          gol_insert(u, cells, size);
+          size = 0;
+        }
+      }
+
+  gol_insert(u, cells, size);
+}
+
+/**
+ * @brief Check if the population up to generation gen repeats with a period
+ * of at most SEARCH_PERIOD, see the file description
+ */
+static int soup_settled(const uint32_t *pop, int gen) {
+  for (int p = 1; p <= SEARCH_PERIOD && 5 * p <= gen; p++) {
+    int window = MAX(4 * p, SEARCH_WINDOW), k = 0;
+
+    while (k < window && pop[(gen - k) & (SEARCH_HISTORY - 1)] ==
+                             pop[(gen - k - p) & (SEARCH_HISTORY - 1)])
+      k++;
+
+    if (k == window)
+      return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Fill the game with the soup number soup, evolve it until it settles
+ * and count its ash into the census. The soup starts on the board if there is
+ * one
+ */
+static void search_soup(census_T *census, gol_universe *u, board_T *board,
+                        gol_cell *cells, unsigned long soup) {
+  uint32_t pop[SEARCH_HISTORY];
+  uint64_t state = soup;
+  int      states = gol_mode_states(search.mode), size = 0, gen;
+
+  for (int i = 0; i < search.size; i++)
+    for (int j = 0; j < search.size; j++) {
+      uint64_t r = soup_rand(&state);
+      if (r % 100 < (uint64_t)search.density)
+        cells[size++] = (gol_cell){i, j, 1 + (r >> 32) % (states - 1)};
+    }
+
+  gol_clear(u);
+  gol_seed(u, soup);
+  if (board)
+    board_fill(board, cells, size);
+  else
+    gol_insert(u, cells, size);
+
+  for (gen = 0; gen < search.gens; gen++) {
+    pop[gen & (SEARCH_HISTORY - 1)] = board ? board->population
+                                            : gol_population(u);
+
+    if (!pop[gen & (SEARCH_HISTORY - 1)])
+      break;
+
+    if (gen % SEARCH_CHECK == 0 && gen >= 2 * SEARCH_WINDOW &&
+        soup_settled(pop, gen))
+      break;
+
+    if (board && board->edge) {
+      board_insert(board, u);
+      board = NULL;
+    }
+
+    if (board)
+      board_step(board);
+    else
+      gol_evolve(u, 1);
+  }
+
+  if (board)
+    board_insert(board, u);
+
+  census->soups++;
+  census->generations += gen;
+
+  if (gen == search.gens) {
+    census->unsettled++;
+    return;
+  }
+
+  census_ash(census, u, soup);
+}
+
+/**
+ * @brief Search one batch of soups, run on the thread pool
+ */
+static void search_batch(size_t index, void *arg) {
+  unsigned long first = search.first + index * SEARCH_BATCH;
+  unsigned long last = MIN(first + SEARCH_BATCH, search.first + search.soups);
+  census_T      census = {0};
+  gol_universe *u = gol_create(0, 0, search.mode);
+  board_T      *board = NULL;
+  gol_cell     *cells;
+
+  MEM_CHECK(cells = malloc(search.size * search.size * sizeof(gol_cell)));
+  if (search.mode == BOARD_MODE && search.size <= BOARD_SIZE / 2)
+    board = board_create();
+
+  for (unsigned long soup = first; soup < last; soup++)
+    search_soup(&census, u, board, cells, soup);
+
+  free(board);
+  free(cells);
+  gol_destroy(u);
+
+  pthread_mutex_lock(&search.lock);
+  census_merge(&search.census, &census);
+  pthread_mutex_unlock(&search.lock);
+}
+
+/**
+ * @brief Order objects by count, most common first, and then by code
+ */
+static int object_cmp(const void *a, const void *b) {
+  const object_T *x = *(object_T **)a, *y = *(object_T **)b;
+
+  if (x->count != y->count)
+    return x->count > y->count ? -1 : 1;
+  return strcmp(x->code, y->code);
+}
+
+/**
+ * @brief Write the census, as JSON if the name ends with .json and as CSV
+ * otherwise
+ */
+static void search_write(const char *name) {
+  census_T   *c = &search.census;
+  size_t      n = HASH_COUNT(c->objects), i = 0;
+  const char *dot = strrchr(name, '.');
+  int         json = dot != NULL && !strcmp(dot, ".json");
+  object_T  **sorted, *o;
+  FILE       *f;
+
+  if ((f = fopen(name, "w")) == NULL)
+    err("Can't write %s\n", name);
+
+  MEM_CHECK(sorted = malloc((n + 1) * sizeof(object_T *)));
+  for (o = c->objects; o != NULL; o = o->hh.next)
+    sorted[i++] = o;
+  qsort(sorted, n, sizeof(object_T *), object_cmp);
+
+  if (json) {
+    fprintf(f,
+            "{\n  \"mode\": \"%s\",\n  \"size\": %d,\n  \"density\": %d,\n"
+            "  \"first\": %lu,\n  \"soups\": %lu,\n  \"unsettled\": %lu,\n"
+            "  \"objects\": [",
+            gol_mode_name(search.mode), search.size, search.density,
+            search.first, c->soups, c->unsettled);
+    for (i = 0; i < n; i++)
+      fprintf(f,
+              "%s\n    {\"name\": \"%s\", \"object\": \"%s\", "
+              "\"cells\": %d, \"period\": %d, \"count\": %lu, "
+              "\"soup\": %lu}",
+              i ? "," : "", sorted[i]->name, sorted[i]->code,
+              sorted[i]->cells, sorted[i]->period, sorted[i]->count,
+              sorted[i]->soup);
+    fprintf(f, "\n  ]\n}\n");
+  } else {
+    fprintf(f, "name,object,cells,period,count,soup\n");
+    for (i = 0; i < n; i++)
+      fprintf(f, "%s,%s,%d,%d,%lu,%lu\n", sorted[i]->name, sorted[i]->code,
+              sorted[i]->cells, sorted[i]->period, sorted[i]->count,
+              sorted[i]->soup);
+  }
+
+  free(sorted);
+  fclose(f);
+}
+
+/**
+ * @brief Print the usage of the search
+ */
+static void search_usage(char *name) {
+  fprintf(stderr,
+          "Usage: %s search [options]\n"
+          "Search random soups and write the census of their ash\n\n"
+          "  -n soups       number of soups (default: 10000)\n"
+          "  -s soup        number of the first soup (default: 0)\n"
+          "  -z size        size of the soup square (default: 16)\n"
+          "  -d density     percentage of living cells (default: 50)\n"
+          "  -m mode        index of the game mode (default: 0)\n"
+          "  -g gens        generations a soup has to settle in "
+          "(default: 20000)\n"
+          "  -j jobs        number of threads (default: processors)\n"
+          "  -o file        census file, .csv or .json "
+          "(default: census.csv)\n",
+          name);
+  exit(1);
+}
+
+/**
+ * @brief Run the soup search from the command line
+ *
+ * The arguments are the ones of the program, with the subcommand as the first
+ * one, so that the usage shows the name of the program.
+ */
+int search_main(int argc, char *argv[]) {
+  struct timespec start, end;
+  census_T       *c = &search.census;
+  object_T       *o, *tmp;
+  double          secs;
+  int             opt;
+
+  search.soups = 10000;
+  search.size = 16;
+  search.density = 50;
+  search.gens = 20000;
+  search.output = "census.csv";
+
+  optind = 2;
+  while ((opt = getopt(argc, argv, "n:s:z:d:m:g:j:o:h")) != -1) {
+    switch (opt) {
+    case 'n':
+      search.soups = strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      search.first = strtoul(optarg, NULL, 10);
+      break;
+    case 'z':
+      search.size = atoi(optarg);
+      break;
+    case 'd':
+      search.density = atoi(optarg);
+      break;
+    case 'm':
+      search.mode = atoi(optarg);
+      break;
+    case 'g':
+      search.gens = atoi(optarg);
+      break;
+    case 'j':
+      search.threads = atoi(optarg);
+      break;
+    case 'o':
+      search.output = optarg;
+      break;
+    default:
+      search_usage(argv[0]);
+    }
+  }
+
+  if (optind != argc || !search.soups || search.size < 1 ||
+      search.density < 0 || search.density > 100 || search.gens < 1 ||
+      search.threads < 0 || gol_mode_name(search.mode) == NULL)
+    search_usage(argv[0]);
+
+  pthread_mutex_init(&search.lock, NULL);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  gol_parallel((search.soups + SEARCH_BATCH - 1) / SEARCH_BATCH,
+               search.threads, search_batch, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  search_write(search.output);
+
+  secs = end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("Searched %lu soups in %.1fs, %.0f soups per second, "
+         "%lu objects, %lu did not settle\n",
+         c->soups, secs, c->soups / secs, (unsigned long)HASH_COUNT(c->objects),
+         c->unsettled);
+
+  HASH_ITER(hh, c->objects, o, tmp) {
+    HASH_DEL(c->objects, o);
+    free(o->code);
+    free(o->name);
+    free(o);
+  }
+  pthread_mutex_destroy(&search.lock);
+  return 0;
+}
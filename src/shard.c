@@ -0,0 +1,592 @@
+/**
+ * @file shard.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the headless simulation of a game sharded over
+ * processes
+ *
+ * A wrapping game is split into bands of rows, and each band is evolved by a
+ * process of its own, a shard, in a universe of the library that holds only
+ * the cells of its band. Before each generation a shard sends its first and
+ * last row to the shards above and below it, and receives their last and
+ * first row in return, the ghost rows. Ghost rows are inserted next to the
+ * band, the universe is evolved, and the two rows above and below the band
+ * are cleared again, so the band evolves the same as it would in the whole
+ * game.
+ *
+ * Rows are exchanged through single producer single consumer queues in a
+ * POSIX shared memory segment, each holding up to SHARD_SLOTS rows of one
+ * cell per byte, so a shard can run a few generations ahead of its
+ * neighbours. Queues are lock free, with their head and tail on cache lines
+ * of their own, and waiting on them only yields the processor.
+ *
+ * The coordinator, the process that started the shards, sets the generation
+ * they evolve to. When they reach it, each of them counts its living cells and
+ * copies its rows of the viewport into the segment, and the coordinator sums
+ * the population, prints the viewport and sets the next generation.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "file.h"
+#include "gol.h"
+#include "shard.h"
+#include "utils.h"
+
+/// Number of rows a queue holds
+#define SHARD_SLOTS 4
+
+/// Least number of rows of a band, so the cleared rows stay outside of it
+#define SHARD_ROWS 4
+
+/// Largest number of cells of the viewport
+#define SHARD_VIEW (1 << 26)
+
+/// Alignment of the parts of the segment, the size of a cache line
+#define SHARD_LINE 64
+
+#ifndef _WIN32
+
+/**
+ * @brief Queue of rows sent from one shard to another
+ */
+typedef struct ring_T {
+  _Alignas(SHARD_LINE) atomic_uint_fast64_t head; ///< rows received
+  _Alignas(SHARD_LINE) atomic_uint_fast64_t tail; ///< rows sent
+  _Alignas(SHARD_LINE) unsigned char rows[];      ///< SHARD_SLOTS rows
+} ring_T;
+
+/**
+ * @brief State of a shard shared with the coordinator
+ */
+typedef struct shard_T {
+  _Alignas(SHARD_LINE) atomic_uint_fast64_t generation; ///< reached generation
+  uint64_t   population; ///< living cells of the band at the generation
+  gol_memory memory;     ///< memory used by the band at the generation
+  int64_t    row;        ///< first row of the band
+  int64_t    height;     ///< number of rows of the band
+} shard_T;
+
+/**
+ * @brief Header of the shared memory segment, followed by the shards and the
+ * queues, two of each shard, and the viewport
+ */
+typedef struct header_T {
+  _Alignas(SHARD_LINE) atomic_uint_fast64_t target; ///< generation to evolve to
+  atomic_int stop; ///< set when the shards should exit
+} header_T;
+
+/**
+ * @brief Settings and the mapping of the segment, the same in all processes
+ */
+static struct {
+  int            height, width, mode, shards, gens, interval, print;
+  int            view_row, view_col, view_height, view_width;
+  char          *output;
+  size_t         ring_size, size;
+  void          *segment;
+  pid_t         *pids;
+  header_T      *header;
+  shard_T       *shard;
+  unsigned char *view;
+  unsigned char *row;
+} shard;
+
+/**
+ * @brief Round the size up to a multiple of SHARD_LINE
+ */
+static size_t align(size_t size) {
+  return (size + SHARD_LINE - 1) / SHARD_LINE * SHARD_LINE;
+}
+
+/**
+ * @brief Get the queue of the shard, 0 for the rows it sends up and 1 for the
+ * ones it sends down
+ */
+static ring_T *ring(int index, int down) {
+  char *rings = (char *)(shard.shard + shard.shards);
+
+  index = (index + shard.shards) % shard.shards;
+  return (ring_T *)(rings + (2 * index + down) * shard.ring_size);
+}
+
+/**
+ * @brief Wait for the other processes, exit if the coordinator has stopped
+ */
+static void shard_yield(void) {
+  if (atomic_load_explicit(&shard.header->stop, memory_order_relaxed))
+    _exit(1);
+  sched_yield();
+}
+
+/**
+ * @brief Send the row to the queue, waiting while it's full
+ */
+static void ring_push(ring_T *r, const unsigned char *row) {
+  uint_fast64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+  while (tail - atomic_load_explicit(&r->head, memory_order_acquire) ==
+         SHARD_SLOTS)
+    shard_yield();
+
+  memcpy(r->rows + tail % SHARD_SLOTS * shard.width, row, shard.width);
+  atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
+
+/**
+ * @brief Receive the next row from the queue, waiting while it's empty
+ */
+static void ring_pop(ring_T *r, unsigned char *row) {
+  uint_fast64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+  while (atomic_load_explicit(&r->tail, memory_order_acquire) == head)
+    shard_yield();
+
+  memcpy(row, r->rows + head % SHARD_SLOTS * shard.width, shard.width);
+  atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief Copy the row of the universe into the buffer, a byte per cell
+ */
+static void row_get(gol_universe *u, int64_t row, unsigned char *buffer) {
+  gol_cell *cells;
+  size_t    size = gol_query(u, row, 0, 1, shard.width, &cells);
+
+  memset(buffer, 0, shard.width);
+  for (size_t i = 0; i < size; i++)
+    buffer[cells[i].col] = cells[i].val;
+  free(cells);
+}
+
+/**
+ * @brief Insert the living cells of the buffer into the row of the universe
+ */
+static void row_put(gol_universe *u, int64_t row, const unsigned char *buffer) {
+  gol_cell *cells;
+  size_t    size = 0;
+
+  MEM_CHECK(cells = malloc(shard.width * sizeof(gol_cell)));
+  for (int i = 0; i < shard.width; i++)
+    if (buffer[i])
+      cells[size++] = (gol_cell){row, i, buffer[i]};
+
+  gol_insert(u, cells, size);
+  free(cells);
+}
+
+/**
+ * @brief Kill the cells in height rows of the universe starting at row
+ */
+static void rows_clear(gol_universe *u, int64_t row, int64_t height) {
+  gol_cell *cells;
+  size_t    size = gol_query(u, row, 0, height, shard.width, &cells);
+
+  for (size_t i = 0; i < size; i++) {
+    cells[i].row += row;
+    cells[i].val = 0;
+  }
+
+  gol_insert(u, cells, size);
+  free(cells);
+}
+
+/**
+ * @brief Evolve the band of the shard by one generation, exchanging the ghost
+ * rows with its neighbours
+ */
+static void shard_step(gol_universe *u, int index) {
+  const shard_T *s = &shard.shard[index];
+
+  if (shard.shards > 1) {
+    row_get(u, s->row, shard.row);
+    ring_push(ring(index, 0), shard.row);
+    row_get(u, s->row + s->height - 1, shard.row);
+    ring_push(ring(index, 1), shard.row);
+
+    ring_pop(ring(index - 1, 1), shard.row);
+    row_put(u, s->row - 1, shard.row);
+    ring_pop(ring(index + 1, 0), shard.row);
+    row_put(u, s->row + s->height, shard.row);
+  }
+
+  gol_evolve(u, 1);
+
+  if (shard.shards > 1) {
+    rows_clear(u, s->row - 2, 2);
+    rows_clear(u, s->row + s->height, 2);
+  }
+}
+
+/**
+ * @brief Count the living cells and the memory of the band and copy its rows
+ * of the viewport into the segment, then publish the generation to the
+ * coordinator
+ */
+static void shard_publish(gol_universe *u, int index, uint64_t generation) {
+  shard_T  *s = &shard.shard[index];
+  gol_cell *cells;
+  int64_t   first = MAX(s->row, shard.view_row);
+  int64_t   last = MIN(s->row + s->height, shard.view_row + shard.view_height);
+
+  s->population = gol_query(u, s->row, 0, s->height, shard.width, &cells);
+  free(cells);
+  gol_memory_usage(u, &s->memory);
+
+  if (first < last) {
+    size_t size = gol_query(u, first, shard.view_col, last - first,
+                            shard.view_width, &cells);
+    int64_t offset = first - shard.view_row;
+
+    memset(shard.view + offset * shard.view_width, 0,
+           (last - first) * shard.view_width);
+    for (size_t i = 0; i < size; i++)
+      shard.view[(offset + cells[i].row) * shard.view_width + cells[i].col] =
+          cells[i].val;
+    free(cells);
+  }
+
+  atomic_store_explicit(&s->generation, generation, memory_order_release);
+}
+
+/**
+ * @brief Run the shard in the forked process, starting from the band of the
+ * whole game
+ */
+static void shard_run(gol_universe *game, int index) {
+  const shard_T *s = &shard.shard[index];
+  gol_universe  *u = gol_create(shard.height, shard.width, shard.mode);
+  gol_cell      *cells;
+  size_t         size = gol_query(game, s->row, 0, s->height, shard.width,
+                                  &cells);
+  uint64_t       generation = 0;
+
+  for (size_t i = 0; i < size; i++)
+    cells[i].row += s->row;
+
+  gol_seed(u, time(NULL) + index);
+  gol_insert(u, cells, size);
+  free(cells);
+  gol_destroy(game);
+
+  MEM_CHECK(shard.row = malloc(shard.width));
+  while (1) {
+    uint64_t target =
+        atomic_load_explicit(&shard.header->target, memory_order_acquire);
+
+    if (generation < target) {
+      shard_step(u, index);
+      if (++generation == target)
+        shard_publish(u, index, generation);
+      continue;
+    }
+
+    if (atomic_load_explicit(&shard.header->stop, memory_order_relaxed))
+      break;
+    sched_yield();
+  }
+
+  free(shard.row);
+  gol_destroy(u);
+  _exit(0);
+}
+
+/**
+ * @brief Stop the shards and remove them
+ */
+static void shard_stop(int kill_them) {
+  atomic_store(&shard.header->stop, 1);
+  for (int i = 0; i < shard.shards; i++) {
+    if (kill_them)
+      kill(shard.pids[i], SIGKILL);
+    waitpid(shard.pids[i], NULL, 0);
+  }
+}
+
+/**
+ * @brief Wait for all shards to reach the generation, abort if any of them
+ * has exited
+ */
+static void shard_wait(uint64_t generation) {
+  for (int i = 0; i < shard.shards; i++)
+    while (atomic_load_explicit(&shard.shard[i].generation,
+                                memory_order_acquire) != generation) {
+      if (waitpid(-1, NULL, WNOHANG) > 0) {
+        shard_stop(1);
+        err("Shard exited unexpectedly\n");
+      }
+      sched_yield();
+    }
+}
+
+/**
+ * @brief Create the shared memory segment and split the game into bands
+ */
+static void shard_map(void) {
+  char   name[64];
+  size_t view = (size_t)shard.view_height * shard.view_width;
+  int    fd;
+
+  shard.ring_size = align(sizeof(ring_T) + SHARD_SLOTS * shard.width);
+  shard.size = align(sizeof(header_T)) + shard.shards * sizeof(shard_T) +
+               2 * shard.shards * shard.ring_size + view;
+
+  snprintf(name, sizeof(name), "/gol-shard-%ld", (long)getpid());
+  if ((fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600)) < 0)
+    err("Can't create the shared memory %s\n", name);
+
+  // the segment stays mapped in all processes after its name is removed
+  shm_unlink(name);
+  if (ftruncate(fd, shard.size) < 0 ||
+      (shard.segment = mmap(NULL, shard.size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0)) == MAP_FAILED)
+    err("Can't map %lu bytes of shared memory\n", (unsigned long)shard.size);
+  close(fd);
+
+  shard.header = shard.segment;
+  shard.shard = (shard_T *)((char *)shard.segment + align(sizeof(header_T)));
+  shard.view = (unsigned char *)ring(0, 0) + 2 * shard.shards * shard.ring_size;
+
+  for (int i = 0; i < shard.shards; i++) {
+    shard.shard[i].row = (int64_t)shard.height * i / shard.shards;
+    shard.shard[i].height =
+        (int64_t)shard.height * (i + 1) / shard.shards - shard.shard[i].row;
+  }
+}
+
+/**
+ * @brief Print the viewport, one character per cell
+ */
+static void shard_print(void) {
+  for (int i = 0; i < shard.view_height; i++) {
+    const unsigned char *row = shard.view + (size_t)i * shard.view_width;
+
+    for (int j = 0; j < shard.view_width; j++)
+      putchar(!row[j] ? '.' : row[j] == 1 ? 'O' : 'A' + row[j] - 1);
+    putchar('\n');
+  }
+}
+
+/**
+ * @brief Save the viewport as a pattern, in the format of the file extension
+ */
+static void shard_save(void) {
+  gol_universe *u = gol_create(0, 0, shard.mode);
+  gol_cell     *cells;
+  size_t        size = 0;
+
+  MEM_CHECK(cells = malloc(((size_t)shard.view_height * shard.view_width + 1) *
+                           sizeof(gol_cell)));
+  for (int i = 0; i < shard.view_height; i++)
+    for (int j = 0; j < shard.view_width; j++) {
+      unsigned char val = shard.view[(size_t)i * shard.view_width + j];
+
+      if (val)
+        cells[size++] = (gol_cell){i, j, val};
+    }
+
+  gol_insert(u, cells, size);
+  free(cells);
+
+  if (!gol_save(u, shard.output))
+    err("Can't write %s\n", shard.output);
+  gol_destroy(u);
+}
+
+/**
+ * @brief Create the wrapping game from the pattern, the game mode is taken
+ * from the pattern unless it is set
+ */
+static gol_universe *shard_load(char *name) {
+  gol_universe *u;
+  cells_T       cells = {0};
+  int           file_mode = file_read(name, &cells);
+
+  if (file_mode < 0 && !cells.size)
+    err("Can't read pattern %s\n", name);
+
+  if (shard.mode < 0)
+    shard.mode = file_mode < 0 ? 0 : file_mode;
+
+  if ((u = gol_create(shard.height, shard.width, shard.mode)) == NULL)
+    err("Invalid game mode %d\n", shard.mode);
+
+  gol_insert(u, cells.cells, cells.size);
+  cells_free(&cells);
+  return u;
+}
+
+#endif // _WIN32
+
+/**
+ * @brief Print the usage of the sharded simulation
+ */
+static void shard_usage(char *name) {
+  fprintf(stderr,
+          "Usage: %s shard [options] pattern\n"
+          "Evolve the wrapping game in bands of rows, one process each\n\n"
+          "  -n processes   number of processes (default: processors)\n"
+          "  -s HxW         size of the game (required)\n"
+          "  -m mode        index of the game mode (default: from pattern)\n"
+          "  -g gens        number of generations (default: 1000)\n"
+          "  -i gens        generations between reports (default: all)\n"
+          "  -r Y,X,HxW     viewport printed with each report\n"
+          "  -o file        save the viewport after the last generation, the\n"
+          "                 whole game if it's not set\n",
+          name);
+  exit(1);
+}
+
+/**
+ * @brief Run the sharded simulation from the command line
+ *
+ * The arguments are the ones of the program, with the subcommand as the first
+ * one, so that the usage shows the name of the program.
+ */
+int shard_main(int argc, char *argv[]) {
+#ifdef _WIN32
+  err("Sharded simulation is not supported on this system\n");
+  return 1;
+#else
+  struct timespec start, end;
+  gol_universe   *game;
+  gol_memory      memory = {0};
+  uint64_t        done = 0, population = 0;
+  double          secs;
+  int             opt;
+
+  shard.shards = gol_threads();
+  shard.mode = -1;
+  shard.gens = 1000;
+
+  optind = 2;
+  while ((opt = getopt(argc, argv, "n:s:m:g:i:r:o:h")) != -1) {
+    switch (opt) {
+    case 'n':
+      shard.shards = atoi(optarg);
+      break;
+    case 's':
+      if (sscanf(optarg, "%dx%d", &shard.height, &shard.width) != 2)
+        shard_usage(argv[0]);
+      break;
+    case 'm':
+      shard.mode = atoi(optarg);
+      break;
+    case 'g':
+      shard.gens = atoi(optarg);
+      break;
+    case 'i':
+      shard.interval = atoi(optarg);
+      break;
+    case 'r':
+      if (sscanf(optarg, "%d,%d,%dx%d", &shard.view_row, &shard.view_col,
+                 &shard.view_height, &shard.view_width) != 4)
+        shard_usage(argv[0]);
+      shard.print = 1;
+      break;
+    case 'o':
+      shard.output = optarg;
+      break;
+    default:
+      shard_usage(argv[0]);
+    }
+  }
+
+  if (optind != argc - 1 || shard.shards < 1 || shard.height < 1 ||
+      shard.width < 1 || shard.gens < 1 || shard.interval < 0)
+    shard_usage(argv[0]);
+
+  if (shard.shards > 1 && shard.height < SHARD_ROWS * shard.shards)
+    err("Game of %d rows can't be split into %d bands of %d rows\n",
+        shard.height, shard.shards, SHARD_ROWS);
+
+  if (!shard.print && shard.output) {
+    shard.view_height = shard.height;
+    shard.view_width = shard.width;
+  }
+
+  if (shard.view_row < 0 || shard.view_col < 0 || shard.view_height < 0 ||
+      shard.view_width < 0 ||
+      shard.view_row + shard.view_height > shard.height ||
+      shard.view_col + shard.view_width > shard.width ||
+      (double)shard.view_height * shard.view_width > SHARD_VIEW)
+    err("Invalid viewport %dx%d\n", shard.view_height, shard.view_width);
+
+  if (!shard.interval || shard.interval > shard.gens)
+    shard.interval = shard.gens;
+
+  game = shard_load(argv[optind]);
+  shard_map();
+
+  MEM_CHECK(shard.pids = malloc(shard.shards * sizeof(pid_t)));
+  fflush(stdout);
+  for (int i = 0; i < shard.shards; i++) {
+    if ((shard.pids[i] = fork()) < 0) {
+      shard.shards = i;
+      shard_stop(1);
+      err("Can't start the shard processes\n");
+    }
+    if (!shard.pids[i])
+      shard_run(game, i);
+  }
+  gol_destroy(game);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while (done < (uint64_t)shard.gens) {
+    population = 0;
+    done = MIN(done + shard.interval, (uint64_t)shard.gens);
+    atomic_store_explicit(&shard.header->target, done, memory_order_release);
+    shard_wait(done);
+
+    for (int i = 0; i < shard.shards; i++)
+      population += shard.shard[i].population;
+
+    printf("Generation %lu: population %lu\n", (unsigned long)done,
+           (unsigned long)population);
+    if (shard.print)
+      shard_print();
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  shard_stop(0);
+
+  if (shard.output)
+    shard_save();
+
+  for (int i = 0; i < shard.shards; i++) {
+    memory.cells += shard.shard[i].memory.cells;
+    memory.index += shard.shard[i].memory.index;
+    memory.history += shard.shard[i].memory.history;
+    memory.cache += shard.shard[i].memory.cache;
+    memory.total += shard.shard[i].memory.total;
+  }
+
+  secs = end.tv_sec - start.tv_sec + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("Evolved %d generations of %dx%d in %d processes in %.2fs, "
+         "%.0f generations per second\n",
+         shard.gens, shard.height, shard.width, shard.shards, secs,
+         shard.gens / secs);
+  printf("Memory: %lu bytes, %.1f per living cell (cells %lu, index %lu, "
+         "history %lu, cache %lu)\n",
+         (unsigned long)memory.total,
+         population ? (double)memory.total / population : 0.0,
+         (unsigned long)memory.cells, (unsigned long)memory.index,
+         (unsigned long)memory.history, (unsigned long)memory.cache);
+
+  free(shard.pids);
+  munmap(shard.segment, shard.size);
+  return 0;
+#endif
+}
@@ -0,0 +1,599 @@
+/**
+ * @file snapshot.c
+ * @author Dimitrije Dobrota
+ * @date 19 October 2026
+ * @brief This file contains the binary snapshot format
+ *
+ * A snapshot stores the whole game in a compact binary file: a fixed header
+ * with the game size, mode, generation and seed, followed by the cells in one
+ * of two encodings. Sparse games are stored as the distances between
+ * consecutive living cells encoded as variable length integers, while dense
+ * games are stored as a bitmap of their bounding box with two bits per cell.
+ * The encoding that results in a smaller file is chosen when saving. Bounding
+ * boxes too large for the row-major position of a cell to fit in 64 bits store
+ * each cell as the distance in rows from the previous one and its column.
+ *
+ * Snapshots are loaded by mapping the file into memory, cells are decoded
+ * straight from the mapping into a buffer sized from the header, without
+ * parsing or copying the file.
+ * Multi-byte fields are stored in the byte order of the machine.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "format.h"
+#include "logic.h"
+#include "snapshot.h"
+#include "utils.h"
+
+/// Magic bytes at the start of every snapshot
+#define SNAPSHOT_MAGIC "GOLB"
+
+/// Version of the snapshot format
+#define SNAPSHOT_VERSION 2
+
+/// Cells are stored as variable length distances between them
+#define ENCODING_DELTA 0
+
+/// Cells are stored as a bitmap of the bounding box, two bits per cell
+#define ENCODING_BITMAP 1
+
+/// Cells are stored as the distance in rows from the previous one and column
+#define ENCODING_ROWS 2
+
+/// Value of each cell is stored after its distance
+#define FLAG_VALUES 1
+
+/// Number of encoded bytes written to the file at once
+#define WRITE_CHUNK (1 << 20)
+
+/// Number of bits in one digit of the radix sort of the cells
+#define RADIX_BITS 16
+
+/// Number of bits in one digit of the radix sort of the keys
+#define KEY_BITS 11
+
+/// Number of low bits of a key that hold the value of the cell
+#define KEY_VALUE 8
+
+/**
+ * @brief Header at the start of every snapshot file
+ */
+typedef struct header_T {
+  char     magic[4];   ///< SNAPSHOT_MAGIC
+  uint16_t version;    ///< SNAPSHOT_VERSION
+  uint8_t  encoding;   ///< ENCODING_DELTA, ENCODING_BITMAP or ENCODING_ROWS
+  uint8_t  flags;      ///< FLAG_VALUES or 0
+  int32_t  height;     ///< height of the game, 0 if unlimited
+  int32_t  width;      ///< width of the game, 0 if unlimited
+  int32_t  mode;       ///< index of the game mode
+  uint32_t seed;       ///< seed of the random number generator
+  uint64_t generation; ///< generation at which the snapshot was taken
+  uint64_t count;      ///< number of living cells
+  uint64_t size;       ///< size of the encoded cells in bytes
+  int64_t  min_row;    ///< top row of the bounding box
+  int64_t  min_col;    ///< left column of the bounding box
+  uint64_t box_height; ///< height of the bounding box
+  uint64_t box_width;  ///< width of the bounding box
+} header_T;
+
+/**
+ * @brief A growing byte buffer used while encoding
+ */
+typedef struct bytes_T {
+  uint8_t *data;     ///< encoded bytes
+  size_t   size;     ///< number of bytes in the buffer
+  size_t   capacity; ///< number of bytes that fit in the buffer
+} bytes_T;
+
+/**
+ * @brief Make sure there is space for n more bytes in the buffer
+ */
+static void bytes_reserve(bytes_T *self, size_t n) {
+  if (self->size + n <= self->capacity)
+    return;
+
+  uint8_t *t;
+  self->capacity = MAX(self->capacity * 2, self->size + n);
+  MEM_CHECK(t = realloc(self->data, self->capacity));
+  self->data = t;
+}
+
+/**
+ * @brief Append the unsigned variable length integer to the buffer
+ */
+static void bytes_varint(bytes_T *self, uint64_t val) {
+  bytes_reserve(self, 10);
+  while (val >= 0x80) {
+    self->data[self->size++] = (val & 0x7F) | 0x80;
+    val >>= 7;
+  }
+  self->data[self->size++] = val;
+}
+
+/**
+ * @brief Read the unsigned variable length integer at *p, advancing the
+ * pointer. Never reads past end
+ */
+static uint64_t read_varint(const uint8_t **p, const uint8_t *end) {
+  uint64_t val = 0;
+  int      shift = 0;
+
+  while (*p < end) {
+    uint8_t b = *(*p)++;
+    val |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80))
+      break;
+    shift += 7;
+  }
+
+  return val;
+}
+
+/**
+ * @brief Return the position of the cell in the bounding box, counting in the
+ * row-major order
+ */
+static uint64_t box_index(const header_T *h, const coord_val *c) {
+  return (uint64_t)(c->row - h->min_row) * h->box_width + (c->col - h->min_col);
+}
+
+/**
+ * @brief Return the number of cells in the bounding box, 0 if it doesn't fit
+ * in 63 bits
+ */
+static uint64_t box_area(const header_T *h) {
+  if (h->box_width && h->box_height > (UINT64_MAX >> 1) / h->box_width)
+    return 0;
+  return h->box_height * h->box_width;
+}
+
+/**
+ * @brief Return the size of the bitmap of the bounding box in bytes
+ */
+static uint64_t box_bitmap(const header_T *h) { return (box_area(h) + 3) / 4; }
+
+/**
+ * @brief Sort the cells in the row-major order of the bounding box
+ *
+ * Stable counting sort is done on each 16 bit digit of the column and then of
+ * the row, skipping the digits that are zero for the whole bounding box.
+ */
+static void sort_cells(const header_T *h, coord_val *cells, size_t size) {
+  coord_val *tmp, *src = cells, *dst;
+  size_t    *count;
+
+  MEM_CHECK(tmp = malloc(size * sizeof(coord_val)));
+  MEM_CHECK(count = malloc(((size_t)1 << RADIX_BITS) * sizeof(size_t)));
+  dst = tmp;
+
+  for (int pass = 0; pass < 8; pass++) {
+    int      shift = (pass % 4) * RADIX_BITS, row = pass >= 4;
+    uint64_t range = row ? h->box_height - 1 : h->box_width - 1;
+
+    if (!(range >> shift))
+      continue;
+
+    memset(count, 0, ((size_t)1 << RADIX_BITS) * sizeof(size_t));
+    for (size_t i = 0; i < size; i++) {
+      uint64_t key = row ? (uint64_t)(src[i].row - h->min_row)
+                         : (uint64_t)(src[i].col - h->min_col);
+      count[(key >> shift) & 0xFFFF]++;
+    }
+
+    for (size_t i = 0, sum = 0; i < ((size_t)1 << RADIX_BITS); i++) {
+      size_t t = count[i];
+      count[i] = sum;
+      sum += t;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+      uint64_t key = row ? (uint64_t)(src[i].row - h->min_row)
+                         : (uint64_t)(src[i].col - h->min_col);
+      dst[count[(key >> shift) & 0xFFFF]++] = src[i];
+    }
+
+    coord_val *t = src;
+    src = dst;
+    dst = t;
+  }
+
+  if (src != cells)
+    memcpy(cells, src, size * sizeof(coord_val));
+
+  free(count);
+  free(tmp);
+}
+
+/**
+ * @brief Sort the keys, none of which is greater than max
+ *
+ * Stable counting sort is done on each digit of KEY_BITS, skipping the digits
+ * that are zero for every key. The keys are much smaller than the cells and
+ * their digits take fewer passes than the row and the column on their own.
+ */
+static void sort_keys(uint64_t *keys, size_t size, uint64_t max) {
+  uint64_t *tmp, *src = keys, *dst;
+  size_t    count[1 << KEY_BITS];
+
+  MEM_CHECK(tmp = malloc(size * sizeof(uint64_t)));
+  dst = tmp;
+
+  for (int shift = 0; shift < 64 && (max >> shift); shift += KEY_BITS) {
+    memset(count, 0, sizeof(count));
+    for (size_t i = 0; i < size; i++)
+      count[(src[i] >> shift) & ((1 << KEY_BITS) - 1)]++;
+
+    for (size_t i = 0, sum = 0; i < (1 << KEY_BITS); i++) {
+      size_t t = count[i];
+      count[i] = sum;
+      sum += t;
+    }
+
+    for (size_t i = 0; i < size; i++)
+      dst[count[(src[i] >> shift) & ((1 << KEY_BITS) - 1)]++] = src[i];
+
+    uint64_t *t = src;
+    src = dst;
+    dst = t;
+  }
+
+  if (src != keys)
+    memcpy(keys, src, size * sizeof(uint64_t));
+
+  free(tmp);
+}
+
+/**
+ * @brief Encode the cells as the distances between them
+ *
+ * Each cell is stored as the distance from the previous one in the row-major
+ * order of the bounding box, followed by its value if values are stored. The
+ * cells are sorted as keys of their position followed by their value.
+ */
+static void encode_delta(bytes_T *out, header_T *h, coord_val *cells,
+                         size_t size) {
+  uint64_t *keys, prev = 0;
+
+  MEM_CHECK(keys = malloc((size + 1) * sizeof(uint64_t)));
+  for (size_t i = 0; i < size; i++)
+    keys[i] = box_index(h, &cells[i]) << KEY_VALUE | cells[i].val;
+  sort_keys(keys, size, box_area(h) << KEY_VALUE);
+
+  for (size_t i = 0; i < size; i++) {
+    uint64_t n = keys[i] >> KEY_VALUE;
+
+    bytes_varint(out, n - prev);
+    if (h->flags & FLAG_VALUES) {
+      bytes_reserve(out, 1);
+      out->data[out->size++] = keys[i] & ((1 << KEY_VALUE) - 1);
+    }
+
+    prev = n;
+  }
+
+  free(keys);
+}
+
+/**
+ * @brief Encode sorted cells as the distance in rows from the previous one,
+ * followed by the distance in columns from the previous one in the same row,
+ * or from the left of the bounding box in a new row
+ */
+static void encode_rows(bytes_T *out, header_T *h, coord_val *cells,
+                        size_t size) {
+  int64_t prev_row = h->min_row, prev_col = h->min_col;
+
+  for (size_t i = 0; i < size; i++) {
+    uint64_t drow = cells[i].row - prev_row;
+
+    if (drow)
+      prev_col = h->min_col;
+
+    bytes_varint(out, drow);
+    bytes_varint(out, (uint64_t)(cells[i].col - prev_col));
+    if (h->flags & FLAG_VALUES) {
+      bytes_reserve(out, 1);
+      out->data[out->size++] = cells[i].val;
+    }
+
+    prev_row = cells[i].row;
+    prev_col = cells[i].col;
+  }
+}
+
+/**
+ * @brief Encode the cells as a bitmap of the bounding box, two bits per cell
+ */
+static void encode_bitmap(bytes_T *out, header_T *h, coord_val *cells,
+                          size_t size) {
+  size_t bytes = box_bitmap(h);
+
+  bytes_reserve(out, bytes);
+  memset(out->data, 0, bytes);
+  out->size = bytes;
+
+  for (size_t i = 0; i < size; i++) {
+    uint64_t n = box_index(h, &cells[i]);
+    out->data[n / 4] |= (cells[i].val & 3) << (n % 4 * 2);
+  }
+}
+
+/**
+ * @brief Write the snapshot of the game with given information and cells
+ *
+ * The bitmap is used without sorting the cells when it can't be larger than
+ * the distances, otherwise the cells are sorted and the smaller of the two
+ * encodings is used. The bitmap is only used if every value fits in two bits.
+ * Bounding boxes whose area doesn't fit in 56 bits, next to the value of a
+ * cell, are always stored as the distances in rows and columns, sorting the
+ * cells in place.
+ *
+ * Cells are encoded in memory and written in chunks of WRITE_CHUNK bytes.
+ * Progress, if not NULL, is called after each chunk with the share of the
+ * cells written so far.
+ */
+void snapshot_write(FILE *f, snapshot_T *info, coord_val *cells, size_t size,
+                    format_progress_f progress) {
+  header_T h = {SNAPSHOT_MAGIC};
+  bytes_T  out = {0};
+  int64_t  max_row = 0, max_col = 0;
+  int      max_val = 0;
+
+  h.version = SNAPSHOT_VERSION;
+  h.height = info->height;
+  h.width = info->width;
+  h.mode = info->mode;
+  h.seed = info->seed;
+  h.generation = info->generation;
+  h.count = size;
+
+  if (size) {
+    h.min_row = max_row = cells[0].row;
+    h.min_col = max_col = cells[0].col;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    h.min_row = MIN(h.min_row, cells[i].row);
+    h.min_col = MIN(h.min_col, cells[i].col);
+    max_row = MAX(max_row, cells[i].row);
+    max_col = MAX(max_col, cells[i].col);
+    max_val = MAX(max_val, cells[i].val);
+  }
+
+  h.box_height = size ? (uint64_t)max_row - h.min_row + 1 : 0;
+  h.box_width = size ? (uint64_t)max_col - h.min_col + 1 : 0;
+  h.flags = (max_val > 1) ? FLAG_VALUES : 0;
+
+  uint64_t bitmap = box_bitmap(&h);
+  uint64_t area = box_area(&h);
+  int      huge = size && (!area || area > UINT64_MAX >> KEY_VALUE);
+  int      dense = !huge && max_val <= 3 && bitmap <= size;
+
+  if (!dense) {
+    bytes_reserve(&out, size * ((h.flags & FLAG_VALUES) ? 2 : 1));
+    if (huge) {
+      h.encoding = ENCODING_ROWS;
+      sort_cells(&h, cells, size);
+      encode_rows(&out, &h, cells, size);
+    } else {
+      encode_delta(&out, &h, cells, size);
+      dense = max_val <= 3 && bitmap < out.size;
+    }
+  }
+
+  if (dense) {
+    out.size = 0;
+    h.encoding = ENCODING_BITMAP;
+    encode_bitmap(&out, &h, cells, size);
+  }
+
+  h.size = out.size;
+  fwrite(&h, sizeof(h), 1, f);
+  for (size_t i = 0; i < out.size; i += WRITE_CHUNK) {
+    size_t n = MIN(out.size - i, WRITE_CHUNK);
+
+    fwrite(out.data + i, 1, n, f);
+    if (progress)
+      progress((double)(i + n) / out.size * size);
+  }
+  free(out.data);
+}
+
+/**
+ * @brief Append the cell to the buffer, which has room for it unless the file
+ * holds more cells than its header says
+ */
+static void cell_put(cells_T *cells, int64_t row, int64_t col, int val) {
+  if (cells->size < cells->capacity)
+    cells->cells[cells->size++] = (coord_val){row, col, val};
+}
+
+/**
+ * @brief Decode the cells stored as the distances between them
+ */
+static void decode_delta(const header_T *h, const uint8_t *p, cells_T *cells) {
+  const uint8_t *end = p + h->size;
+  uint64_t       n = 0;
+
+  if (!h->box_width)
+    return;
+
+  while (p < end) {
+    n += read_varint(&p, end);
+
+    int val = (h->flags & FLAG_VALUES) ? (p < end ? *p++ : 0) : 1;
+    if (val)
+      cell_put(cells, h->min_row + n / h->box_width,
+               h->min_col + n % h->box_width, val);
+  }
+}
+
+/**
+ * @brief Decode the cells stored as the distances in rows and columns
+ */
+static void decode_rows(const header_T *h, const uint8_t *p, cells_T *cells) {
+  const uint8_t *end = p + h->size;
+  int64_t        row = h->min_row, col = h->min_col;
+
+  while (p < end) {
+    uint64_t drow = read_varint(&p, end);
+
+    if (drow)
+      col = h->min_col;
+    row += drow;
+    col += read_varint(&p, end);
+
+    int val = (h->flags & FLAG_VALUES) ? (p < end ? *p++ : 0) : 1;
+    if (val)
+      cell_put(cells, row, col, val);
+  }
+}
+
+/**
+ * @brief Decode the cells stored as a bitmap of the bounding box
+ *
+ * Empty runs of the bitmap are skipped eight bytes, 32 cells, at a time, and
+ * the position of the first cell of a byte is the only division done.
+ */
+static void decode_bitmap(const header_T *h, const uint8_t *p,
+                          cells_T *cells) {
+  uint64_t bytes = box_bitmap(h), width = h->box_width;
+
+  for (uint64_t b = 0; b < bytes; b++) {
+    uint64_t word;
+
+    if (b % 8 == 0 && b + 8 <= bytes) {
+      memcpy(&word, p + b, sizeof(word));
+      if (!word) {
+        b += 7;
+        continue;
+      }
+    }
+
+    if (!p[b])
+      continue;
+
+    uint64_t n = b * 4, row = n / width, col = n % width;
+    for (int k = 0; k < 4; k++) {
+      int val = (p[b] >> (k * 2)) & 3;
+
+      // the last byte is padded with empty cells past the bounding box, the
+      // cell is always written and kept only if it's alive, to avoid a branch
+      if (cells->size == cells->capacity)
+        return;
+      cells->cells[cells->size] =
+          (coord_val){h->min_row + row, h->min_col + col, val};
+      cells->size += val != 0;
+      if (++col == width) {
+        col = 0;
+        row++;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Read the snapshot from the file with name, filling info and
+ * appending its living cells to cells. Return 0 if the file is not a valid
+ * snapshot
+ *
+ * The file is mapped into memory and the cells are decoded directly from the
+ * mapping into the buffer, which is grown only once, to the number of cells in
+ * the header.
+ */
+int snapshot_read(char *name, snapshot_T *info, cells_T *cells) {
+  struct stat    st;
+  const uint8_t *data;
+  header_T       h;
+  uint64_t       count;
+  int            valid;
+
+#ifdef _WIN32
+  FILE *f;
+  if (stat(name, &st) != 0 || (f = fopen(name, "rb")) == NULL)
+    return 0;
+
+  uint8_t *buffer;
+  MEM_CHECK(buffer = malloc(st.st_size + 1));
+  st.st_size = fread(buffer, 1, st.st_size, f);
+  fclose(f);
+  if (st.st_size < sizeof(header_T)) {
+    free(buffer);
+    return 0;
+  }
+  data = buffer;
+#else
+  int fd = open(name, O_RDONLY);
+  if (fd < 0)
+    return 0;
+
+  if (fstat(fd, &st) != 0 || st.st_size < sizeof(header_T)) {
+    close(fd);
+    return 0;
+  }
+
+  data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return 0;
+
+  madvise((void *)data, st.st_size, MADV_SEQUENTIAL);
+#endif
+
+  memcpy(&h, data, sizeof(h));
+
+  valid = !memcmp(h.magic, SNAPSHOT_MAGIC, 4) &&
+          h.version == SNAPSHOT_VERSION &&
+          h.size <= st.st_size - sizeof(header_T) &&
+          h.mode >= 0 && h.mode < evolution_size && h.height >= 0 &&
+          h.width >= 0;
+
+  // each cell takes at least a byte, or a quarter of a byte in the bitmap
+  count = h.encoding == ENCODING_BITMAP ? MIN(h.count, h.size * 4)
+                                        : MIN(h.count, h.size);
+  if (h.encoding == ENCODING_BITMAP)
+    valid &= h.size >= box_bitmap(&h);
+  valid &= count <= (uint64_t)(INT_MAX - cells->size - 1);
+
+  if (valid) {
+    coord_val *t;
+
+    info->height = h.height;
+    info->width = h.width;
+    info->mode = h.mode;
+    info->seed = h.seed;
+    info->generation = h.generation;
+
+    MEM_CHECK(t = realloc(cells->cells,
+                          (cells->size + count + 1) * sizeof(coord_val)));
+    cells->cells = t;
+    cells->capacity = cells->size + count;
+
+    if (h.encoding == ENCODING_BITMAP)
+      decode_bitmap(&h, data + sizeof(header_T), cells);
+    else if (h.encoding == ENCODING_ROWS)
+      decode_rows(&h, data + sizeof(header_T), cells);
+    else
+      decode_delta(&h, data + sizeof(header_T), cells);
+  }
+
+#ifdef _WIN32
+  free(buffer);
+#else
+  munmap((void *)data, st.st_size);
+#endif
+
+  return valid;
+}
@@ -175,8 +175,8 @@ void window_unsplit(T self) {
  */
 void window_calc_children(T self) {
   T c1, c2, f, nf;
-  c1 = self->c1;
-  c2 = self->c2;
+  c1 = f = self->c1;
+  c2 = nf = self->c2;
   int fixed = 0, *fv;
   int hor = self->mod[0], a = self->mod[1], b = self->mod[2];
 